@@ -1,9 +1,55 @@
 #include "mesh_compute.h"
 #include "mesh_draw.h"
+#include "mesh_batch.h"
+#include "mesh_raster.h"
+#include "mesh_tile.h"
+
+int main(int argc, char* argv[]) {
+    // Headless Monte-Carlo sweep, see mesh_batch_usage()
+    if (argc > 1 && strcmp(argv[1], "--batch") == 0) {
+        mesh_batch_sweep sweep;
+        const char* filename;
+        if (mesh_batch_parse(&sweep, &filename, argc - 2, argv + 2) != 0) {
+            mesh_batch_usage(argv[0]);
+            return 1;
+        }
+        return mesh_batch_run(&sweep, filename) < 0 ? 1 : 0;
+    }
+
+    // Headless multi-process run over strips of the area, see mesh_tile_run(), Gabriel links on a wider area unless told otherwise
+    if (argc > 1 && strcmp(argv[1], "--tiled") == 0) {
+        mesh_config config;
+        mesh_config_defaults(&config);
+        config.topology = MESH_TOPOLOGY_GABRIEL;
+        config.node_count = MESH_TILE_NODES_COUNT;
+        config.size_x = MESH_TILE_SIZE_X;
+        config.size_y = MESH_TILE_SIZE_Y;
+        if (mesh_config_parse(&config, argc - 2, argv + 2) != 0) {
+            return 1;
+        }
+        return mesh_tile_run(&config, MESH_TILE_OUTPUT) < 0 ? 1 : 0;
+    }
+
+    // Headless playback, `--frames OUTPUT` records the simulation instead of opening a window, see mesh_raster_play()
+    const char* frames = NULL;
+    int first_option = 1;
+    if (argc > 2 && strcmp(argv[1], "--frames") == 0) {
+        frames = argv[2];
+        first_option = 3;
+    }
+
+    // Parameters from `--key value` options and `--config FILE`, see mesh_config.h
+    mesh_config config;
+    mesh_config_defaults(&config);
+    if (mesh_config_parse(&config, argc - first_option, argv + first_option) != 0) {
+        return 1;
+    }
 
-int main() {
     // Initialize mesh
-    mesh* my_mesh = init_mesh("TestMesh");
+    mesh* my_mesh = init_mesh("TestMesh", &config);
+    if (!my_mesh) {
+        return 1;
+    }
 
     /*printf(" size of struct mesh: %lu bytes\n", sizeof(mesh));
     printf(" size of struct mesh_node: %lu bytes\n", sizeof(mesh_node));
@@ -14,21 +60,26 @@ int main() {
 
 
 
-    for (int i = 0; i < my_mesh->node_count - 2; i++) {
-        // Create links between nodes
-        if (mesh_link_allowed(&my_mesh->nodes[i], &my_mesh->nodes[i + 1])) {
-            my_mesh->link_count++;
-            init_mesh_link(my_mesh->link_count - 1, &my_mesh->nodes[i], &my_mesh->nodes[i + 1]);
-        }
-        if (mesh_link_allowed(&my_mesh->nodes[i], &my_mesh->nodes[i + 2])) {
-            my_mesh->link_count++;
-            init_mesh_link(my_mesh->link_count - 1, &my_mesh->nodes[i], &my_mesh->nodes[i + 2]);
-        }
-    } 
+    // Create links between nodes, the chain of the earlier versions unless --topology picks a graph
+    if (mesh_build_topology(my_mesh, config.topology, config.topology_neighbors) < 0) {
+        free_mesh(my_mesh);
+        return 1;
+    }
+
+    // Route from the first to the last node
+    mesh_add_path(my_mesh, 0, my_mesh->node_count - 1, METRIC_LATENCY);
     
     // Save mesh data to CSV
     MESH_SAVEDUMP(my_mesh, ALL);
 
+    // Simulate gateway traffic, statistics go to mesh_sim.csv
+    if (frames) {
+        long written = compute_mesh_frames(my_mesh, frames);
+        free_mesh(my_mesh);
+        return written < 0 ? 1 : 0;
+    }
+    compute_mesh(my_mesh);
+
     mesh_debug_print_mesh(my_mesh);
 
     // Initialize SDL
@@ -0,0 +1,108 @@
+#include <stdlib.h>
+#include <string.h>
+#include "mesh_arena.h"
+
+#define MESH_ARENA_ALIGN 16
+
+struct mesh_arena_block{
+    mesh_arena_block* next;     /// Next block of the chain
+    size_t size;                /// Usable bytes of the block
+    size_t used;                /// Bytes already handed out
+    _Alignas(MESH_ARENA_ALIGN) char data[]; /// Block memory
+};
+
+static size_t arena_align(size_t size) {
+    return (size + MESH_ARENA_ALIGN - 1) & ~(size_t)(MESH_ARENA_ALIGN - 1);
+}
+
+static mesh_arena_block* arena_new_block(size_t size) {
+    mesh_arena_block* b = (mesh_arena_block*)malloc(sizeof(mesh_arena_block) + size);
+    if (!b) {
+        return NULL;
+    }
+    b->next = NULL;
+    b->size = size;
+    b->used = 0;
+    return b;
+}
+
+int mesh_arena_init(mesh_arena* a, size_t size) {
+    a->first = arena_new_block(arena_align(size));
+    a->current = a->first;
+    a->reserved = a->first ? a->first->size : 0;
+    a->last = NULL;
+    return a->first ? 0 : -1;
+}
+
+void* mesh_arena_alloc(mesh_arena* a, size_t size) {
+    size = arena_align(size);
+    mesh_arena_block* b = a->current;
+    // Move to the next block kept by a rewind, or chain a new one after the current block
+    while (b->size - b->used < size) {
+        if (b->next && b->next->size >= size) {
+            b = b->next;
+            b->used = 0;
+            continue;
+        }
+        // Double the reserved memory so large meshes need few blocks
+        size_t block_size = a->reserved > size ? a->reserved : size;
+        mesh_arena_block* nb = arena_new_block(block_size);
+        if (!nb) {
+            return NULL;
+        }
+        nb->next = b->next;
+        b->next = nb;
+        a->reserved += block_size;
+        b = nb;
+    }
+    a->current = b;
+    void* ptr = b->data + b->used;
+    b->used += size;
+    a->last = ptr;
+    return ptr;
+}
+
+void* mesh_arena_calloc(mesh_arena* a, size_t size) {
+    void* ptr = mesh_arena_alloc(a, size);
+    if (ptr) {
+        memset(ptr, 0, size);
+    }
+    return ptr;
+}
+
+void* mesh_arena_realloc(mesh_arena* a, void* ptr, size_t old_size, size_t new_size) {
+    if (ptr && ptr == a->last) {
+        mesh_arena_block* b = a->current;
+        size_t offset = (size_t)((char*)ptr - b->data);
+        if (offset + arena_align(new_size) <= b->size) {
+            b->used = offset + arena_align(new_size);
+            return ptr;
+        }
+    }
+    void* grown = mesh_arena_alloc(a, new_size);
+    if (grown && ptr) {
+        memcpy(grown, ptr, old_size < new_size ? old_size : new_size);
+    }
+    return grown;
+}
+
+mesh_arena_mark mesh_arena_save(mesh_arena* a) {
+    mesh_arena_mark mark = { a->current, a->current->used };
+    return mark;
+}
+
+void mesh_arena_rewind(mesh_arena* a, mesh_arena_mark mark) {
+    a->current = mark.block;
+    a->current->used = mark.used;
+    a->last = NULL;
+}
+
+void mesh_arena_release(mesh_arena* a) {
+    mesh_arena_block* b = a->first;
+    // The arena may live inside its own first block, do not touch it afterwards
+    while (b) {
+        mesh_arena_block* next = b->next;
+        free(b);
+        b = next;
+    }
+}
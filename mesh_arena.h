@@ -0,0 +1,66 @@
+#pragma once
+
+#include <stddef.h>
+
+typedef struct mesh_arena_block mesh_arena_block;
+
+typedef struct mesh_arena mesh_arena;
+
+typedef struct mesh_arena_mark mesh_arena_mark;
+
+
+/// @brief Bump allocator made of chained blocks. Allocations are never freed one
+/// by one, the whole arena is rewound or released at once.
+struct mesh_arena{
+    mesh_arena_block* first;    /// First block of the chain
+    mesh_arena_block* current;  /// Block allocations are served from
+    size_t reserved;            /// Total bytes reserved by all blocks
+    void* last;                 /// Last allocation, the only one that can grow in place
+};
+
+/// @brief Position in an arena that can be rewound to.
+struct mesh_arena_mark{
+    mesh_arena_block* block;    /// Block that was current
+    size_t used;                /// Bytes used in that block
+};
+
+
+///@brief Initializes an empty arena.
+///@param a A pointer to the arena to initialize.
+///@param size The size of the first block in bytes.
+///@return int 0 on success, -1 on allocation failure.
+int mesh_arena_init(mesh_arena* a, size_t size);
+
+///@brief Allocates aligned memory from the arena.
+///@param a A pointer to the arena.
+///@param size The number of bytes to allocate.
+///@return void* The allocated memory, or NULL on allocation failure.
+void* mesh_arena_alloc(mesh_arena* a, size_t size);
+
+///@brief Allocates zeroed memory from the arena.
+///@param a A pointer to the arena.
+///@param size The number of bytes to allocate.
+///@return void* The allocated memory, or NULL on allocation failure.
+void* mesh_arena_calloc(mesh_arena* a, size_t size);
+
+///@brief Grows an allocation, in place when it is the last one of the arena.
+///@param a A pointer to the arena.
+///@param ptr The allocation to grow, may be NULL.
+///@param old_size The current size of the allocation.
+///@param new_size The requested size.
+///@return void* The grown allocation, or NULL on allocation failure (ptr stays valid).
+void* mesh_arena_realloc(mesh_arena* a, void* ptr, size_t old_size, size_t new_size);
+
+///@brief Returns the current position of the arena.
+///@param a A pointer to the arena.
+///@return mesh_arena_mark The position to give to mesh_arena_rewind().
+mesh_arena_mark mesh_arena_save(mesh_arena* a);
+
+///@brief Discards every allocation made after a mark, keeping the blocks for reuse.
+///@param a A pointer to the arena.
+///@param mark A position returned by mesh_arena_save().
+void mesh_arena_rewind(mesh_arena* a, mesh_arena_mark mark);
+
+///@brief Frees every block of the arena.
+///@param a A pointer to the arena. Memory holding the arena itself may be released by this call.
+void mesh_arena_release(mesh_arena* a);
@@ -0,0 +1,342 @@
+#include <limits.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include "mesh_compute.h"
+#include "mesh_parallel.h"
+#include "mesh_batch.h"
+
+typedef struct batch_worker {
+    mesh* m;                    /// Mesh reused by the runs of one point, NULL before the first run
+    int point;                  /// Point the mesh was built for, -1 before the first run
+} batch_worker;
+
+typedef struct batch_job {
+    const mesh_batch_sweep* sweep;
+    batch_worker* workers;      /// One per worker
+    mesh_batch_sample* samples; /// One per run, runs of a point are consecutive
+    atomic_int* remaining;      /// Runs not finished yet of each point
+    atomic_int failed;          /// Number of runs that could not allocate their mesh
+    int point_count;            /// Number of points of the sweep
+    int next_point;             /// First point not written yet, guarded by lock
+    pthread_mutex_t lock;       /// Serializes the writes to file
+    FILE* file;
+} batch_job;
+
+typedef struct batch_stat {
+    int count;
+    double sum;
+    double sum_sq;
+    double min;
+    double max;
+} batch_stat;
+
+void mesh_batch_defaults(mesh_batch_sweep* sweep) {
+    memset(sweep, 0, sizeof(*sweep));
+    mesh_config_defaults(&sweep->config);
+    sweep->config.topology = MESH_TOPOLOGY_CAPPED_DISK; // The random geometric graph, not the test chain of main.c
+    sweep->nodes[0] = sweep->config.node_count;
+    sweep->node_values = 1;
+    sweep->size_x[0] = sweep->config.size_x;
+    sweep->size_y[0] = sweep->config.size_y;
+    sweep->area_values = 1;
+    sweep->distance[0] = sweep->config.max_link_distance;
+    sweep->distance_values = 1;
+    sweep->first_seed = 0;
+    sweep->seed_count = 100;
+    sweep->diameter = true;
+    sweep->threads = MESH_THREADS;
+}
+
+// Comma separated list of positive numbers, "WxH" pairs when second is not NULL
+static int batch_parse_list(const char* text, float* first, float* second, int* count) {
+    *count = 0;
+    while (*text) {
+        if (*count == MESH_BATCH_MAX_VALUES) {
+            return -1;
+        }
+        char* end;
+        first[*count] = strtof(text, &end);
+        if (end == text || first[*count] <= 0.0f) {
+            return -1;
+        }
+        text = end;
+        if (second) {
+            if (*text != 'x') {
+                return -1;
+            }
+            second[*count] = strtof(text + 1, &end);
+            if (end == text + 1 || second[*count] <= 0.0f) {
+                return -1;
+            }
+            text = end;
+        }
+        (*count)++;
+        if (*text == ',') text++;
+        else if (*text) return -1;
+    }
+    return *count > 0 ? 0 : -1;
+}
+
+int mesh_batch_parse(mesh_batch_sweep* sweep, const char** filename, int argc, char* argv[]) {
+    mesh_batch_defaults(sweep);
+    *filename = MESH_BATCH_OUTPUT;
+    bool nodes_given = false, area_given = false, distance_given = false;
+    for (int i = 0; i < argc; i++) {
+        const char* arg = argv[i];
+        const char* value = i + 1 < argc ? argv[i + 1] : NULL;
+        if (strcmp(arg, "--no-diameter") == 0) {
+            sweep->diameter = false;
+            continue;
+        }
+        if (strchr(arg, '=')) {
+            if (mesh_config_parse(&sweep->config, 1, argv + i) != 0) return -1;
+            continue;
+        }
+        if (!value) {
+            return -1;
+        }
+        i++;
+        if (strcmp(arg, "--nodes") == 0) {
+            nodes_given = true;
+            float nodes[MESH_BATCH_MAX_VALUES];
+            if (batch_parse_list(value, nodes, NULL, &sweep->node_values) != 0) return -1;
+            for (int v = 0; v < sweep->node_values; v++) {
+                if (nodes[v] < 2.0f || nodes[v] > (float)INT_MAX) return -1;
+                sweep->nodes[v] = (int)nodes[v];
+            }
+        } else if (strcmp(arg, "--area") == 0) {
+            area_given = true;
+            if (batch_parse_list(value, sweep->size_x, sweep->size_y, &sweep->area_values) != 0) return -1;
+        } else if (strcmp(arg, "--distance") == 0) {
+            distance_given = true;
+            if (batch_parse_list(value, sweep->distance, NULL, &sweep->distance_values) != 0) return -1;
+        } else if (strcmp(arg, "--seeds") == 0) {
+            char* end;
+            unsigned long long first = strtoull(value, &end, 10);
+            unsigned long long last = first;
+            if (end == value) return -1;
+            if (*end == '-') {
+                const char* text = end + 1;
+                last = strtoull(text, &end, 10);
+                if (end == text) return -1;
+            }
+            if (*end || last < first || last - first >= INT_MAX) return -1;
+            sweep->first_seed = first;
+            sweep->seed_count = (int)(last - first + 1);
+        } else if (strcmp(arg, "--threads") == 0) {
+            sweep->threads = atoi(value);
+        } else if (strcmp(arg, "--out") == 0) {
+            *filename = value;
+        } else if (mesh_config_parse(&sweep->config, 2, argv + i - 1) != 0) {
+            return -1;
+        }
+    }
+    // Without a sweep of its own, a swept parameter takes the single value of the configuration
+    if (!nodes_given) sweep->nodes[0] = sweep->config.node_count;
+    if (!area_given) {
+        sweep->size_x[0] = sweep->config.size_x;
+        sweep->size_y[0] = sweep->config.size_y;
+    }
+    if (!distance_given) sweep->distance[0] = sweep->config.max_link_distance;
+    return 0;
+}
+
+void mesh_batch_usage(const char* program) {
+    fprintf(stderr,
+            "usage: %s --batch [--nodes N,..] [--area WxH,..] [--distance D,..] [--seeds FIRST-LAST]\n"
+            "          [--threads T] [--no-diameter] [--out FILE] [--config FILE] [--KEY VALUE]..\n"
+            "  --nodes        node counts of the sweep (default %d)\n"
+            "  --area         areas of the sweep in meters (default %gx%g)\n"
+            "  --distance     max link distances in meters (default %g)\n"
+            "  --seeds        one mesh per seed at every point (default 0-99)\n"
+            "  --threads      workers, 0 for every online core (default %d)\n"
+            "  --no-diameter  skip the hop diameter, the most expensive statistic\n"
+            "  --out          CSV file, one line per point (default %s)\n"
+            "  --config, --KEY parameters of every mesh, KEY being a field of mesh_config such as\n"
+            "                 --distribution clustered or --max-output-links 3. --node-count, --size-x, --size-y\n"
+            "                 and --max-link-distance give the single value of a sweep without --nodes,\n"
+            "                 --area or --distance. Meshes are linked with --topology, capped_disk by default\n",
+            program, MESH_NODES_COUNT, MESH_SIZE_X, MESH_SIZE_Y, MESH_MAX_LINK_DISTANCE, MESH_THREADS, MESH_BATCH_OUTPUT);
+}
+
+// Parameters of the meshes of a point: the base configuration with the swept values of the point
+static void batch_point_config(const mesh_batch_sweep* sweep, int point, mesh_config* config) {
+    int d = point % sweep->distance_values;
+    int a = point / sweep->distance_values % sweep->area_values;
+    int n = point / sweep->distance_values / sweep->area_values;
+    *config = sweep->config;
+    config->node_count = sweep->nodes[n];
+    config->size_x = sweep->size_x[a];
+    config->size_y = sweep->size_y[a];
+    config->max_link_distance = sweep->distance[d];
+    config->threads = 1; // The batch is already spread over the workers
+}
+
+static void batch_stat_add(batch_stat* s, double v) {
+    if (s->count == 0 || v < s->min) s->min = v;
+    if (s->count == 0 || v > s->max) s->max = v;
+    s->count++;
+    s->sum += v;
+    s->sum_sq += v * v;
+}
+
+// mean, sample standard deviation, min, max
+static void batch_stat_print(FILE* file, const batch_stat* s) {
+    if (s->count == 0) {
+        fprintf(file, ",,,,");
+        return;
+    }
+    double mean = s->sum / s->count;
+    double var = s->count > 1 ? (s->sum_sq - s->sum * mean) / (s->count - 1) : 0.0;
+    fprintf(file, ",%.4f,%.4f,%g,%g", mean, var > 0.0 ? sqrt(var) : 0.0, s->min, s->max);
+}
+
+// Samples are read in seed order so the line is the same whatever the thread count
+static void batch_write_point(batch_job* job, int point) {
+    const mesh_batch_sweep* sweep = job->sweep;
+    const mesh_batch_sample* samples = job->samples + (size_t)point * sweep->seed_count;
+    batch_stat links = {0}, components = {0}, largest = {0}, diameter = {0};
+    int runs = 0, connected = 0, strongly_connected = 0;
+    for (int s = 0; s < sweep->seed_count; s++) {
+        const mesh_batch_sample* sample = &samples[s];
+        if (sample->links < 0) continue;
+        runs++;
+        connected += sample->components == 1;
+        strongly_connected += sample->strong_components == 1;
+        batch_stat_add(&links, sample->links);
+        batch_stat_add(&components, sample->components);
+        batch_stat_add(&largest, sample->largest);
+        if (sample->diameter >= 0) batch_stat_add(&diameter, sample->diameter);
+    }
+
+    mesh_config config;
+    batch_point_config(sweep, point, &config);
+    fprintf(job->file, "%d,%d,%g,%g,%g,%d,%.4f,%.4f", point, config.node_count, config.size_x, config.size_y, config.max_link_distance, runs,
+            runs ? (double)connected / runs : 0.0, runs ? (double)strongly_connected / runs : 0.0);
+    batch_stat_print(job->file, &links);
+    batch_stat_print(job->file, &components);
+    batch_stat_print(job->file, &largest);
+    batch_stat_print(job->file, &diameter);
+    fputc('\n', job->file);
+}
+
+// Writes every finished point that follows the last written one
+static void batch_flush(batch_job* job) {
+    pthread_mutex_lock(&job->lock);
+    int written = job->next_point;
+    while (job->next_point < job->point_count && atomic_load(&job->remaining[job->next_point]) == 0) {
+        batch_write_point(job, job->next_point++);
+    }
+    if (job->next_point != written) fflush(job->file);
+    pthread_mutex_unlock(&job->lock);
+}
+
+static int batch_measure(batch_job* job, batch_worker* w, int run, mesh_batch_sample* sample) {
+    const mesh_batch_sweep* sweep = job->sweep;
+    int point = run / sweep->seed_count;
+
+    // The mesh of the previous run is reused as long as the point does not change
+    if (w->point != point) {
+        mesh_config config;
+        batch_point_config(sweep, point, &config);
+        if (w->m) free_mesh(w->m);
+        w->m = init_mesh("BatchMesh", &config);
+        w->point = point;
+    }
+    mesh* m = w->m;
+    if (!m) {
+        return -1;
+    }
+    m->seed = sweep->first_seed + (uint64_t)(run % sweep->seed_count);
+    if (reset_mesh(m) != 0) {
+        return -1;
+    }
+
+    if (mesh_build_topology(m, m->config.topology, m->config.topology_neighbors) < 0) {
+        return -1;
+    }
+
+    sample->links = m->link_count;
+    sample->components = mesh_component_count(m);
+    sample->largest = m->components.largest;
+    sample->strong_components = mesh_scc_label(m);
+    sample->diameter = sweep->diameter ? max_length_path_abs_bounded(m) : -1;
+    return 0;
+}
+
+static void batch_range(void* ctx, int worker, int begin, int end) {
+    batch_job* job = (batch_job*)ctx;
+    for (int run = begin; run < end; run++) {
+        mesh_batch_sample* sample = &job->samples[run];
+        if (batch_measure(job, &job->workers[worker], run, sample) != 0) {
+            sample->links = -1;
+            atomic_fetch_add(&job->failed, 1);
+        }
+        if (atomic_fetch_sub(&job->remaining[run / job->sweep->seed_count], 1) == 1) {
+            batch_flush(job);
+        }
+    }
+}
+
+int mesh_batch_run(const mesh_batch_sweep* sweep, const char* filename) {
+    if (sweep->node_values < 1 || sweep->area_values < 1 || sweep->distance_values < 1 || sweep->seed_count < 1) {
+        return -1;
+    }
+    long long points = (long long)sweep->node_values * sweep->area_values * sweep->distance_values;
+    if (points * sweep->seed_count > INT_MAX) {
+        return -1;
+    }
+    int runs = (int)(points * sweep->seed_count);
+    FILE* file = fopen(filename, "w");
+    if (!file) {
+        return -1;
+    }
+    fprintf(file, "point,nodes,size_x,size_y,distance,runs,connected,strongly_connected");
+    const char* stats[] = { "links", "components", "largest", "diameter" };
+    for (int s = 0; s < 4; s++) {
+        fprintf(file, ",%s_mean,%s_sd,%s_min,%s_max", stats[s], stats[s], stats[s], stats[s]);
+    }
+    fputc('\n', file);
+
+    int threads = mesh_thread_count(sweep->threads);
+    batch_job job;
+    job.sweep = sweep;
+    job.workers = (batch_worker*)calloc((size_t)threads, sizeof(batch_worker));
+    job.samples = (mesh_batch_sample*)malloc(sizeof(mesh_batch_sample) * (size_t)runs);
+    job.remaining = (atomic_int*)malloc(sizeof(atomic_int) * (size_t)points);
+    if (!job.workers || !job.samples || !job.remaining) {
+        free(job.workers);
+        free(job.samples);
+        free(job.remaining);
+        fclose(file);
+        return -1;
+    }
+    for (int w = 0; w < threads; w++) {
+        job.workers[w].point = -1;
+    }
+    for (int p = 0; p < points; p++) {
+        atomic_init(&job.remaining[p], sweep->seed_count);
+    }
+    atomic_init(&job.failed, 0);
+    job.point_count = (int)points;
+    job.next_point = 0;
+    pthread_mutex_init(&job.lock, NULL);
+    job.file = file;
+
+    // Runs are handed out one at a time: a mesh is enough work to hide the shared counter,
+    // and the runs of a point are consecutive so a worker seldom has to rebuild its mesh
+    mesh_parallel_for(runs, 1, threads, batch_range, &job);
+
+    for (int w = 0; w < threads; w++) {
+        if (job.workers[w].m) free_mesh(job.workers[w].m);
+    }
+    pthread_mutex_destroy(&job.lock);
+    int failed = atomic_load(&job.failed);
+    free(job.workers);
+    free(job.samples);
+    free(job.remaining);
+    if (fclose(file) != 0 || failed > 0) {
+        return -1;
+    }
+    return runs;
+}
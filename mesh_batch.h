@@ -0,0 +1,67 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "mesh_settings.h"
+#include "mesh_config.h"
+
+#define MESH_BATCH_MAX_VALUES 32 // values listed per swept parameter
+
+typedef struct mesh_batch_sweep mesh_batch_sweep;
+
+typedef struct mesh_batch_sample mesh_batch_sample;
+
+
+/// @brief Parameter sweep of a batch. Every combination of node count, area and link distance
+/// is a point of the sweep, and every point is measured on one random mesh per seed.
+struct mesh_batch_sweep{
+    int nodes[MESH_BATCH_MAX_VALUES];           /// Node counts
+    int node_values;                            /// Number of node counts
+    float size_x[MESH_BATCH_MAX_VALUES];        /// Widths of the areas in meters
+    float size_y[MESH_BATCH_MAX_VALUES];        /// Heights of the areas in meters
+    int area_values;                            /// Number of areas
+    float distance[MESH_BATCH_MAX_VALUES];      /// Max link distances in meters
+    int distance_values;                        /// Number of link distances
+    uint64_t first_seed;                        /// Seed of the first mesh of every point
+    int seed_count;                             /// Number of meshes per point, seeds first_seed to first_seed + seed_count - 1
+    mesh_config config;                         /// Parameters of every mesh, the swept ones excepted
+    bool diameter;                              /// Measure the hop diameter, by far the most expensive statistic
+    int threads;                                /// Number of workers, 0 to use every online core
+};
+
+/// @brief Statistics of one mesh of a batch.
+struct mesh_batch_sample{
+    int links;                  /// Number of links formed
+    int components;             /// Number of weak components
+    int largest;                /// Number of nodes of the largest weak component
+    int strong_components;      /// Number of strongly connected components, -1 on allocation failure
+    int diameter;               /// Hop diameter, -1 when not measured or on allocation failure
+};
+
+
+///@brief Fills a sweep with the defaults of mesh_config_defaults(), linked as a capped_disk topology: one point and seeds 0 to 99.
+///@param sweep The sweep to fill.
+void mesh_batch_defaults(mesh_batch_sweep* sweep);
+
+///@brief Reads a sweep from command line options, see mesh_batch_usage().
+/// Other options set the mesh parameters as mesh_config_parse() does, the node count, area and max link distance
+/// being the single value of their sweep when --nodes, --area or --distance is not given.
+///@param sweep The sweep to fill, mesh_batch_defaults() is applied first.
+///@param filename Receives the output path given with --out, MESH_BATCH_OUTPUT otherwise.
+///@param argc The number of options.
+///@param argv The options, without the program name.
+///@return int 0 on success, -1 on an unknown option or a bad value.
+int mesh_batch_parse(mesh_batch_sweep* sweep, const char** filename, int argc, char* argv[]);
+
+///@brief Prints the options of mesh_batch_parse() to stderr.
+///@param program The name of the program.
+void mesh_batch_usage(const char* program);
+
+///@brief Builds and measures one random mesh per point and seed on a pool of workers, and streams
+/// one CSV line of aggregated statistics per point, in point order, as soon as its meshes are done.
+/// Every worker keeps its mesh and buffers from one run to the next and only rebuilds them when the
+/// point changes. Each mesh is placed from its own seed so the output does not depend on the thread count.
+///@param sweep The parameter sweep.
+///@param filename The path of the CSV file.
+///@return int The number of meshes measured, -1 on failure.
+int mesh_batch_run(const mesh_batch_sweep* sweep, const char* filename);
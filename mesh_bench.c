@@ -0,0 +1,381 @@
+// Scaling benchmark of mesh construction, queries and dumps.
+// Build with `make bench`, then run `./mesh_bench [options]`, see usage() for the options.
+// Every result is one line of CSV (or JSON with --json) on stdout so two runs can be diffed.
+
+#include <stdint.h>
+#include <time.h>
+#include <sys/resource.h>
+#include "mesh_compute.h"
+#include "mesh_snapshot.h"
+
+#define BENCH_MIN_NODES 1000
+#define BENCH_MAX_NODES 10000000
+#define BENCH_QUERIES 1000
+#define BENCH_BUDGET 20000000L // node visits allowed per traversal query phase
+#define BENCH_SWEEP_MAX 10000  // largest mesh the all-pairs diameter and betweenness are measured on
+#define BENCH_SEED 1
+
+typedef struct bench_options {
+    int min_nodes;
+    int max_nodes;
+    int queries;
+    long budget;
+    int sweep_max;
+    unsigned int seed;
+    mesh_distribution distribution;
+    bool json;
+    const char* dump;
+} bench_options;
+
+typedef struct bench_phase {
+    struct timespec start;
+    long allocs;
+    long alloc_bytes;
+} bench_phase;
+
+
+// Allocation counters, fed by the linker wraps `make bench` sets up.
+// Only the calls made by the mesh code are seen, not the ones inside the C library.
+static long bench_allocs;
+static long bench_alloc_bytes;
+
+#ifdef MESH_BENCH_WRAP_MALLOC
+void* __real_malloc(size_t size);
+void* __real_calloc(size_t count, size_t size);
+void* __real_realloc(void* ptr, size_t size);
+
+void* __wrap_malloc(size_t size) {
+    __atomic_fetch_add(&bench_allocs, 1, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&bench_alloc_bytes, (long)size, __ATOMIC_RELAXED);
+    return __real_malloc(size);
+}
+
+void* __wrap_calloc(size_t count, size_t size) {
+    __atomic_fetch_add(&bench_allocs, 1, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&bench_alloc_bytes, (long)(count * size), __ATOMIC_RELAXED);
+    return __real_calloc(count, size);
+}
+
+void* __wrap_realloc(void* ptr, size_t size) {
+    __atomic_fetch_add(&bench_allocs, 1, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&bench_alloc_bytes, (long)size, __ATOMIC_RELAXED);
+    return __real_realloc(ptr, size);
+}
+#define BENCH_COUNTS_ALLOCS true
+#else
+#define BENCH_COUNTS_ALLOCS false
+#endif
+
+
+// Peak RSS since the last reset, in kB. Linux resets the high-water mark through
+// clear_refs, elsewhere the process peak from getrusage is reported instead.
+static void bench_reset_peak_rss(void) {
+    FILE* file = fopen("/proc/self/clear_refs", "w");
+    if (file) {
+        fputs("5", file);
+        fclose(file);
+    }
+}
+
+static long bench_peak_rss(void) {
+    FILE* file = fopen("/proc/self/status", "r");
+    if (file) {
+        char line[256];
+        long kb = -1;
+        while (fgets(line, sizeof(line), file)) {
+            if (sscanf(line, "VmHWM: %ld", &kb) == 1) break;
+        }
+        fclose(file);
+        if (kb >= 0) return kb;
+    }
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_maxrss;
+}
+
+static void bench_begin(bench_phase* p) {
+    bench_reset_peak_rss();
+    p->allocs = __atomic_load_n(&bench_allocs, __ATOMIC_RELAXED);
+    p->alloc_bytes = __atomic_load_n(&bench_alloc_bytes, __ATOMIC_RELAXED);
+    clock_gettime(CLOCK_MONOTONIC, &p->start);
+}
+
+static void bench_end(bench_phase* p, const bench_options* o, mesh* m, const char* name, long ops) {
+    struct timespec end;
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    long long ns = (long long)(end.tv_sec - p->start.tv_sec) * 1000000000LL + (end.tv_nsec - p->start.tv_nsec);
+    long rss = bench_peak_rss();
+    long allocs = BENCH_COUNTS_ALLOCS ? __atomic_load_n(&bench_allocs, __ATOMIC_RELAXED) - p->allocs : -1;
+    long bytes = BENCH_COUNTS_ALLOCS ? __atomic_load_n(&bench_alloc_bytes, __ATOMIC_RELAXED) - p->alloc_bytes : -1;
+    double per_op = ops > 0 ? (double)ns / ops : 0.0;
+    int nodes = m ? m->node_count : 0;
+    int links = m ? m->link_count : 0;
+    if (o->json) {
+        printf("{\"nodes\":%d,\"links\":%d,\"phase\":\"%s\",\"ops\":%ld,\"total_ns\":%lld,\"ns_per_op\":%.1f,"
+               "\"peak_rss_kb\":%ld,\"allocs\":%ld,\"alloc_bytes\":%ld}\n",
+               nodes, links, name, ops, ns, per_op, rss, allocs, bytes);
+    } else {
+        printf("%d,%d,%s,%ld,%lld,%.1f,%ld,%ld,%ld\n", nodes, links, name, ops, ns, per_op, rss, allocs, bytes);
+    }
+    fflush(stdout);
+}
+
+// Traversal queries visit the whole mesh, their count shrinks as the mesh grows
+static int bench_traversal_count(const bench_options* o, int node_count) {
+    long count = o->budget / node_count;
+    if (count > o->queries) count = o->queries;
+    return count > 0 ? (int)count : 1;
+}
+
+static void bench_pairs(int* pairs, int count, int node_count) {
+    for (int i = 0; i < 2 * count; i++) {
+        pairs[i] = (int)(random() % node_count);
+    }
+}
+
+// Geometric generators on fresh meshes with the same nodes. The unit-disk graph holds hundreds of links
+// per node at the default density, it is only measured up to the sweep size.
+static void bench_topologies(const bench_options* o, int node_count, float side) {
+    static const mesh_topology topologies[] = { MESH_TOPOLOGY_UNIT_DISK, MESH_TOPOLOGY_GABRIEL, MESH_TOPOLOGY_RNG, MESH_TOPOLOGY_KNN };
+    static const char* names[] = { "topology_unit_disk", "topology_gabriel", "topology_rng", "topology_knn" };
+    bench_phase p;
+    for (int t = 0; t < (int)(sizeof(topologies) / sizeof(topologies[0])); t++) {
+        if (topologies[t] == MESH_TOPOLOGY_UNIT_DISK && node_count > o->sweep_max) continue;
+        mesh* m = init_mesh_area("BenchMesh", node_count, side, side);
+        if (!m) {
+            return;
+        }
+        mesh_place_nodes(m, o->seed, o->distribution, MESH_THREADS);
+        bench_begin(&p);
+        mesh_build_topology(m, topologies[t], 0);
+        bench_end(&p, o, m, names[t], node_count);
+        free_mesh(m);
+    }
+}
+
+static void bench_size(const bench_options* o, int node_count) {
+    bench_phase p;
+    volatile long sink = 0; // Keeps query results alive
+    // Same density as the default mesh, the grid then holds the same number of nodes per cell at every size
+    float side = MESH_SIZE_X * sqrtf((float)node_count / MESH_NODES_COUNT);
+    if (side < MESH_SIZE_X) side = MESH_SIZE_X;
+    srandom(o->seed);
+
+    bench_begin(&p);
+    mesh* m = init_mesh_area("BenchMesh", node_count, side, side);
+    bench_end(&p, o, m, "init_mesh", node_count);
+    if (!m) {
+        fprintf(stderr, "mesh_bench: cannot allocate a mesh of %d nodes\n", node_count);
+        return;
+    }
+
+    bench_begin(&p);
+    mesh_place_nodes(m, o->seed, o->distribution, MESH_THREADS);
+    bench_end(&p, o, m, "mesh_place_nodes", node_count);
+
+    // Default topology of main.c
+    bench_begin(&p);
+    mesh_build_topology(m, MESH_TOPOLOGY_CHAIN, 0);
+    bench_end(&p, o, m, "link_chain", 2L * (m->node_count - 2));
+
+    // Neighbours by id are far apart on large meshes, link through the grid so the queries see a real topology
+    int max_ids = 4096;
+    int* ids = (int*)malloc(sizeof(int) * max_ids);
+    int queries = o->queries;
+    int* pairs = (int*)malloc(sizeof(int) * 2 * queries);
+    if (!ids || !pairs) {
+        free(ids);
+        free(pairs);
+        free_mesh(m);
+        return;
+    }
+    bench_begin(&p);
+    for (int i = 0; i < m->node_count; i++) {
+        int count = mesh_link_candidates(m, i, ids, max_ids);
+        mesh_form_links(m, i, ids, count < max_ids ? count : max_ids);
+    }
+    bench_end(&p, o, m, "link_grid", m->node_count);
+
+    bench_pairs(pairs, queries, m->node_count);
+    bench_begin(&p);
+    for (int i = 0; i < queries; i++) {
+        sink += get_node_in_range(m, pairs[2 * i], MESH_MAX_LINK_DISTANCE, ids, max_ids);
+    }
+    bench_end(&p, o, m, "get_node_in_range", queries);
+
+    bench_begin(&p);
+    for (int i = 0; i < queries; i++) {
+        sink += count_nodes_within_range(m, pairs[2 * i], MESH_MAX_LINK_DISTANCE);
+    }
+    bench_end(&p, o, m, "count_nodes_within_range", queries);
+
+    bench_begin(&p);
+    for (int i = 0; i < queries; i++) {
+        sink += mesh_link_candidates(m, pairs[2 * i], ids, max_ids);
+    }
+    bench_end(&p, o, m, "mesh_link_candidates", queries);
+
+    // First call after the links settle, pays for the component labelling
+    bench_begin(&p);
+    sink += mesh_component_count(m);
+    bench_end(&p, o, m, "mesh_component_count", 1);
+
+    bench_begin(&p);
+    for (int i = 0; i < queries; i++) {
+        sink += is_node_reachable(m, pairs[2 * i], pairs[2 * i + 1]);
+    }
+    bench_end(&p, o, m, "is_node_reachable", queries);
+
+    bench_begin(&p);
+    for (int i = 0; i < queries; i++) {
+        sink += is_node_strongly_connected(m, pairs[2 * i], pairs[2 * i + 1]);
+    }
+    bench_end(&p, o, m, "is_node_strongly_connected", queries);
+
+    int traversals = bench_traversal_count(o, m->node_count);
+    bench_begin(&p);
+    for (int i = 0; i < traversals; i++) {
+        sink += path_length_between_nodes(m, pairs[2 * i], pairs[2 * i + 1]);
+    }
+    bench_end(&p, o, m, "path_length_between_nodes", traversals);
+
+    bench_begin(&p);
+    for (int i = 0; i < traversals; i++) {
+        sink += max_length_path_rel(m, pairs[2 * i]);
+    }
+    bench_end(&p, o, m, "max_length_path_rel", traversals);
+
+    bench_begin(&p);
+    for (int i = 0; i < traversals; i++) {
+        sink += mesh_add_path(m, pairs[2 * i], pairs[2 * i + 1], METRIC_LATENCY) != NULL;
+    }
+    bench_end(&p, o, m, "mesh_add_path", traversals);
+
+    // Small moves with the trees of the stored paths kept up to date
+    bench_begin(&p);
+    for (int i = 0; i < queries; i++) {
+        mesh_node* node = &m->nodes[pairs[2 * i]];
+        float dx = (float)(pairs[2 * i + 1] % 21 - 10) * 0.1f;
+        sink += mesh_move_node(m, node->id, node->x + dx, node->y - dx);
+    }
+    bench_end(&p, o, m, "mesh_move_node", queries);
+
+    bench_begin(&p);
+    mesh_build_routes(m, METRIC_LATENCY, MESH_ROUTE_COMPRESS, MESH_THREADS);
+    bench_end(&p, o, m, "mesh_build_routes", m->routes.table_count);
+
+    // The first nodes are the routers, their tables are built and every lookup is a single read
+    int routers = m->routes.table_count > 0 ? m->routes.table_count : 1;
+    bench_begin(&p);
+    for (int i = 0; i < queries; i++) {
+        sink += mesh_route_next_link(m, pairs[2 * i] % routers, pairs[2 * i + 1], METRIC_LATENCY);
+    }
+    bench_end(&p, o, m, "mesh_route_next_link", queries);
+
+    int* sources = (int*)malloc(sizeof(int) * queries);
+    int* sinks = (int*)malloc(sizeof(int) * queries);
+    double* flows = (double*)malloc(sizeof(double) * queries);
+    if (sources && sinks && flows) {
+        for (int i = 0; i < queries; i++) {
+            sources[i] = pairs[2 * i];
+            sinks[i] = pairs[2 * i + 1];
+        }
+        bench_begin(&p);
+        mesh_max_flow_batch(m, sources, sinks, queries, flows, MESH_THREADS);
+        bench_end(&p, o, m, "mesh_max_flow_batch", queries);
+
+        bench_begin(&p);
+        mesh_widest_path_batch(m, sources, sinks, queries, flows, MESH_THREADS);
+        bench_end(&p, o, m, "mesh_widest_path_batch", queries);
+    }
+    free(sources);
+    free(sinks);
+    free(flows);
+
+    if (m->node_count <= o->sweep_max) {
+        bench_begin(&p);
+        sink += max_length_path_abs(m);
+        bench_end(&p, o, m, "max_length_path_abs", 1);
+
+        bench_begin(&p);
+        sink += max_length_path_abs_bounded(m);
+        bench_end(&p, o, m, "max_length_path_abs_bounded", 1);
+
+        bench_begin(&p);
+        mesh_betweenness(m, METRIC_LATENCY, MESH_THREADS);
+        bench_end(&p, o, m, "mesh_betweenness", m->node_count);
+
+        bench_begin(&p);
+        mesh_centrality* centrality = mesh_betweenness_sampled(m, METRIC_LATENCY, MESH_BETWEENNESS_EPSILON, MESH_BETWEENNESS_DELTA, MESH_THREADS);
+        bench_end(&p, o, m, "mesh_betweenness_sampled", centrality ? centrality->sources : 0);
+    }
+
+    bench_begin(&p);
+    mesh_savedump_file(m, ALL, o->dump);
+    bench_end(&p, o, m, "MESH_SAVEDUMP", (long)m->node_count + m->link_count);
+    remove(o->dump);
+
+    char snapshot[512];
+    snprintf(snapshot, sizeof(snapshot), "%s.snap", o->dump);
+    bench_begin(&p);
+    mesh_snapshot_save(m, snapshot);
+    bench_end(&p, o, m, "mesh_snapshot_save", (long)m->node_count + m->link_count);
+    remove(snapshot);
+
+    free(ids);
+    free(pairs);
+    bench_begin(&p);
+    free_mesh(m);
+    bench_end(&p, o, NULL, "free_mesh", 1);
+    (void)sink;
+
+    bench_topologies(o, node_count, side);
+}
+
+static void usage(const char* program) {
+    fprintf(stderr,
+            "usage: %s [--min N] [--max N] [--queries Q] [--budget V] [--sweep-max N] [--seed S] [--distribution D] [--json] [--dump FILE]\n"
+            "  --min, --max   node counts, every power of ten in between is measured (default %d to %d)\n"
+            "  --queries      random queries per cheap query phase (default %d)\n"
+            "  --budget       node visits allowed per traversal query phase (default %ld)\n"
+            "  --sweep-max    largest mesh the all-pairs diameter and betweenness are measured on (default %d)\n"
+            "  --seed         seed of the node placement and of the queries (default %d)\n"
+            "  --distribution uniform, clustered or poisson (default uniform)\n"
+            "  --json         one JSON object per line instead of CSV\n"
+            "  --dump         scratch file for the dump phases (default bench_dump.csv)\n",
+            program, BENCH_MIN_NODES, BENCH_MAX_NODES, BENCH_QUERIES, BENCH_BUDGET, BENCH_SWEEP_MAX, BENCH_SEED);
+}
+
+int main(int argc, char* argv[]) {
+    bench_options o = {BENCH_MIN_NODES, BENCH_MAX_NODES, BENCH_QUERIES, BENCH_BUDGET, BENCH_SWEEP_MAX, BENCH_SEED, MESH_UNIFORM, false, "bench_dump.csv"};
+    for (int i = 1; i < argc; i++) {
+        const char* arg = argv[i];
+        const char* value = i + 1 < argc ? argv[i + 1] : NULL;
+        if (strcmp(arg, "--json") == 0) { o.json = true; continue; }
+        if (!value) { usage(argv[0]); return 1; }
+        if (strcmp(arg, "--min") == 0) o.min_nodes = atoi(value);
+        else if (strcmp(arg, "--max") == 0) o.max_nodes = atoi(value);
+        else if (strcmp(arg, "--queries") == 0) o.queries = atoi(value);
+        else if (strcmp(arg, "--budget") == 0) o.budget = atol(value);
+        else if (strcmp(arg, "--sweep-max") == 0) o.sweep_max = atoi(value);
+        else if (strcmp(arg, "--seed") == 0) o.seed = (unsigned int)strtoul(value, NULL, 10);
+        else if (strcmp(arg, "--dump") == 0) o.dump = value;
+        else if (strcmp(arg, "--distribution") == 0 && strcmp(value, "uniform") == 0) o.distribution = MESH_UNIFORM;
+        else if (strcmp(arg, "--distribution") == 0 && strcmp(value, "clustered") == 0) o.distribution = MESH_CLUSTERED;
+        else if (strcmp(arg, "--distribution") == 0 && strcmp(value, "poisson") == 0) o.distribution = MESH_POISSON_DISK;
+        else { usage(argv[0]); return 1; }
+        i++;
+    }
+    if (o.min_nodes < 3 || o.max_nodes < o.min_nodes || o.queries < 1 || o.budget < 1) {
+        usage(argv[0]);
+        return 1;
+    }
+
+    if (!o.json) {
+        printf("nodes,links,phase,ops,total_ns,ns_per_op,peak_rss_kb,allocs,alloc_bytes\n");
+    }
+    for (long n = o.min_nodes; n <= o.max_nodes; n *= 10) {
+        bench_size(&o, (int)n);
+    }
+    return 0;
+}
@@ -0,0 +1,243 @@
+#include "mesh_compute.h"
+#include "mesh_parallel.h"
+
+// Direction switching thresholds from Beamer et al.
+#define BFS_ALPHA 14
+#define BFS_BETA 24
+
+#define BIT_TEST(set, i) (((set)[(i) >> 6] >> ((i) & 63)) & 1)
+#define BIT_SET(set, i) ((set)[(i) >> 6] |= (uint64_t)1 << ((i) & 63))
+#define BIT_CLEAR(set, i) ((set)[(i) >> 6] &= ~((uint64_t)1 << ((i) & 63)))
+
+mesh_bfs* mesh_bfs_workers(mesh* m, int count) {
+    int n = m->node_count;
+    int words = (n + 63) / 64;
+    if (m->bfs_count < count) {
+        mesh_bfs* bfs = (mesh_bfs*)mesh_arena_realloc(&m->arena, m->bfs, sizeof(mesh_bfs) * m->bfs_count, sizeof(mesh_bfs) * count);
+        if (!bfs) {
+            return NULL;
+        }
+        for (int i = m->bfs_count; i < count; i++) {
+            mesh_bfs* b = &bfs[i];
+            b->node_count = n;
+            b->visited = (uint64_t*)mesh_arena_alloc(&m->arena, sizeof(uint64_t) * words);
+            b->frontier = (uint64_t*)mesh_arena_calloc(&m->arena, sizeof(uint64_t) * words);
+            b->queue = (int*)mesh_arena_alloc(&m->arena, sizeof(int) * n);
+            b->next_queue = (int*)mesh_arena_alloc(&m->arena, sizeof(int) * n);
+            if (!b->visited || !b->frontier || !b->queue || !b->next_queue) {
+                return NULL;
+            }
+        }
+        m->bfs = bfs;
+        m->bfs_count = count;
+    }
+    return m->bfs;
+}
+
+int mesh_bfs_eccentricity(mesh* m, mesh_bfs* b, int source_id, bool reverse, int* reached, int* dist) {
+    mesh_csr* csr = &m->csr;
+    int n = m->node_count;
+    int words = (n + 63) / 64;
+    // Top-down steps follow the search direction, bottom-up steps look back along the opposite one
+    const int* down_offset = reverse ? csr->in_offset : csr->out_offset;
+    const int* down_degree = reverse ? csr->in_degree : csr->out_degree;
+    const int* down_node = reverse ? csr->in_source : csr->out_target;
+    const int* up_offset = reverse ? csr->out_offset : csr->in_offset;
+    const int* up_degree = reverse ? csr->out_degree : csr->in_degree;
+    const int* up_node = reverse ? csr->out_target : csr->in_source;
+
+    memset(b->visited, 0, sizeof(uint64_t) * words);
+    if (dist) {
+        for (int v = 0; v < n; v++) dist[v] = -1;
+        dist[source_id] = 0;
+    }
+    BIT_SET(b->visited, source_id);
+    b->queue[0] = source_id;
+    int queue_size = 1;
+    int level = 0;
+    int found = 1;
+    long unexplored_edges = m->link_count - down_degree[source_id];
+    bool bottom_up = false;
+
+    while (queue_size > 0) {
+        long frontier_edges = 0;
+        for (int i = 0; i < queue_size; i++) {
+            int v = b->queue[i];
+            frontier_edges += down_degree[v];
+        }
+        if (!bottom_up && frontier_edges > unexplored_edges / BFS_ALPHA) bottom_up = true;
+        else if (bottom_up && queue_size < n / BFS_BETA) bottom_up = false;
+
+        int next_size = 0;
+        if (!bottom_up) {
+            for (int i = 0; i < queue_size; i++) {
+                int v = b->queue[i];
+                for (int e = down_offset[v]; e < down_offset[v] + down_degree[v]; e++) {
+                    int w = down_node[e];
+                    if (BIT_TEST(b->visited, w)) continue;
+                    BIT_SET(b->visited, w);
+                    b->next_queue[next_size++] = w;
+                }
+            }
+        } else {
+            for (int i = 0; i < queue_size; i++) BIT_SET(b->frontier, b->queue[i]);
+            for (int word = 0; word < words; word++) {
+                uint64_t todo = ~b->visited[word];
+                while (todo) {
+                    int v = word * 64 + __builtin_ctzll(todo);
+                    todo &= todo - 1;
+                    if (v >= n) break;
+                    for (int e = up_offset[v]; e < up_offset[v] + up_degree[v]; e++) {
+                        if (!BIT_TEST(b->frontier, up_node[e])) continue;
+                        BIT_SET(b->visited, v);
+                        b->next_queue[next_size++] = v;
+                        break;
+                    }
+                }
+            }
+            for (int i = 0; i < queue_size; i++) BIT_CLEAR(b->frontier, b->queue[i]);
+        }
+
+        if (next_size == 0) break;
+        level++;
+        found += next_size;
+        for (int i = 0; i < next_size; i++) {
+            int w = b->next_queue[i];
+            unexplored_edges -= down_degree[w];
+            if (dist) dist[w] = level;
+        }
+        int* swap = b->queue;
+        b->queue = b->next_queue;
+        b->next_queue = swap;
+        queue_size = next_size;
+    }
+
+    if (reached) *reached = found;
+    return level;
+}
+
+typedef struct diameter_job {
+    mesh* m;
+    mesh_bfs* bfs;              /// Scratch buffers, one per worker
+    const int* sources;         /// Nodes to sweep, NULL for every node
+    int forward_count;          /// Sources before this index are swept forward, the others backward
+    int* worker_max;            /// Largest eccentricity seen by each worker
+} diameter_job;
+
+static void diameter_sweep(void* ctx, int worker, int begin, int end) {
+    diameter_job* job = (diameter_job*)ctx;
+    int best = job->worker_max[worker];
+    for (int i = begin; i < end; i++) {
+        int source = job->sources ? job->sources[i] : i;
+        int ecc = mesh_bfs_eccentricity(job->m, &job->bfs[worker], source, i >= job->forward_count, NULL, NULL);
+        if (ecc > best) best = ecc;
+    }
+    job->worker_max[worker] = best;
+}
+
+// Largest eccentricity over a list of sweeps run in parallel
+static int diameter_run(mesh* m, const int* sources, int count, int forward_count) {
+    int threads = mesh_thread_count(m->threads);
+    mesh_bfs* bfs = mesh_bfs_workers(m, threads);
+    if (!bfs) {
+        return -1;
+    }
+    int worker_max[MESH_MAX_THREADS] = {0};
+    diameter_job job = { m, bfs, sources, forward_count, worker_max };
+    mesh_parallel_for(count, 16, threads, diameter_sweep, &job);
+    int best = 0;
+    for (int i = 0; i < threads; i++) {
+        if (worker_max[i] > best) best = worker_max[i];
+    }
+    return best;
+}
+
+int max_length_path_rel(mesh* m, int start_id) {
+    MESH_TIMED(MESH_TIME_ECCENTRICITY);
+    mesh_bfs* bfs = mesh_get_csr(m) ? mesh_bfs_workers(m, 1) : NULL;
+    if (!bfs) {
+        return -1;
+    }
+    return mesh_bfs_eccentricity(m, bfs, start_id, false, NULL, NULL);
+}
+
+int max_length_path_abs(mesh* m) {
+    MESH_TIMED(MESH_TIME_DIAMETER);
+    if (!mesh_get_csr(m)) {
+        return -1;
+    }
+    return diameter_run(m, NULL, m->node_count, m->node_count);
+}
+
+// Groups the nodes by hop distance: level l holds nodes[offset[l], offset[l + 1])
+static void diameter_levels(const int* dist, int n, int levels, int* offset, int* nodes) {
+    memset(offset, 0, sizeof(int) * (levels + 2));
+    for (int v = 0; v < n; v++) offset[dist[v] + 1]++;
+    for (int l = 0; l < levels + 1; l++) offset[l + 1] += offset[l];
+    int* cursor = offset + levels + 2; // Scratch space right after the offsets
+    memcpy(cursor, offset, sizeof(int) * (levels + 1));
+    for (int v = 0; v < n; v++) nodes[cursor[dist[v]]++] = v;
+}
+
+int max_length_path_abs_bounded(mesh* m) {
+    MESH_TIMED(MESH_TIME_DIAMETER);
+    int n = m->node_count;
+    mesh_csr* csr = mesh_get_csr(m);
+    mesh_bfs* bfs = csr ? mesh_bfs_workers(m, 1) : NULL;
+    if (!bfs || n == 0) {
+        return csr ? 0 : -1;
+    }
+
+    // Sweep from the best connected node, it tends to sit in the middle of the mesh
+    int u = 0;
+    for (int v = 1; v < n; v++) {
+        if (csr->out_degree[v] + csr->in_degree[v] > csr->out_degree[u] + csr->in_degree[u]) u = v;
+    }
+
+    int* buffer = (int*)malloc(sizeof(int) * (8 * (size_t)n + 8));
+    if (!buffer) {
+        return -1;
+    }
+    int* dist_f = buffer;
+    int* dist_b = dist_f + n;
+    int* nodes_f = dist_b + n;
+    int* nodes_b = nodes_f + n;
+    int* offset_f = nodes_b + n;             // Up to n + 2 offsets and their cursors
+    int* offset_b = offset_f + 2 * n + 4;
+    int reached_f, reached_b;
+    int ecc_f = mesh_bfs_eccentricity(m, bfs, u, false, &reached_f, dist_f);
+    int ecc_b = mesh_bfs_eccentricity(m, bfs, u, true, &reached_b, dist_b);
+
+    if (reached_f < n || reached_b < n) {
+        // The bound d(x, y) <= d(x, u) + d(u, y) needs a strongly connected mesh
+        free(buffer);
+        return max_length_path_abs(m);
+    }
+
+    // Directed iFUB: pairs further apart than 2(i - 1) start in B_i(u) or end in F_i(u),
+    // so the eccentricities of those fringes settle the diameter level by level
+    diameter_levels(dist_f, n, ecc_f, offset_f, nodes_f);
+    diameter_levels(dist_b, n, ecc_b, offset_b, nodes_b);
+    int i = ecc_f > ecc_b ? ecc_f : ecc_b;
+    int lb = i;
+    int ub = 2 * i;
+    int* sources = dist_f; // Both distance arrays are free once the levels are built
+    while (ub > lb && i > 0) {
+        // Fringe B_i needs forward eccentricities, F_i backward ones
+        int count = 0;
+        if (i <= ecc_b) {
+            for (int k = offset_b[i]; k < offset_b[i + 1]; k++) sources[count++] = nodes_b[k];
+        }
+        int forward_count = count;
+        if (i <= ecc_f) {
+            for (int k = offset_f[i]; k < offset_f[i + 1]; k++) sources[count++] = nodes_f[k];
+        }
+        int level_max = diameter_run(m, sources, count, forward_count);
+        if (level_max > lb) lb = level_max;
+        if (lb >= 2 * (i - 1)) break;
+        ub = 2 * (i - 1);
+        i--;
+    }
+    free(buffer);
+    return lb;
+}
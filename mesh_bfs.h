@@ -0,0 +1,37 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+typedef struct mesh mesh; // Forward declaration
+
+typedef struct mesh_bfs mesh_bfs;
+
+
+/// @brief Scratch buffers of a direction-optimizing breadth first search, one per worker thread.
+struct mesh_bfs{
+    int node_count;             /// Number of nodes the buffers were sized for
+    uint64_t* visited;          /// Bitset of the nodes already reached
+    uint64_t* frontier;         /// Bitset of the current frontier, used by bottom-up steps
+    int* queue;                 /// Nodes of the current frontier
+    int* next_queue;            /// Nodes of the next frontier
+};
+
+
+///@brief Returns the BFS scratch buffers of the first workers of the mesh, allocating missing ones.
+/// Must be called from a single thread before the buffers are shared out to workers.
+///@param m A pointer to the mesh structure.
+///@param count The number of workers that need buffers.
+///@return mesh_bfs* An array of count scratch buffers, or NULL on allocation failure.
+mesh_bfs* mesh_bfs_workers(mesh* m, int count);
+
+///@brief Computes the hop eccentricity of a node, switching between top-down and bottom-up steps.
+/// The CSR adjacency must be up to date.
+///@param m A pointer to the mesh structure.
+///@param b The scratch buffers of the calling worker.
+///@param source_id The ID of the node the search starts from.
+///@param reverse True to follow links backwards, giving the distance of every node to the source.
+///@param reached If not NULL, receives the number of nodes reached including the source.
+///@param dist If not NULL, receives the hop distance of every node, -1 when unreached.
+///@return int The largest hop distance from the source to a reached node.
+int mesh_bfs_eccentricity(mesh* m, mesh_bfs* b, int source_id, bool reverse, int* reached, int* dist);
@@ -0,0 +1,204 @@
+#include <stdlib.h>
+#include "mesh_calendar.h"
+
+#define CALENDAR_MIN_BUCKETS 16
+#define CALENDAR_SAMPLES 25
+
+static long long calendar_day(mesh_calendar* q, double time) {
+    return (long long)(time / q->width);
+}
+
+// Inserts an event after the events of its bucket that do not fire later
+static void calendar_link(mesh_calendar* q, int e) {
+    int* slot = &q->buckets[calendar_day(q, q->events[e].time) % q->bucket_count];
+    while (*slot >= 0 && q->events[*slot].time <= q->events[e].time) {
+        slot = &q->events[*slot].next;
+    }
+    q->events[e].next = *slot;
+    *slot = e;
+}
+
+// Finds the bucket holding the earliest event and the day it belongs to
+static int calendar_find(mesh_calendar* q, long long* found_day) {
+    long long day = q->day;
+    // Walk one year of days, an event is due when it belongs to the day being visited
+    for (int k = 0; k < q->bucket_count; k++, day++) {
+        int b = (int)(day % q->bucket_count);
+        int h = q->buckets[b];
+        if (h >= 0 && calendar_day(q, q->events[h].time) <= day) {
+            *found_day = day;
+            return b;
+        }
+    }
+    // Nothing in the coming year, jump straight to the earliest event
+    int bucket = -1;
+    for (int b = 0; b < q->bucket_count; b++) {
+        int h = q->buckets[b];
+        if (h >= 0 && (bucket < 0 || q->events[h].time < q->events[q->buckets[bucket]].time)) bucket = b;
+    }
+    *found_day = calendar_day(q, q->events[q->buckets[bucket]].time);
+    return bucket;
+}
+
+static bool calendar_pop_raw(mesh_calendar* q, mesh_event* out) {
+    if (q->size == 0) {
+        return false;
+    }
+    long long day;
+    int bucket = calendar_find(q, &day);
+    int e = q->buckets[bucket];
+    q->buckets[bucket] = q->events[e].next;
+    *out = q->events[e];
+    q->events[e].next = q->free_list;
+    q->free_list = e;
+    q->size--;
+    q->day = day;
+    q->now = out->time;
+    return true;
+}
+
+static int calendar_push_raw(mesh_calendar* q, double time, int type, int data) {
+    if (q->free_list < 0) {
+        int capacity = q->capacity * 2;
+        mesh_event* events = (mesh_event*)realloc(q->events, sizeof(mesh_event) * capacity);
+        if (!events) {
+            return -1;
+        }
+        for (int i = q->capacity; i < capacity; i++) {
+            events[i].next = i + 1 < capacity ? i + 1 : -1;
+        }
+        q->events = events;
+        q->free_list = q->capacity;
+        q->capacity = capacity;
+    }
+    int e = q->free_list;
+    q->free_list = q->events[e].next;
+    q->events[e].time = time;
+    q->events[e].type = type;
+    q->events[e].data = data;
+    calendar_link(q, e);
+    q->size++;
+    return 0;
+}
+
+// Brown's estimate: three times the mean spacing of the next events, ignoring outliers
+static double calendar_sample_width(mesh_calendar* q) {
+    int sample[CALENDAR_SAMPLES];
+    int count = q->size < CALENDAR_SAMPLES ? q->size : CALENDAR_SAMPLES;
+    if (count < 2) {
+        return q->width;
+    }
+    // The next events are unlinked from the heads of their buckets, their slots stay out of the free list
+    long long day = q->day;
+    for (int i = 0; i < count; i++) {
+        long long found;
+        int bucket = calendar_find(q, &found);
+        sample[i] = q->buckets[bucket];
+        q->buckets[bucket] = q->events[sample[i]].next;
+        q->day = found;
+    }
+    double mean = (q->events[sample[count - 1]].time - q->events[sample[0]].time) / (count - 1);
+    double total = 0.0;
+    int kept = 0;
+    for (int i = 1; i < count; i++) {
+        double gap = q->events[sample[i]].time - q->events[sample[i - 1]].time;
+        if (gap <= 2.0 * mean) {
+            total += gap;
+            kept++;
+        }
+    }
+    // Back at the heads they were taken from, last first, so they stay ahead of the events of the same time
+    for (int i = count - 1; i >= 0; i--) {
+        int* head = &q->buckets[calendar_day(q, q->events[sample[i]].time) % q->bucket_count];
+        q->events[sample[i]].next = *head;
+        *head = sample[i];
+    }
+    q->day = day;
+    return kept > 0 && total > 0.0 ? 3.0 * total / kept : q->width;
+}
+
+static void calendar_resize(mesh_calendar* q, int bucket_count) {
+    int* buckets = (int*)malloc(sizeof(int) * bucket_count);
+    if (!buckets) {
+        return; // Keep the current layout, it is only slower
+    }
+    double width = calendar_sample_width(q);
+    int* old = q->buckets;
+    int old_count = q->bucket_count;
+    for (int b = 0; b < bucket_count; b++) buckets[b] = -1;
+    q->buckets = buckets;
+    q->bucket_count = bucket_count;
+    q->width = width;
+    for (int b = 0; b < old_count; b++) {
+        int e = old[b];
+        while (e >= 0) {
+            int next = q->events[e].next;
+            calendar_link(q, e);
+            e = next;
+        }
+    }
+    free(old);
+    q->day = calendar_day(q, q->now);
+}
+
+int mesh_calendar_init(mesh_calendar* q, double width) {
+    q->capacity = 1024;
+    q->events = (mesh_event*)malloc(sizeof(mesh_event) * q->capacity);
+    q->bucket_count = CALENDAR_MIN_BUCKETS;
+    q->buckets = (int*)malloc(sizeof(int) * q->bucket_count);
+    if (!q->events || !q->buckets) {
+        mesh_calendar_free(q);
+        return -1;
+    }
+    for (int i = 0; i < q->capacity; i++) {
+        q->events[i].next = i + 1 < q->capacity ? i + 1 : -1;
+    }
+    for (int b = 0; b < q->bucket_count; b++) q->buckets[b] = -1;
+    q->free_list = 0;
+    q->width = width > 0.0 ? width : 1.0;
+    q->size = 0;
+    q->day = 0;
+    q->now = 0.0;
+    return 0;
+}
+
+void mesh_calendar_free(mesh_calendar* q) {
+    free(q->events);
+    free(q->buckets);
+    q->events = NULL;
+    q->buckets = NULL;
+    q->capacity = 0;
+    q->bucket_count = 0;
+    q->size = 0;
+}
+
+int mesh_calendar_push(mesh_calendar* q, double time, int type, int data) {
+    if (calendar_push_raw(q, time, type, data) != 0) {
+        return -1;
+    }
+    if (q->size > 2 * q->bucket_count) {
+        calendar_resize(q, 2 * q->bucket_count);
+    }
+    return 0;
+}
+
+bool mesh_calendar_pop(mesh_calendar* q, mesh_event* out) {
+    if (!calendar_pop_raw(q, out)) {
+        return false;
+    }
+    if (q->bucket_count > CALENDAR_MIN_BUCKETS && q->size < q->bucket_count / 2) {
+        calendar_resize(q, q->bucket_count / 2);
+    }
+    return true;
+}
+
+bool mesh_calendar_peek(mesh_calendar* q, double* time) {
+    if (q->size == 0) {
+        return false;
+    }
+    long long day;
+    int bucket = calendar_find(q, &day);
+    q->day = day; // Later searches can start from here
+    *time = q->events[q->buckets[bucket]].time;
+    return true;
+}
@@ -0,0 +1,62 @@
+#pragma once
+
+#include <stdbool.h>
+
+typedef struct mesh_event mesh_event;
+
+typedef struct mesh_calendar mesh_calendar;
+
+
+/// @brief Pending event of a discrete-event simulation.
+struct mesh_event{
+    double time;                /// Time at which the event fires, in ms
+    int type;                   /// Meaning is left to the simulation
+    int data;                   /// Packet, link or flow index, depending on the type
+    int next;                   /// Next event in the same bucket or in the free list, -1 at the end
+};
+
+/// @brief Calendar queue (Brown, 1988): a ring of day buckets holding sorted event lists.
+/// The bucket count follows the number of pending events and the bucket width follows
+/// their spacing, which keeps push and pop O(1) amortized.
+struct mesh_calendar{
+    mesh_event* events;         /// Event pool, buckets chain events by index
+    int capacity;               /// Number of events the pool can hold
+    int free_list;              /// First unused event of the pool, -1 if the pool is full
+    int* buckets;               /// First event of each bucket, -1 if the bucket is empty
+    int bucket_count;           /// Number of buckets
+    double width;               /// Time span of a bucket
+    int size;                   /// Number of pending events
+    long long day;              /// Day the next event is searched from, its bucket is day % bucket_count
+    double now;                 /// Time of the last popped event
+};
+
+
+///@brief Initializes an empty calendar queue.
+///@param q A pointer to the queue to initialize.
+///@param width The initial bucket width, a guess of the spacing between events.
+///@return int 0 on success, -1 on allocation failure.
+int mesh_calendar_init(mesh_calendar* q, double width);
+
+///@brief Frees the buffers of a calendar queue.
+///@param q A pointer to the queue.
+void mesh_calendar_free(mesh_calendar* q);
+
+///@brief Schedules an event. Events at the same time are popped in the order they were pushed.
+///@param q A pointer to the queue.
+///@param time The time of the event, not earlier than the last popped event.
+///@param type The type of the event.
+///@param data The payload of the event.
+///@return int 0 on success, -1 on allocation failure.
+int mesh_calendar_push(mesh_calendar* q, double time, int type, int data);
+
+///@brief Removes the earliest pending event.
+///@param q A pointer to the queue.
+///@param out Receives the event.
+///@return bool False if the queue is empty.
+bool mesh_calendar_pop(mesh_calendar* q, mesh_event* out);
+
+///@brief Returns the time of the earliest pending event without removing it.
+///@param q A pointer to the queue.
+///@param time Receives the time of the event.
+///@return bool False if the queue is empty.
+bool mesh_calendar_peek(mesh_calendar* q, double* time);
@@ -0,0 +1,258 @@
+#include "mesh_compute.h"
+#include "mesh_parallel.h"
+#include "mesh_rng.h"
+
+#define CENTRALITY_STREAM_SOURCE 2 // Placement draws from streams 0 and 1 of the same seed
+
+typedef struct centrality_job {
+    mesh* m;
+    mesh_csr* csr;
+    path_metric metric;
+    const int* sources;         /// Nodes to search from, NULL for every node
+} centrality_job;
+
+static int centrality_prepare(mesh* m, int workers) {
+    mesh_centrality* c = &m->centrality;
+    int n = m->node_count;
+    if (c->node_count != n || c->link_capacity < m->link_count) {
+        // Outgrown buffers stay in the arena until the mesh is reset, like the adjacency
+        int capacity = m->link_count > 2 * c->link_capacity ? m->link_count : 2 * c->link_capacity;
+        if (capacity < 64) capacity = 64;
+        c->node = (double*)mesh_arena_alloc(&m->arena, sizeof(double) * n);
+        c->link = (double*)mesh_arena_alloc(&m->arena, sizeof(double) * capacity);
+        if (!c->node || !c->link) {
+            c->node_count = 0;
+            return -1;
+        }
+        c->node_count = n;
+        c->link_capacity = capacity;
+        c->built = false;
+        c->scratch_count = 0; // Per link buffers of the workers are too small now
+    }
+    if (c->scratch_count < workers) {
+        mesh_centrality_scratch* scratch = (mesh_centrality_scratch*)mesh_arena_realloc(&m->arena, c->scratch, sizeof(mesh_centrality_scratch) * c->scratch_count, sizeof(mesh_centrality_scratch) * workers);
+        if (!scratch) {
+            return -1;
+        }
+        c->scratch = scratch;
+        for (int i = c->scratch_count; i < workers; i++) {
+            mesh_centrality_scratch* s = &scratch[i];
+            s->dist = (float*)mesh_arena_alloc(&m->arena, sizeof(float) * n);
+            s->sigma = (double*)mesh_arena_calloc(&m->arena, sizeof(double) * n);
+            s->delta = (double*)mesh_arena_calloc(&m->arena, sizeof(double) * n);
+            s->order = (int*)mesh_arena_alloc(&m->arena, sizeof(int) * n);
+            s->heap = (int*)mesh_arena_alloc(&m->arena, sizeof(int) * n);
+            s->heap_pos = (int*)mesh_arena_alloc(&m->arena, sizeof(int) * n);
+            s->node = (double*)mesh_arena_alloc(&m->arena, sizeof(double) * n);
+            s->link = (double*)mesh_arena_alloc(&m->arena, sizeof(double) * c->link_capacity);
+            if (!s->dist || !s->sigma || !s->delta || !s->order || !s->heap || !s->heap_pos || !s->node || !s->link) {
+                return -1;
+            }
+            for (int v = 0; v < n; v++) s->dist[v] = INFINITY;
+            memset(s->heap_pos, -1, sizeof(int) * n);
+            c->scratch_count = i + 1;
+        }
+    }
+    return 0;
+}
+
+static void centrality_heap_up(mesh_centrality_scratch* s, int i) {
+    int v = s->heap[i];
+    while (i > 0) {
+        int parent = (i - 1) / 2;
+        int p = s->heap[parent];
+        if (s->dist[p] <= s->dist[v]) break;
+        s->heap[i] = p;
+        s->heap_pos[p] = i;
+        i = parent;
+    }
+    s->heap[i] = v;
+    s->heap_pos[v] = i;
+}
+
+static void centrality_heap_down(mesh_centrality_scratch* s, int size, int i) {
+    int v = s->heap[i];
+    for (;;) {
+        int child = 2 * i + 1;
+        if (child >= size) break;
+        if (child + 1 < size && s->dist[s->heap[child + 1]] < s->dist[s->heap[child]]) child++;
+        int c = s->heap[child];
+        if (s->dist[c] >= s->dist[v]) break;
+        s->heap[i] = c;
+        s->heap_pos[c] = i;
+        i = child;
+    }
+    s->heap[i] = v;
+    s->heap_pos[v] = i;
+}
+
+// Counts the shortest paths from the source to every node, returns the number of reached nodes in order.
+// Breadth first for hops, Dijkstra for latency. A tie is an exact float match of the same sum, which the
+// backward pass recomputes identically.
+static int centrality_forward(mesh* m, const mesh_csr* csr, path_metric metric, mesh_centrality_scratch* s, int source) {
+    s->dist[source] = 0.0f;
+    s->sigma[source] = 1.0;
+    int count = 0;
+    if (metric == METRIC_HOPS) {
+        s->order[count++] = source;
+        for (int head = 0; head < count; head++) {
+            int x = s->order[head];
+            float next = s->dist[x] + 1.0f;
+            for (int e = csr->out_offset[x]; e < csr->out_offset[x] + csr->out_degree[x]; e++) {
+                int y = csr->out_target[e];
+                if (m->soa.node_status[y] == INACTIVE) continue;
+                if (s->dist[y] == INFINITY) {
+                    s->dist[y] = next;
+                    s->order[count++] = y;
+                }
+                if (s->dist[y] == next) s->sigma[y] += s->sigma[x];
+            }
+        }
+        return count;
+    }
+    s->heap[0] = source;
+    s->heap_pos[source] = 0;
+    int size = 1;
+    while (size > 0) {
+        int x = s->heap[0];
+        s->heap_pos[x] = -1;
+        if (--size > 0) {
+            s->heap[0] = s->heap[size];
+            centrality_heap_down(s, size, 0);
+        }
+        s->order[count++] = x;
+        for (int e = csr->out_offset[x]; e < csr->out_offset[x] + csr->out_degree[x]; e++) {
+            int y = csr->out_target[e];
+            if (m->soa.node_status[y] == INACTIVE) continue;
+            float candidate = s->dist[x] + csr->out_latency[e];
+            if (candidate < s->dist[y]) {
+                s->dist[y] = candidate;
+                s->sigma[y] = s->sigma[x];
+                if (s->heap_pos[y] < 0) {
+                    s->heap[size] = y;
+                    s->heap_pos[y] = size++;
+                }
+                centrality_heap_up(s, s->heap_pos[y]);
+            } else if (candidate == s->dist[y]) {
+                s->sigma[y] += s->sigma[x];
+            }
+        }
+    }
+    return count;
+}
+
+// Brandes accumulation from the farthest nodes back to the source, pulling along the incoming links
+static void centrality_backward(const mesh_csr* csr, path_metric metric, mesh_centrality_scratch* s, int count) {
+    for (int i = count - 1; i > 0; i--) {
+        int w = s->order[i];
+        double share = (1.0 + s->delta[w]) / s->sigma[w];
+        for (int e = csr->in_offset[w]; e < csr->in_offset[w] + csr->in_degree[w]; e++) {
+            int v = csr->in_source[e];
+            if (s->dist[v] == INFINITY) continue;
+            if (s->dist[v] + (metric == METRIC_HOPS ? 1.0f : csr->in_latency[e]) != s->dist[w]) continue;
+            double c = s->sigma[v] * share;
+            s->delta[v] += c;
+            s->link[csr->in_link[e]] += c;
+        }
+        s->node[w] += s->delta[w];
+    }
+    for (int i = 0; i < count; i++) {
+        int v = s->order[i];
+        s->dist[v] = INFINITY;
+        s->sigma[v] = 0.0;
+        s->delta[v] = 0.0;
+    }
+}
+
+static void centrality_range(void* ctx, int worker, int begin, int end) {
+    centrality_job* job = (centrality_job*)ctx;
+    mesh_centrality_scratch* s = &job->m->centrality.scratch[worker];
+    for (int i = begin; i < end; i++) {
+        int source = job->sources ? job->sources[i] : i;
+        if (job->m->soa.node_status[source] == INACTIVE) continue;
+        int count = centrality_forward(job->m, job->csr, job->metric, s, source);
+        centrality_backward(job->csr, job->metric, s, count);
+    }
+}
+
+static mesh_centrality* centrality_run(mesh* m, path_metric metric, const int* sources, int count, int threads) {
+    MESH_TIMED(MESH_TIME_BETWEENNESS);
+    int workers = mesh_thread_count(threads);
+    mesh_csr* csr = mesh_get_csr(m);
+    // Every worker buffer exists before the threads start, workers only read the mesh
+    if (!csr || centrality_prepare(m, workers) != 0) {
+        return NULL;
+    }
+    mesh_centrality* c = &m->centrality;
+    int n = m->node_count;
+    for (int i = 0; i < workers; i++) {
+        memset(c->scratch[i].node, 0, sizeof(double) * n);
+        memset(c->scratch[i].link, 0, sizeof(double) * m->link_count);
+    }
+    centrality_job job = { m, csr, metric, sources };
+    mesh_parallel_for(count, 1, workers, centrality_range, &job);
+
+    // Workers are merged in a fixed order, a worker's share still depends on which sources it pulled
+    double scale = count > 0 ? (double)n / count : 0.0;
+    for (int v = 0; v < n; v++) {
+        double sum = 0.0;
+        for (int i = 0; i < workers; i++) sum += c->scratch[i].node[v];
+        c->node[v] = sum * scale;
+    }
+    for (int l = 0; l < m->link_count; l++) {
+        double sum = 0.0;
+        for (int i = 0; i < workers; i++) sum += c->scratch[i].link[l];
+        c->link[l] = sum * scale;
+    }
+    c->metric = metric;
+    c->sources = count;
+    c->version = m->version;
+    c->built = true;
+    return c;
+}
+
+mesh_centrality* mesh_betweenness(mesh* m, path_metric metric, int threads) {
+    mesh_centrality* c = centrality_run(m, metric, NULL, m->node_count, threads);
+    if (c) {
+        c->epsilon = 0.0;
+        c->delta = 0.0;
+    }
+    return c;
+}
+
+mesh_centrality* mesh_betweenness_sampled(mesh* m, path_metric metric, double epsilon, double delta, int threads) {
+    int n = m->node_count;
+    if (n < 3 || epsilon <= 0.0 || delta <= 0.0 || delta >= 1.0) {
+        return mesh_betweenness(m, metric, threads);
+    }
+    double range = (double)n / (n - 1);
+    double k = ceil(range * range * log(2.0 * ((double)n + m->link_count) / delta) / (2.0 * epsilon * epsilon));
+    if (k >= n) {
+        return mesh_betweenness(m, metric, threads);
+    }
+    int count = (int)k;
+    int* sources = (int*)malloc(sizeof(int) * n);
+    if (!sources) {
+        return NULL;
+    }
+    // Partial Fisher-Yates shuffle, the first count entries are the sample
+    for (int v = 0; v < n; v++) sources[v] = v;
+    for (int i = 0; i < count; i++) {
+        int j = i + (int)(mesh_rng_u64(m->seed, CENTRALITY_STREAM_SOURCE, (uint64_t)i) % (uint64_t)(n - i));
+        int swap = sources[i];
+        sources[i] = sources[j];
+        sources[j] = swap;
+    }
+    mesh_centrality* c = centrality_run(m, metric, sources, count, threads);
+    free(sources);
+    if (c) {
+        c->epsilon = epsilon;
+        c->delta = delta;
+    }
+    return c;
+}
+
+mesh_centrality* mesh_get_centrality(mesh* m) {
+    mesh_centrality* c = &m->centrality;
+    return c->built && c->version == m->version ? c : NULL;
+}
@@ -0,0 +1,68 @@
+#pragma once
+
+#include <stdbool.h>
+#include "mesh_sssp.h"
+
+typedef struct mesh mesh; // Forward declaration
+
+typedef struct mesh_centrality_scratch mesh_centrality_scratch;
+
+typedef struct mesh_centrality mesh_centrality;
+
+
+/// @brief Buffers of one worker running Brandes searches. Only the nodes a search reached are
+/// cleared afterwards. The worker adds its dependencies to its own scores, merged once every source is done.
+struct mesh_centrality_scratch{
+    float* dist;                /// Distance from the source, INFINITY if unreached
+    double* sigma;              /// Number of shortest paths from the source to each node
+    double* delta;              /// Dependency of the source on each node
+    int* order;                 /// Reached nodes by nondecreasing distance, also the BFS queue
+    int* heap;                  /// Binary min-heap of node ids keyed by dist
+    int* heap_pos;              /// Position of each node in the heap, -1 outside
+    double* node;               /// Node scores of the sources searched by the worker
+    double* link;               /// Link scores of the sources searched by the worker
+};
+
+/// @brief Betweenness centrality of the nodes and links (Brandes, 2001): the number of shortest
+/// paths between ordered pairs of other nodes that cross them, ties sharing each pair. Paths follow
+/// the directed links and route around INACTIVE nodes, like mesh_shortest_paths().
+/// The sampled mode searches from k random sources and scales by node_count / k (Brandes and Pich, 2007).
+struct mesh_centrality{
+    bool built;                 /// False until the first computation
+    unsigned long version;      /// mesh->version the scores were computed for
+    path_metric metric;         /// Weight of the links
+    int sources;                /// Number of sources searched, node_count when exact
+    double epsilon;             /// Bound on the error of the normalized scores, 0 when exact
+    double delta;               /// Probability that a sampled score exceeds the bound
+    int node_count;             /// Number of nodes the buffers were sized for
+    int link_capacity;          /// Number of links the buffers can hold
+    double* node;               /// Score of each node
+    double* link;               /// Score of each link, indexed like mesh->links
+    mesh_centrality_scratch* scratch; /// Buffers of each worker
+    int scratch_count;          /// Number of workers with buffers
+};
+
+
+///@brief Computes the exact betweenness of every node and link on worker threads, one search per source.
+///@param m A pointer to the mesh structure.
+///@param metric The link weight, latency or one per hop.
+///@param threads The number of workers, 0 to use every online core.
+///@return mesh_centrality* The scores, valid until mesh->version changes, or NULL on allocation failure.
+mesh_centrality* mesh_betweenness(mesh* m, path_metric metric, int threads);
+
+///@brief Estimates the betweenness from sources sampled without replacement. With
+/// k = ceil(r^2 ln(2 (node_count + link_count) / delta) / (2 epsilon^2)) sources, r = n / (n - 1), every node score
+/// divided by (n - 1)(n - 2) and every link score divided by n (n - 1) is within epsilon of its exact value with
+/// probability at least 1 - delta (Hoeffding bound over all of them). Falls back to the exact computation when k >= n.
+///@param m A pointer to the mesh structure.
+///@param metric The link weight, latency or one per hop.
+///@param epsilon The error bound on the normalized scores, in (0, 1).
+///@param delta The probability of missing the bound, in (0, 1).
+///@param threads The number of workers, 0 to use every online core.
+///@return mesh_centrality* The scores, valid until mesh->version changes, or NULL on allocation failure.
+mesh_centrality* mesh_betweenness_sampled(mesh* m, path_metric metric, double epsilon, double delta, int threads);
+
+///@brief Returns the last scores if the mesh did not change since they were computed.
+///@param m A pointer to the mesh structure.
+///@return mesh_centrality* The scores, or NULL if none are up to date.
+mesh_centrality* mesh_get_centrality(mesh* m);
@@ -0,0 +1,161 @@
+#include "mesh_compute.h"
+
+static int components_find(mesh_components* c, int id) {
+    // Path halving keeps the trees flat, a query is a couple of array reads
+    while (c->parent[id] != id) {
+        c->parent[id] = c->parent[c->parent[id]];
+        id = c->parent[id];
+    }
+    return id;
+}
+
+static void components_union(mesh_components* c, int a, int b) {
+    a = components_find(c, a);
+    b = components_find(c, b);
+    if (a == b) return;
+    if (c->size[a] < c->size[b]) {
+        int swap = a;
+        a = b;
+        b = swap;
+    }
+    c->parent[b] = a;
+    c->size[a] += c->size[b];
+    c->count--;
+    if (c->size[a] > c->largest) c->largest = c->size[a];
+}
+
+static void components_reset(mesh* m) {
+    mesh_components* c = &m->components;
+    for (int i = 0; i < m->node_count; i++) {
+        c->parent[i] = i;
+        c->size[i] = 1;
+    }
+    c->count = m->node_count;
+    c->largest = m->node_count > 0 ? 1 : 0;
+    c->valid = true;
+    c->scc_valid = false;
+}
+
+static void components_rebuild(mesh* m) {
+    MESH_TIMED(MESH_TIME_COMPONENTS);
+    components_reset(m);
+    for (int i = 0; i < m->link_count; i++) {
+        components_union(&m->components, m->links[i].source_id, m->links[i].destination_id);
+    }
+}
+
+int mesh_components_init(mesh* m) {
+    mesh_components* c = &m->components;
+    if (!c->parent) {
+        c->parent = (int*)mesh_arena_alloc(&m->arena, sizeof(int) * m->node_count);
+        c->size = (int*)mesh_arena_alloc(&m->arena, sizeof(int) * m->node_count);
+        c->scc = (int*)mesh_arena_alloc(&m->arena, sizeof(int) * m->node_count);
+        if (!c->parent || !c->size || !c->scc) {
+            c->parent = NULL;
+            return -1;
+        }
+    }
+    components_reset(m);
+    return 0;
+}
+
+void mesh_components_link(mesh* m, int source_id, int destination_id) {
+    mesh_components* c = &m->components;
+    c->scc_valid = false;
+    if (c->valid) components_union(c, source_id, destination_id);
+}
+
+void mesh_components_invalidate(mesh* m) {
+    m->components.valid = false;
+    m->components.scc_valid = false;
+}
+
+int mesh_component_count(mesh* m) {
+    if (!m->components.valid) components_rebuild(m);
+    return m->components.count;
+}
+
+int mesh_component_of(mesh* m, int id) {
+    if (!m->components.valid) components_rebuild(m);
+    return components_find(&m->components, id);
+}
+
+int mesh_component_size(mesh* m, int id) {
+    return m->components.size[mesh_component_of(m, id)];
+}
+
+bool is_node_reachable(mesh* m, int start_id, int target_id) {
+    return mesh_component_of(m, start_id) == mesh_component_of(m, target_id);
+}
+
+int mesh_scc_label(mesh* m) {
+    mesh_components* c = &m->components;
+    if (c->scc_valid) {
+        return c->scc_count;
+    }
+    MESH_TIMED(MESH_TIME_COMPONENTS);
+    mesh_csr* csr = mesh_get_csr(m);
+    int n = m->node_count;
+    int* buffer = csr ? (int*)malloc(sizeof(int) * 5 * (size_t)n) : NULL;
+    if (!buffer) {
+        return -1;
+    }
+    int* index = buffer;
+    int* low = index + n;
+    int* stack = low + n;
+    int* call = stack + n;
+    int* edge = call + n;
+    int counter = 0;
+    int stack_size = 0;
+    c->scc_count = 0;
+    for (int v = 0; v < n; v++) {
+        index[v] = -1;
+        c->scc[v] = -1; // -1 while the node is on the Tarjan stack or unvisited
+    }
+
+    // Iterative Tarjan, call[] replaces the recursion and edge[] remembers where each node resumes
+    for (int s = 0; s < n; s++) {
+        if (index[s] >= 0) continue;
+        int depth = 0;
+        call[depth++] = s;
+        index[s] = low[s] = counter++;
+        edge[s] = csr->out_offset[s];
+        stack[stack_size++] = s;
+        while (depth > 0) {
+            int v = call[depth - 1];
+            if (edge[v] < csr->out_offset[v] + csr->out_degree[v]) {
+                int w = csr->out_target[edge[v]++];
+                if (index[w] < 0) {
+                    index[w] = low[w] = counter++;
+                    edge[w] = csr->out_offset[w];
+                    stack[stack_size++] = w;
+                    call[depth++] = w;
+                } else if (c->scc[w] < 0 && index[w] < low[v]) {
+                    low[v] = index[w];
+                }
+                continue;
+            }
+            depth--;
+            if (depth > 0 && low[v] < low[call[depth - 1]]) low[call[depth - 1]] = low[v];
+            if (low[v] == index[v]) {
+                int w;
+                do {
+                    w = stack[--stack_size];
+                    c->scc[w] = c->scc_count;
+                } while (w != v);
+                c->scc_count++;
+            }
+        }
+    }
+
+    free(buffer);
+    c->scc_valid = true;
+    return c->scc_count;
+}
+
+bool is_node_strongly_connected(mesh* m, int start_id, int target_id) {
+    if (mesh_scc_label(m) < 0) {
+        return false;
+    }
+    return m->components.scc[start_id] == m->components.scc[target_id];
+}
@@ -0,0 +1,67 @@
+#pragma once
+
+#include <stdbool.h>
+
+typedef struct mesh mesh; // Forward declaration
+
+typedef struct mesh_components mesh_components;
+
+
+/// @brief Connected components of the mesh.
+/// Weak components (links taken in both directions) live in a union-find updated on every new link.
+/// Strong components are labeled on demand from the CSR adjacency.
+struct mesh_components{
+    bool valid;                 /// False after links were removed, rebuilt on the next query
+    int* parent;                /// Union-find parent of each node
+    int* size;                  /// Number of nodes of the set rooted at each node
+    int count;                  /// Number of weak components
+    int largest;                /// Number of nodes of the largest weak component
+    bool scc_valid;             /// False when links changed since the last labeling
+    int* scc;                   /// Strong component label of each node
+    int scc_count;              /// Number of strong components
+};
+
+
+///@brief Allocates the union-find of the mesh and makes every node its own component.
+///@param m A pointer to the mesh structure.
+///@return int 0 on success, -1 on allocation failure.
+int mesh_components_init(mesh* m);
+
+///@brief Merges the components of the two ends of a new link.
+///@param m A pointer to the mesh structure.
+///@param source_id The ID of the source node of the link.
+///@param destination_id The ID of the destination node of the link.
+void mesh_components_link(mesh* m, int source_id, int destination_id);
+
+///@brief Marks the components stale after links were removed, they are rebuilt on the next query.
+///@param m A pointer to the mesh structure.
+void mesh_components_invalidate(mesh* m);
+
+///@brief Returns the number of weak components, rebuilding them if they are stale.
+///@param m A pointer to the mesh structure.
+///@return int The number of weak components, components.largest then holds the size of the largest one.
+int mesh_component_count(mesh* m);
+
+///@brief Returns the weak component of a node.
+///@param m A pointer to the mesh structure.
+///@param id The ID of the node.
+///@return int The ID of the representative node of the component.
+int mesh_component_of(mesh* m, int id);
+
+///@brief Returns the number of nodes in the weak component of a node.
+///@param m A pointer to the mesh structure.
+///@param id The ID of the node.
+///@return int The size of the component.
+int mesh_component_size(mesh* m, int id);
+
+///@brief Labels the strongly connected components of the mesh if links changed since the last call.
+///@param m A pointer to the mesh structure.
+///@return int The number of strong components, or -1 on allocation failure.
+int mesh_scc_label(mesh* m);
+
+///@brief Check if two nodes can reach each other along the direction of the links.
+///@param m A pointer to the mesh structure.
+///@param start_id The ID of the first node.
+///@param target_id The ID of the second node.
+///@return bool True if both nodes belong to the same strong component.
+bool is_node_strongly_connected(mesh* m, int start_id, int target_id);
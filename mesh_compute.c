@@ -4,60 +4,115 @@ mesh_node* find_node_by_id(mesh_node* nodes, int node_count, int id) {
     return &nodes[id];
 }
 
-mesh* init_mesh(const char* name) {
-    mesh* m = (mesh*)malloc(sizeof(mesh));
+mesh* init_mesh_sized(const char* name, int node_count) {
+    mesh_config config;
+    mesh_config_defaults(&config);
+    config.node_count = node_count;
+    return init_mesh(name, &config);
+}
+
+mesh* init_mesh_area(const char* name, int node_count, float size_x, float size_y) {
+    mesh_config config;
+    mesh_config_defaults(&config);
+    config.node_count = node_count;
+    config.size_x = size_x;
+    config.size_y = size_y;
+    return init_mesh(name, &config);
+}
+
+mesh* init_mesh(const char* name, const mesh_config* config) {
+    MESH_TIMED(MESH_TIME_INIT_MESH);
+    mesh_config defaults;
+    if (!config) {
+        mesh_config_defaults(&defaults);
+        config = &defaults;
+    }
+    // The mesh itself lives in its arena so a single release frees everything
+    mesh_arena arena;
+    if (mesh_arena_init(&arena, MESH_ARENA_BLOCK_SIZE) != 0) {
+        return NULL;
+    }
+    mesh* m = (mesh*)mesh_arena_calloc(&arena, sizeof(mesh));
+    m->arena = arena;
     strncpy(m->name, name, sizeof(m->name) - 1);
     m->name[sizeof(m->name) - 1] = '\0';
-    m->node_count = MESH_NODES_COUNT;
-    m->nodes = (mesh_node*)malloc(sizeof(mesh_node) * m->node_count);
-    m->link_count = 0;
-    m->path_count = 0;
-    m->paths = NULL;
-    for (int i = 0; i < m->node_count; i++) {
-        init_mesh_node(&m->nodes[i], i);
+    m->config = *config;
+    m->node_count = config->node_count;
+    m->size_x = config->size_x >= 1.0f ? config->size_x : 1.0f;
+    m->size_y = config->size_y >= 1.0f ? config->size_y : 1.0f;
+    m->threads = config->threads;
+    m->nodes = (mesh_node*)mesh_arena_alloc(&m->arena, sizeof(mesh_node) * m->node_count);
+    if (!m->nodes) {
+        free_mesh(m);
+        return NULL;
+    }
+    if (mesh_place_nodes(m, config->seed, config->distribution, m->threads) != 0 || mesh_components_init(m) != 0) {
+        free_mesh(m);
+        return NULL;
     }
+    m->arena_mark = mesh_arena_save(&m->arena);
 
     return m;
 } 
 
-void free_mesh(mesh* m) {
-    if (m->nodes) {
-        free(m->nodes);
-        m->nodes = NULL;
-    }
-    if (m->paths) {
-        free(m->paths);
-        m->paths = NULL;
-    }
-    m->node_count = 0;
+int reset_mesh(mesh* m) {
+    mesh_arena_rewind(&m->arena, m->arena_mark);
     m->link_count = 0;
+    m->links = NULL;
+    m->link_capacity = 0;
+    m->next_link_id = 0;
+    m->version++;
     m->path_count = 0;
+    m->path_capacity = 0;
+    m->paths = NULL;
+    m->path_nodes = NULL;
+    m->path_node_count = 0;
+    m->path_node_capacity = 0;
+    m->path_node_waste = 0;
+    m->path_scratch = NULL;
+    memset(&m->csr, 0, sizeof(m->csr));
+    memset(&m->sssp, 0, sizeof(m->sssp));
+    memset(&m->spt, 0, sizeof(m->spt));
+    memset(&m->routes, 0, sizeof(m->routes));
+    memset(&m->flow, 0, sizeof(m->flow));
+    memset(&m->centrality, 0, sizeof(m->centrality));
+    m->bfs = NULL;
+    m->bfs_count = 0;
+    if (mesh_place_nodes(m, m->seed, m->distribution, m->threads) != 0) {
+        return -1;
+    }
+    return mesh_components_init(m);
+}
+
+void free_mesh(mesh* m) {
+    mesh_arena arena = m->arena;
+    mesh_arena_release(&arena);
 }
 
-mesh_node* init_mesh_node (mesh_node* node, int id) {
+mesh_node* init_mesh_node (mesh_node* node, int id, const mesh_config* config) {
     node->id = id;
     node->input_link_count = 0;
+    node->output_link_count = 0;
     node->node_status = DISCONNECTED; // Initially disconnected
-    node->node_type = MESH_ROUTERS_COUNT > id ? ROUTER : END_DEVICE; // First N nodes are routers
-    node->x = random() % (int)MESH_SIZE_X;
-    node->y = random() % (int)MESH_SIZE_Y;
-    node->output_link = calloc(2, sizeof(mesh_link)); // No output links initially
-    node->input_links = calloc(8, sizeof(mesh_link*)); // No input links initially
+    node->node_type = config->router_count > id ? ROUTER : END_DEVICE; // First N nodes are routers
+    node->x = 0.0f;
+    node->y = 0.0f;
     return node;
 }
 
-bool mesh_link_allowed(mesh_node* source, mesh_node* destination) {
-    float distance = sqrt(pow(source->x - destination->x, 2) + pow(source->y - destination->y, 2));
+bool mesh_link_allowed(mesh* m, mesh_node* source, mesh_node* destination) {
+    float dx = source->x - destination->x;
+    float dy = source->y - destination->y;
     if (source->id == destination->id) {
         return false; // No self-links
     }
-    if(distance > MESH_MAX_LINK_DISTANCE) {
+    if(dx * dx + dy * dy > m->config.max_link_distance * m->config.max_link_distance) {
         return false; // Exceeds max link distance
     }
-    if(source->output_link_count >= 2) {
+    if(source->output_link_count >= m->config.max_output_links) {
         return false; // Source has max output links
     }
-    if(destination->input_link_count >= 8) {
+    if(destination->input_link_count >= m->config.max_input_links) {
         return false; // Destination has max input links
     }
     return true;
@@ -65,38 +120,209 @@ bool mesh_link_allowed(mesh_node* source, mesh_node* destination) {
 
 
 
-int init_mesh_link(int id, mesh_node* source, mesh_node* destination) {
-    mesh_link link = source->output_link[source->output_link_count];
-    link.id = id;
-    link.bandwidth = MESH_DEFAULT_BANDWIDTH; // Decrease bandwidth with length
-    link.length = sqrt(pow(source->x - destination->x, 2) + pow(source->y - destination->y, 2));
-    link.latency = ( link.length * 10);   
-    link.source = source;
-    link.destination = destination;
+void mesh_measure_link(mesh* m, mesh_link* link) {
+    float dx = m->nodes[link->source_id].x - m->nodes[link->destination_id].x;
+    float dy = m->nodes[link->source_id].y - m->nodes[link->destination_id].y;
+    link->length = sqrtf(dx * dx + dy * dy);
+    link->latency = ( link->length * 10);
+}
+
+int init_mesh_link(mesh* m, int id, mesh_node* source, mesh_node* destination) {
+    if (m->link_count == m->link_capacity) {
+        int capacity = m->link_capacity ? m->link_capacity * 2 : 64;
+        mesh_link* links = (mesh_link*)mesh_arena_realloc(&m->arena, m->links, sizeof(mesh_link) * m->link_capacity, sizeof(mesh_link) * capacity);
+        if (!links) {
+            return -1;
+        }
+        m->links = links;
+        m->link_capacity = capacity;
+    }
+    MESH_COUNT(MESH_COUNT_LINKS_ADDED, 1);
+    int index = m->link_count++;
+    mesh_link* link = &m->links[index];
+    link->id = id;
+    link->bandwidth = m->config.bandwidth; // Decrease bandwidth with length
+    link->source_id = source->id;
+    link->destination_id = destination->id;
+    mesh_measure_link(m, link);
+    if (id >= m->next_link_id) m->next_link_id = id + 1;
 
-    if (source->output_link_count < 1) {
-        source->output_link_count++;
-        source->output_link[0] = link;
-    }else {
-        source->output_link_count++;
-        source->output_link[1] = link;
+    source->output_link_count++;
+    if (source->node_status != INACTIVE) source->node_status = CONNECTED; // Inactive until told otherwise
+    destination->input_link_count++;
+    m->soa.output_link_count[source->id]++;
+    m->soa.node_status[source->id] = (unsigned char)source->node_status;
+    m->soa.input_link_count[destination->id]++;
+    mesh_csr_insert(m, index);
+    mesh_components_link(m, source->id, destination->id);
+    m->version++;
+    if (mesh_spt_links_better(m, &index, 1) != 0) {
+        return -1;
     }
-    source->node_status = CONNECTED;
-    destination->input_links[++destination->input_link_count] = &link;
     return source->output_link_count;
 }
 
+int get_node_in_range(mesh* m, int start_id, float range, int* ids, int max_ids) {
+    mesh_node* start = &m->nodes[start_id];
+    return mesh_grid_query(m, start->x, start->y, range, start_id, ids, max_ids);
+}
+
+int count_nodes_within_range(mesh* m, int start_id, float range) {
+    mesh_node* start = &m->nodes[start_id];
+    return mesh_grid_query(m, start->x, start->y, range, start_id, NULL, 0);
+}
+
+int mesh_link_candidates(mesh* m, int source_id, int* ids, int max_ids) {
+    return get_node_in_range(m, source_id, m->config.max_link_distance, ids, max_ids);
+}
+
+int path_length_between_nodes(mesh* m, int start_id, int target_id) {
+    mesh_sssp* sp = mesh_shortest_paths(m, start_id, target_id, METRIC_LATENCY);
+    if (!sp || !mesh_sssp_reached(sp, target_id)) {
+        return -1;
+    }
+    return sp->hops[target_id];
+}
+
 mesh_path* init_mesh_path(mesh_path* path,int id, int start_node_id, int end_node_id) {
     path->id = id;
-    path->start_node_id = -1;
-    path->end_node_id = -1;
+    path->start_node_id = start_node_id;
+    path->end_node_id = end_node_id;
     path->length = 0;
-    path->nodes = NULL;
+    path->first = 0;
+    path->capacity = 0;
+    path->tree = -1;
+    path->lazy = false;
     return path;
 }
 
+mesh_path* mesh_append_path(mesh* m, int start_node_id, int end_node_id, int node_count) {
+    if (m->path_count == m->path_capacity) {
+        int capacity = m->path_capacity ? m->path_capacity * 2 : 16;
+        mesh_path* paths = (mesh_path*)mesh_arena_realloc(&m->arena, m->paths, sizeof(mesh_path) * m->path_capacity, sizeof(mesh_path) * capacity);
+        if (!paths) {
+            return NULL;
+        }
+        m->paths = paths;
+        m->path_capacity = capacity;
+    }
+    mesh_path* path = init_mesh_path(&m->paths[m->path_count], m->path_count, start_node_id, end_node_id);
+    if (mesh_path_reserve(m, path, node_count) != 0) {
+        return NULL;
+    }
+    path->length = node_count;
+    m->path_count++;
+    return path;
+}
+
+static int path_slice_compare(const void* a, const void* b) {
+    uint64_t x = *(const uint64_t*)a, y = *(const uint64_t*)b;
+    return x < y ? -1 : x > y;
+}
+
+// Slides the slices of the stored paths down over the ones left behind, in buffer order
+static void path_compact(mesh* m) {
+    int count = 0;
+    for (int i = 0; i < m->path_count; i++) {
+        if (m->paths[i].capacity > 0) count++;
+    }
+    uint64_t* slices = (uint64_t*)malloc(sizeof(uint64_t) * (count > 0 ? count : 1));
+    if (!slices) {
+        return; // The buffer grows instead
+    }
+    count = 0;
+    for (int i = 0; i < m->path_count; i++) {
+        if (m->paths[i].capacity > 0) slices[count++] = (uint64_t)m->paths[i].first << 32 | (uint32_t)i;
+    }
+    qsort(slices, count, sizeof(uint64_t), path_slice_compare);
+    uint32_t used = 0;
+    for (int i = 0; i < count; i++) {
+        mesh_path* path = &m->paths[(uint32_t)slices[i]];
+        memmove(m->path_nodes + used, m->path_nodes + path->first, sizeof(uint32_t) * path->capacity);
+        path->first = used;
+        used += path->capacity;
+    }
+    free(slices);
+    m->path_node_count = used;
+    m->path_node_waste = 0;
+}
+
+int mesh_path_reserve(mesh* m, mesh_path* path, int node_count) {
+    if (node_count <= path->capacity) {
+        return 0;
+    }
+    m->path_node_waste += path->capacity;
+    path->capacity = 0;
+    uint32_t needed = (uint32_t)node_count;
+    if (needed > m->path_node_capacity - m->path_node_count) {
+        if (m->path_node_waste * 3 >= m->path_node_count) {
+            path_compact(m);
+        }
+        if (needed > m->path_node_capacity - m->path_node_count) {
+            if (needed > UINT32_MAX / 2 - m->path_node_count) {
+                return -1;
+            }
+            uint32_t capacity = m->path_node_capacity ? m->path_node_capacity : 1024;
+            while (capacity < m->path_node_count + needed) capacity *= 2;
+            uint32_t* nodes = (uint32_t*)mesh_arena_realloc(&m->arena, m->path_nodes, sizeof(uint32_t) * m->path_node_capacity, sizeof(uint32_t) * (size_t)capacity);
+            if (!nodes) {
+                return -1;
+            }
+            m->path_nodes = nodes;
+            m->path_node_capacity = capacity;
+        }
+    }
+    path->first = m->path_node_count;
+    path->capacity = node_count;
+    m->path_node_count += needed;
+    return 0;
+}
+
+const uint32_t* mesh_path_nodes(mesh* m, mesh_path* path) {
+    if (!path->lazy) {
+        return path->capacity >= path->length && m->path_nodes ? m->path_nodes + path->first : NULL;
+    }
+    if (!m->path_scratch) {
+        m->path_scratch = (uint32_t*)mesh_arena_alloc(&m->arena, sizeof(uint32_t) * m->node_count);
+        if (!m->path_scratch) {
+            return NULL;
+        }
+    }
+    path->length = mesh_spt_walk(m, path->tree, path->end_node_id, m->path_scratch);
+    return m->path_scratch;
+}
+
+int mesh_total_paths(const mesh* m) {
+    return m->path_count + m->spt.lazy_count;
+}
+
+mesh_path* mesh_path_next(mesh* m, mesh_path_cursor* cursor) {
+    if (cursor->index < m->path_count) {
+        return &m->paths[cursor->index++];
+    }
+    if (cursor->index == m->path_count) {
+        cursor->tree = 0;
+        cursor->end = -1;
+    }
+    for (; cursor->tree < m->spt.count; cursor->tree++, cursor->end = -1) {
+        cursor->end = mesh_spt_next_lazy(m, cursor->tree, cursor->end);
+        if (cursor->end >= 0) {
+            mesh_path* path = init_mesh_path(&cursor->path, cursor->index++, m->spt.trees[cursor->tree].source_id, cursor->end);
+            path->tree = cursor->tree;
+            path->lazy = true;
+            return path;
+        }
+    }
+    return NULL;
+}
+
 int MESH_SAVEDUMP(mesh* m, enum data d) {
-    FILE* file = fopen("mesh_data.csv", "w");
+    return mesh_savedump_file(m, d, "mesh_data.csv");
+}
+
+int mesh_savedump_file(mesh* m, enum data d, const char* filename) {
+    MESH_TIMED(MESH_TIME_DUMP);
+    FILE* file = fopen(filename, "w");
     if (!file) {
         return -1; // Failure to open file
     }
@@ -107,28 +333,46 @@ int MESH_SAVEDUMP(mesh* m, enum data d) {
             mesh_node* node = &m->nodes[i];
             fprintf(file, "%d,%.2f,%.2f,%d,%d\n", node->id, node->x, node->y, node->node_status, node->node_type);
         }
+        // Each component is named after its representative node
+        mesh_component_count(m);
+        fprintf(file, "ComponentID,Size\n");
+        for (int i = 0; i < m->node_count; i++) {
+            if (mesh_component_of(m, i) == i) {
+                fprintf(file, "%d,%d\n", i, m->components.size[i]);
+            }
+        }
+        // Betweenness is only written once computed for the current mesh, see mesh_centrality.h
+        mesh_centrality* c = mesh_get_centrality(m);
+        if (c) {
+            fprintf(file, "CentralityNodeID,Betweenness\n");
+            for (int i = 0; i < m->node_count; i++) {
+                fprintf(file, "%d,%.6g\n", i, c->node[i]);
+            }
+            fprintf(file, "CentralityLinkID,Betweenness\n");
+            for (int i = 0; i < m->link_count; i++) {
+                fprintf(file, "%d,%.6g\n", m->links[i].id, c->link[i]);
+            }
+        }
     }
 
     if (d == LINKS || d == ALL) {
         fprintf(file, "LinkID,SourceID,DestinationID,Bandwidth,Latency\n");
-        for (int i = 0; i < m->node_count; i++) {
-            if (m->nodes[i].output_link_count == 0) continue;
-            if (m->nodes[i].output_link_count >= 1) {
-                mesh_link* link = &m->nodes[i].output_link[0];
-                fprintf(file, "%d,%d,%d,%.2f,%.2f\n", link->id, link->source->id, link->destination->id, link->bandwidth, link->latency);
-            }
-            if (m->nodes[i].output_link_count == 2) {
-                mesh_link* link = &m->nodes[i].output_link[1];
-                fprintf(file, "%d,%d,%d,%.2f,%.2f\n", link->id, link->source->id, link->destination->id, link->bandwidth, link->latency);
-            }
+        for (int i = 0; i < m->link_count; i++) {
+            mesh_link* link = &m->links[i];
+            fprintf(file, "%d,%d,%d,%.2f,%.2f\n", link->id, link->source_id, link->destination_id, link->bandwidth, link->latency);
         }
     }
 
     if (d == PATHS || d == ALL) {
-        fprintf(file, "PathStartID,PathEndID,Length\n");
-        for (int i = 0; i < m->path_count; i++) {
-            mesh_path* path = &m->paths[i];
-            fprintf(file, "%d,%d,%d\n", path->start_node_id, path->end_node_id, path->length);
+        fprintf(file, "PathStartID,PathEndID,Length,Nodes\n");
+        mesh_path_cursor cursor = {0};
+        for (mesh_path* path = mesh_path_next(m, &cursor); path; path = mesh_path_next(m, &cursor)) {
+            const uint32_t* nodes = mesh_path_nodes(m, path);
+            fprintf(file, "%d,%d,%d,", path->start_node_id, path->end_node_id, path->length);
+            for (int j = 0; nodes && j < path->length; j++) {
+                fprintf(file, j > 0 ? " %u" : "%u", nodes[j]);
+            }
+            fputc('\n', file);
         }
     }
 
@@ -142,11 +386,7 @@ void mesh_debug_print_node(mesh_node* node) {
     printf("Status: %d     ", node->node_status);
     printf("Type: %d       ", node->node_type);
     printf("Input Links Count: %d        ", node->input_link_count);
-    if (node->output_link) {
-        printf("Output Link ID: %d       \n", node->output_link->id);
-    } else {
-        printf("No Output Link\n");
-    }
+    printf("Output Links Count: %d       \n", node->output_link_count);
 }
 
 void mesh_debug_print_link(mesh_link* link) {
@@ -154,42 +394,93 @@ void mesh_debug_print_link(mesh_link* link) {
     printf("Bandwidth: %.2f Mbps       ", link->bandwidth);
     printf("Latency: %.2f ms           ", link->latency);
     printf("Length: %.2f meters        ", link->length);
-    printf("Source Node ID: %d         ", link->source->id);
-    printf("Destination Node ID: %d    \n", link->destination->id);
+    printf("Source Node ID: %d         ", link->source_id);
+    printf("Destination Node ID: %d    \n", link->destination_id);
 }
 
-void mesh_debug_print_path(mesh_path* path) {
+void mesh_debug_print_path(mesh* m, mesh_path* path) {
+    const uint32_t* nodes = mesh_path_nodes(m, path);
     printf("Path Start Node ID: %d   ", path->start_node_id);
     printf("Path End Node ID: %d     ", path->end_node_id);
     printf("Path Length: %d          ", path->length);
     printf("Nodes in Path:       ");
-    for (int i = 0; i < path->length; i++) {
-        printf("%d    ", path->nodes[i].id);
+    for (int i = 0; nodes && i < path->length; i++) {
+        printf("%u    ", nodes[i]);
     }
     printf("\n");
 }
 
+// Aggregates instead of one line per element, assembled in memory and written at once
+static void mesh_debug_print_summary(mesh* m) {
+    int status_count[4] = {0};
+    int routers = 0;
+    int max_in = 0, max_out = 0;
+    for (int i = 0; i < m->node_count; i++) {
+        mesh_node* node = &m->nodes[i];
+        if (node->node_status >= DISCONNECTED && node->node_status <= INACTIVE) status_count[node->node_status]++;
+        if (node->node_type == ROUTER) routers++;
+        if (node->input_link_count > max_in) max_in = node->input_link_count;
+        if (node->output_link_count > max_out) max_out = node->output_link_count;
+    }
+    double length = 0.0, latency = 0.0;
+    float min_length = INFINITY, max_length = 0.0f;
+    for (int i = 0; i < m->link_count; i++) {
+        mesh_link* link = &m->links[i];
+        length += link->length;
+        latency += link->latency;
+        if (link->length < min_length) min_length = link->length;
+        if (link->length > max_length) max_length = link->length;
+    }
+    long path_nodes = 0;
+    int reached = 0;
+    mesh_path_cursor cursor = {0};
+    for (mesh_path* path = mesh_path_next(m, &cursor); path; path = mesh_path_next(m, &cursor)) {
+        if (path->lazy) mesh_path_nodes(m, path);
+        path_nodes += path->length;
+        if (path->length > 0) reached++;
+    }
+    int links = m->link_count > 0 ? m->link_count : 1;
+    int nodes = m->node_count > 0 ? m->node_count : 1;
+    char buffer[2048];
+    int size = snprintf(buffer, sizeof(buffer),
+        "Mesh Name: %s\n"
+        "Nodes: %d (routers %d, end devices %d) over %.1f x %.1f m\n"
+        "Status: disconnected %d, connected %d, active %d, inactive %d\n"
+        "Links: %d, mean degree %.2f, max input %d, max output %d\n"
+        "Link length: min %.2f, mean %.2f, max %.2f m, mean latency %.2f ms\n"
+        "Components: %d, largest %d\n"
+        "Paths: %d, %d reachable, mean length %.2f nodes\n",
+        m->name, m->node_count, routers, m->node_count - routers, m->size_x, m->size_y,
+        status_count[DISCONNECTED], status_count[CONNECTED], status_count[ACTIVE], status_count[INACTIVE],
+        m->link_count, (double)m->link_count / nodes, max_in, max_out,
+        m->link_count > 0 ? min_length : 0.0f, length / links, max_length, latency / links,
+        mesh_component_count(m), m->components.largest,
+        mesh_total_paths(m), reached, reached > 0 ? (double)path_nodes / reached : 0.0);
+    fwrite(buffer, 1, size < (int)sizeof(buffer) ? (size_t)size : sizeof(buffer) - 1, stdout);
+}
+
 void mesh_debug_print_mesh(mesh* m) {
+    if (m->node_count > MESH_DEBUG_PRINT_LIMIT) {
+        mesh_debug_print_summary(m);
+        return;
+    }
     printf("Mesh Name: %s     ", m->name);
     printf("Node Count: %d    ", m->node_count);
     printf("Link Count: %d    ", m->link_count);
-    printf("Path Count: %d    ", m->path_count);
+    printf("Path Count: %d    ", mesh_total_paths(m));
+    printf("Components: %d    ", mesh_component_count(m));
+    printf("Largest Component: %d    ", m->components.largest);
     printf("\nNodes:\n");
     for (int i = 0; i < m->node_count; i++) {
         mesh_debug_print_node(&m->nodes[i]);
     }
     printf("\nLinks:\n");
-    for (int i = 0; i < m->node_count; i++) {
-        if (m->nodes[i].output_link_count == 0) continue;
-        if (m->nodes[i].output_link_count >= 1) {
-            mesh_debug_print_link(&m->nodes[i].output_link[0]);
-        }
-        if (m->nodes[i].output_link_count == 2) {
-            mesh_debug_print_link(&m->nodes[i].output_link[1]);
-        }
+    for (int i = 0; i < m->link_count; i++) {
+        mesh_debug_print_link(&m->links[i]);
     }
     printf("\nPaths:\n");
-    for (int i = 0; i < m->path_count; i++) {
-        mesh_debug_print_path(&m->paths[i]);
+    mesh_path_cursor cursor = {0};
+    for (mesh_path* path = mesh_path_next(m, &cursor); path; path = mesh_path_next(m, &cursor)) {
+        mesh_debug_print_path(m, path);
     }
 }
\ No newline at end of file
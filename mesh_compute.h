@@ -6,6 +6,21 @@
 #include <string.h>
 #include <math.h>
 #include "mesh_settings.h"
+#include "mesh_arena.h"
+#include "mesh_config.h"
+#include "mesh_metrics.h"
+#include "mesh_grid.h"
+#include "mesh_soa.h"
+#include "mesh_place.h"
+#include "mesh_topology.h"
+#include "mesh_csr.h"
+#include "mesh_sssp.h"
+#include "mesh_spt.h"
+#include "mesh_route.h"
+#include "mesh_flow.h"
+#include "mesh_centrality.h"
+#include "mesh_bfs.h"
+#include "mesh_components.h"
 
 
 
@@ -16,7 +31,9 @@ typedef struct mesh_node mesh_node;
 typedef struct mesh_link mesh_link;
 
 
-typedef struct mesh_path mesh_path; 
+typedef struct mesh_path mesh_path;
+
+typedef struct mesh_path_cursor mesh_path_cursor;
 
 
 typedef struct mesh mesh; // Forward declaration
@@ -41,18 +58,71 @@ typedef enum data {
 }data;
 
 
-/// @brief Structure representing the mesh network. sizeof(mesh) = 160 bytes
+/// @brief Structure representing a path in the mesh network. sizeof(mesh_path) = 32 bytes
+/// Node IDs are read with mesh_path_nodes(), from mesh->path_nodes or, for lazy paths, from the tree of the start node.
+/// Lazy paths have no entry in mesh->paths, mesh_path_next() hands out a record for them.
+struct mesh_path{               /// Name of the path
+    int id;                     /// Unique identifier for the mesh path, its position in the order of mesh_path_next(). -1 in the record mesh_add_path() returns for a lazy path
+    int start_node_id;          /// ID of the starting node
+    int end_node_id;            /// ID of the ending node
+    int length;                 /// Number of nodes of the path, 0 while the end node is unreachable. Lazy paths update it when read
+    uint32_t first;             /// Index of the first node ID of the path in mesh->path_nodes
+    int capacity;               /// Number of node IDs reserved at first, 0 for lazy paths
+    int tree;                   /// Index in mesh->spt.trees of the tree maintaining the path, -1 if the path is not maintained
+    bool lazy;                  /// Only the tree is kept, the node IDs are walked from it when read
+};
+
+/// @brief Position in the paths of a mesh, zero-initialized before the first mesh_path_next().
+struct mesh_path_cursor{
+    int index;                  /// Number of paths returned so far
+    int tree;                   /// Index in mesh->spt.trees of the tree whose lazy paths are returned
+    int end;                    /// End node of the last lazy path returned from that tree, -1 before the first
+    mesh_path path;             /// Record of the last lazy path returned
+};
+
+
+/// @brief Structure representing the mesh network. sizeof(mesh) = 368 bytes
 struct mesh{
     char name[128];            /// Name of the mesh network
+    mesh_config config;        /// Parameters the mesh was created with, the fields below hold the current node count, area, seed, distribution and threads
     mesh_node* nodes;          /// Array of nodes in the mesh
     int node_count;            /// Number of nodes in the mesh
+    float size_x, size_y;      /// Size of the area the nodes are placed in, in meters
+    uint64_t seed;             /// Seed the nodes were placed with
+    mesh_distribution distribution; /// Distribution the nodes were placed with
+    int threads;               /// Workers of the parallel algorithms run on this mesh, 0 for every online core
     int link_count;            /// Number of links in the mesh
-    mesh_path* paths;          /// Array of paths in the mesh
-    int path_count;            /// Number of paths in the mesh
+    mesh_link* links;          /// Array of links in the mesh, removing a link moves the last one into its slot
+    int link_capacity;         /// Number of links the links array can hold
+    int next_link_id;          /// Id given to the next link added with mesh_add_link()
+    unsigned long version;     /// Incremented by every change of the links or of the node positions and statuses
+    mesh_path* paths;          /// Array of the stored paths, lazy paths are bits of the tree of their start node (see mesh_path_next())
+    int path_count;            /// Number of stored paths in the mesh
+    int path_capacity;         /// Number of paths the paths array can hold
+    uint32_t* path_nodes;      /// Node IDs of the stored paths, each path owns a slice of them
+    uint32_t path_node_count;  /// Node IDs used in path_nodes, slices left behind by paths that grew included
+    uint32_t path_node_capacity; /// Number of node IDs path_nodes can hold
+    uint32_t path_node_waste;  /// Node IDs in slices left behind, reclaimed when path_nodes is full
+    uint32_t* path_scratch;    /// Node IDs of the last lazy path read, node_count entries
+    mesh_path lazy_path;       /// Record of the last lazy path added with mesh_add_path()
+    mesh_grid grid;            /// Spatial index over the node positions
+    mesh_soa soa;              /// Node positions, link counts and statuses as separate arrays
+    mesh_components components; /// Connected components, updated as links are added
+    mesh_csr csr;              /// Adjacency used by the graph algorithms
+    mesh_sssp sssp;            /// Shortest path scratch buffers reused across queries
+    mesh_spt_set spt;          /// Shortest path trees keeping the stored paths up to date
+    mesh_routes routes;        /// Next-hop tables of the routers, rebuilt when version moves on
+    mesh_flow flow;            /// Residual network of the flow queries, rebuilt when version moves on
+    mesh_centrality centrality; /// Betweenness of the nodes and links, valid for the version it was computed at
+    mesh_bfs* bfs;             /// Breadth first search scratch buffers, one per worker thread
+    int bfs_count;             /// Number of workers with BFS scratch buffers
+    mesh_arena arena;          /// Arena holding the mesh and everything it owns
+    mesh_arena_mark arena_mark; /// Arena position right after the nodes, their mirror and the grid
 };
 
 
-///@brief Structure representing a node in the mesh network. sizeof(mesh_node) = 48 bytes
+///@brief Structure representing a node in the mesh network. sizeof(mesh_node) = 28 bytes
+/// Links of a node are found through mesh->csr.
 struct mesh_node{
     int id;                       /// Unique identifier for the mesh node
     int input_link_count;         /// Number of input links connected to this node
@@ -60,8 +130,6 @@ struct mesh_node{
     float x, y;                   /// Coordinates of the node in 2D space
     status node_status;           /// Status of the node (e.g., ACTIVE, INACTIVE)
     type node_type;               /// Type of the node (e.g., ROUTER, END_DEVICE)
-    mesh_link* output_link;       /// Output link connected to this node
-    mesh_link** input_links;      /// Array of input links (up to 8)
 };
 
 /// @brief Structure representing a link in the mesh network. sizeof(mesh_link) = 32 bytes
@@ -70,113 +138,218 @@ struct mesh_link{
     float bandwidth;             /// Bandwidth of the link in Mbps
     float latency;               /// Latency of the link in ms
     float length;                /// Length of the link in meters
-    mesh_node* source;           /// Source node of the link
-    mesh_node* destination;      /// Destination node of the link
+    int source_id;               /// Index in mesh->nodes of the source node
+    int destination_id;          /// Index in mesh->nodes of the destination node
 };
 
 
-/// @brief Structure representing a path in the mesh network. sizeof(mesh_path) = 24 bytes
-struct mesh_path{               /// Name of the path
-    int id;                     /// Unique identifier for the mesh path
-    int start_node_id;          /// ID of the starting node
-    int end_node_id;            /// ID of the ending node
-    int length;                 /// Length of the path
-    mesh_node* nodes;           /// Array of nodes in the path
-};
+///@brief Initializes a mesh network with the given name and parameters.
+///@param name The name of the mesh network.
+///@param config The parameters of the mesh, copied into it, NULL for the defaults of mesh_settings.h.
+///@return mesh* A pointer to the initialized mesh structure, NULL on allocation failure.
+mesh* init_mesh(const char* name, const mesh_config* config);
 
-///@brief Initializes a mesh network with the given name.
+///@brief Initializes a mesh network with a given number of nodes and the default parameters.
 ///@param name The name of the mesh network.
-///@return mesh* A pointer to the initialized mesh structure.
-mesh* init_mesh(const char* name);
+///@param node_count The number of nodes to place.
+///@return mesh* A pointer to the initialized mesh structure, NULL on allocation failure.
+mesh* init_mesh_sized(const char* name, int node_count);
 
-///@brief Frees the resources allocated for the mesh network.
-///@param m A double pointer to the mesh structure to be freed.
+///@brief Initializes a mesh network with a given number of nodes spread over a given area and the default parameters.
+///@param name The name of the mesh network.
+///@param node_count The number of nodes to place.
+///@param size_x The width of the area in meters.
+///@param size_y The height of the area in meters.
+///@return mesh* A pointer to the initialized mesh structure, NULL on allocation failure.
+mesh* init_mesh_area(const char* name, int node_count, float size_x, float size_y);
+
+///@brief Frees the resources allocated for the mesh network, including the mesh structure itself.
+///@param m A pointer to the mesh structure to be freed.
 void free_mesh(mesh* m);
 
+///@brief Drops every link and path of the mesh and places its nodes again from its seed, reusing the mesh memory.
+///@param m A pointer to the mesh structure to reset.
+///@return int 0 on success, -1 if the spatial index or the components could not be allocated, the mesh then
+/// only being fit for another reset_mesh() or free_mesh().
+int reset_mesh(mesh* m);
+
 /// @brief Initialize a mesh node with the given id.
 /// @param m the adresse of the node to initialize
 /// @param id the id of the node
+/// @param config the parameters of the mesh, the first router_count ids are routers
 /// @return A pointer to the initialized mesh_node structure
-mesh_node* init_mesh_node(mesh_node* m,int id);
+mesh_node* init_mesh_node(mesh_node* m,int id, const mesh_config* config);
 
 
 
 /// @brief Check if a link can be created between two nodes based on distance and existing links.
+/// @param m The mesh owning the nodes, whose configuration gives the distance and the link caps.
 /// @param source The source mesh node.
 /// @param destination The destination mesh node.
 /// @return True if a link can be created, false otherwise.
-bool mesh_link_allowed(mesh_node* source, mesh_node* destination);
+bool mesh_link_allowed(mesh* m, mesh_node* source, mesh_node* destination);
 
 
 
-/// @brief create a link between two nodes
-/// @param m the adresse of the link to initialize
+/// @brief create a link between two nodes and append it to the mesh links
+/// @param m the mesh owning the link
 /// @param id the id of the link
 /// @param source the source node of the link
 /// @param destination the destination node of the link
-/// @return the number of output links of the source node after initialization
-int init_mesh_link(int id, mesh_node* source, mesh_node* destination);
+/// @return the number of output links of the source node after initialization, -1 on allocation failure
+int init_mesh_link(mesh* m, int id, mesh_node* source, mesh_node* destination);
+
+
 
+/// @brief Compute the length and latency of a link from the position of its nodes
+/// @param m the mesh holding the nodes of the link
+/// @param link the link to measure
+void mesh_measure_link(mesh* m, mesh_link* link);
 
 
+
+/// @brief Initialize an empty path between two nodes
+/// @param m the adresse of the path to initialize
+/// @param id the id of the path
+/// @param start_id the id of the starting node
+/// @param end_id the id of the ending node
+/// @return A pointer to the initialized mesh_path structure
 mesh_path* init_mesh_path(mesh_path* m, int id, int start_id, int end_id);
 
-///@brief Computes the mesh network based on the provided nodes.
-///@param nodes An array of mesh_node structures representing the mesh nodes.
-///@param node_count The number of nodes in the array.
+/// @brief Append a path to the mesh with room for its nodes
+/// @param m the mesh owning the path
+/// @param start_id the id of the starting node
+/// @param end_id the id of the ending node
+/// @param node_count the number of nodes on the path, their IDs are left to fill at mesh->path_nodes + path->first
+/// @return A pointer to the new path, NULL on allocation failure
+mesh_path* mesh_append_path(mesh* m, int start_id, int end_id, int node_count);
+
+/// @brief Makes room for the node IDs of a path in mesh->path_nodes. A path that grows moves to a new slice, the
+/// slices left behind are reclaimed by sliding the others down once the buffer is full and they make up a third of it.
+/// @param m the mesh owning the path
+/// @param path the path, its node IDs are left to fill at mesh->path_nodes + path->first
+/// @param node_count the number of nodes on the path
+/// @return 0 on success, -1 on allocation failure
+int mesh_path_reserve(mesh* m, mesh_path* path, int node_count);
+
+/// @brief Node IDs of a path, from its start to its end node
+/// @param m the mesh owning the path
+/// @param path the path, lazy paths are walked from their tree and get their length updated
+/// @return path->length node IDs, those of a lazy path stay valid until the next lazy path is read. NULL when the nodes
+/// were never stored (a loaded path with only a length) or on allocation failure
+const uint32_t* mesh_path_nodes(mesh* m, mesh_path* path);
+
+/// @brief Number of paths of the mesh, the stored ones and the lazy ones
+/// @param m the mesh owning the paths
+/// @return mesh->path_count plus the lazy paths of the trees
+int mesh_total_paths(const mesh* m);
+
+/// @brief Steps through every path of the mesh, the stored ones in mesh->paths then the lazy ones by tree and end node
+/// @param m the mesh owning the paths
+/// @param cursor the position, zero-initialized to start
+/// @return the next path, NULL after the last. A lazy path is a record of the cursor, valid until its next step
+mesh_path* mesh_path_next(mesh* m, mesh_path_cursor* cursor);
+
+
+/// Topology updates. Each keeps link lengths and latencies, link counts, the adjacency and the
+/// stored paths consistent, and costs about the number of links and routes it changes.
+
+///@brief Moves a node, updating the length and latency of its links. Links are kept even out of range.
+///@param m A pointer to the mesh structure.
+///@param id The ID of the node.
+///@param x The new X coordinate.
+///@param y The new Y coordinate.
+///@return int 0 on success, -1 on allocation failure.
+int mesh_move_node(mesh* m, int id, float x, float y);
+
+///@brief Changes the status of a node. INACTIVE nodes keep their links but routes avoid them.
+///@param m A pointer to the mesh structure.
+///@param id The ID of the node.
+///@param node_status The new status.
+///@return int 0 on success, -1 on allocation failure.
+int mesh_set_node_status(mesh* m, int id, status node_status);
+
+///@brief Adds a link between two nodes, without checking mesh_link_allowed().
+///@param m A pointer to the mesh structure.
+///@param source_id The ID of the source node.
+///@param destination_id The ID of the destination node.
+///@return int The index of the link in mesh->links, -1 on allocation failure.
+int mesh_add_link(mesh* m, int source_id, int destination_id);
+
+///@brief Removes a link. The last link of mesh->links moves into the freed slot.
+///@param m A pointer to the mesh structure.
+///@param link The index of the link in mesh->links.
+///@return int 0 on success, -1 on allocation failure.
+int mesh_remove_link(mesh* m, int link);
+
+///@brief Simulates sink traffic over the mesh: every node streams packets to the last node,
+/// then per-link and per-flow statistics are written to mesh_sim.csv.
+///@param m A pointer to the mesh structure.
 ///@return int A status code indicating success or failure.
-int compute_mesh(mesh_node* nodes, int node_count);
+int compute_mesh(mesh* m);
 
 
 ///@brief list all nodes within a certain range from a given node id.
-///@param nodes An array of mesh_node structures representing the mesh nodes.
-///@param node_count The number of nodes in the array.
+///@param m A pointer to the mesh structure.
 ///@param start_id The ID of the starting node.
 ///@param range The distance range to search for nodes.
-///@return mesh_node* A pointer to an array of mesh_node structures found within the specified range
-mesh_node* get_node_in_range(mesh_node* nodes, int node_count, int start_id, float range);
+///@param ids Output buffer receiving the IDs of the nodes found.
+///@param max_ids The capacity of the ids buffer.
+///@return int The number of nodes found within the range, which may exceed max_ids.
+int get_node_in_range(mesh* m, int start_id, float range, int* ids, int max_ids);
 
 
 ///@brief Count all nodes within a certain range from a given node id.
-///@param nodes An array of mesh_node structures representing the mesh nodes.
-///@param node_count The number of nodes in the array.
+///@param m A pointer to the mesh structure.
 ///@param start_id The ID of the starting node.
 ///@param range The distance range to search for nodes.
 ///@return int The count of nodes found within the specified range.
-int count_nodes_within_range(mesh_node* nodes, int node_count, int start_id, float range);
+int count_nodes_within_range(mesh* m, int start_id, float range);
+
+
+///@brief List the nodes close enough to receive a link from a given node.
+///@param m A pointer to the mesh structure.
+///@param source_id The ID of the source node.
+///@param ids Output buffer receiving the IDs of the candidate nodes.
+///@param max_ids The capacity of the ids buffer.
+///@return int The number of candidates within the max link distance of the mesh, which may exceed max_ids.
+int mesh_link_candidates(mesh* m, int source_id, int* ids, int max_ids);
 
 
-///@brief Check if a target node is in the same network as the start node.
-///@param nodes An array of mesh_node structures representing the mesh nodes.
-///@param node_count The number of nodes in the array.
+///@brief Check if a target node is in the same network as the start node, links taken in both directions.
+///@param m A pointer to the mesh structure.
 ///@param start_id The ID of the starting node.
 ///@param target_id The ID of the target node.
 ///@return bool True if the target node is reachable from the start node, false otherwise.
-bool is_node_reachable(mesh_node* nodes, int node_count, int start_id, int target_id);
+bool is_node_reachable(mesh* m, int start_id, int target_id);
 
 
 ///@brief Calculate the path length between two nodes in the mesh network.
-///@param nodes An array of mesh_node structures representing the mesh nodes.
-///@param node_count The number of nodes in the array.
+///@param m A pointer to the mesh structure.
 ///@param start_id The ID of the starting node.
 ///@param target_id The ID of the target node.
-///@return int The length of the path between the two nodes.
-int path_length_between_nodes(mesh_node* nodes, int node_count, int start_id, int target_id);   
+///@return int The number of links of the lowest latency path between the two nodes, -1 if unreachable.
+int path_length_between_nodes(mesh* m, int start_id, int target_id);
 
 
 ///@brief Find the maximum length path from a given start node id.
-///@param nodes An array of mesh_node structures representing the mesh nodes.
-///@param node_count The number of nodes in the array.
+///@param m A pointer to the mesh structure.
 ///@param start_id The ID of the starting node.
-///@return int The maximum length path from the start node.
-int max_length_path_rel(mesh_node* nodes, int node_count, int start_id);
+///@return int The largest number of hops from the start node to a node it can reach.
+int max_length_path_rel(mesh* m, int start_id);
 
 
-///@brief Find the maximum length path in the entire mesh network.
-///@param nodes An array of mesh_node structures representing the mesh nodes.
-///@param node_count The number of nodes in the array.
-///@return int The maximum length path in the entire mesh network.
-int max_length_path_abs(mesh_node* nodes, int node_count);
+///@brief Find the maximum length path in the entire mesh network, sweeping every node on mesh->threads workers.
+///@param m A pointer to the mesh structure.
+///@return int The hop diameter of the mesh, over the pairs of nodes that can reach each other.
+int max_length_path_abs(mesh* m);
+
+
+///@brief Same result as max_length_path_abs(), pruning the sweeps with distance bounds (directed iFUB).
+/// Falls back to the full sweep when the mesh is not strongly connected.
+///@param m A pointer to the mesh structure.
+///@return int The hop diameter of the mesh.
+int max_length_path_abs_bounded(mesh* m);
 
 
 
@@ -187,9 +360,18 @@ int max_length_path_abs(mesh_node* nodes, int node_count);
 ///@return int A status code indicating of element save or -1 failure.
 int MESH_SAVEDUMP(mesh* m, enum data d);
 
+///@brief Save or dump the mesh network data to a CSV file.
+/// The node data is followed by the betweenness of the nodes and links when mesh_get_centrality() has current scores.
+///@param m A pointer to the mesh structure representing the mesh network.
+///@param data An enum indicating wich data to save.
+///@param filename The path of the CSV file.
+///@return int A status code indicating of element save or -1 failure.
+int mesh_savedump_file(mesh* m, enum data d, const char* filename);
+
 
 
 void mesh_debug_print_node(mesh_node* node);
 void mesh_debug_print_link(mesh_link* link);
-void mesh_debug_print_path(mesh_path* path);
+void mesh_debug_print_path(mesh* m, mesh_path* path);
+///@brief Prints every node, link and path, or a summary once the mesh has more than MESH_DEBUG_PRINT_LIMIT nodes.
 void mesh_debug_print_mesh(mesh* m);
\ No newline at end of file
@@ -0,0 +1,247 @@
+#include <ctype.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+#include "mesh_config.h"
+
+#define CONFIG_KEY_SIZE 64
+#define CONFIG_LINE_SIZE 512
+
+typedef enum config_type {
+    CONFIG_INT,
+    CONFIG_FLOAT,
+    CONFIG_DOUBLE,
+    CONFIG_U64,
+    CONFIG_BOOL,
+    CONFIG_DISTRIBUTION,
+    CONFIG_TOPOLOGY
+} config_type;
+
+typedef struct config_key {
+    const char* name;
+    config_type type;
+    size_t offset;
+    double min;                 /// Smallest value accepted for the numeric types
+} config_key;
+
+static const config_key config_keys[] = {
+    { "node_count", CONFIG_INT, offsetof(mesh_config, node_count), 1 },
+    { "router_count", CONFIG_INT, offsetof(mesh_config, router_count), 0 },
+    { "max_input_links", CONFIG_INT, offsetof(mesh_config, max_input_links), 0 },
+    { "max_output_links", CONFIG_INT, offsetof(mesh_config, max_output_links), 0 },
+    { "max_link_distance", CONFIG_FLOAT, offsetof(mesh_config, max_link_distance), 1e-3 },
+    { "size_x", CONFIG_FLOAT, offsetof(mesh_config, size_x), 1 },
+    { "size_y", CONFIG_FLOAT, offsetof(mesh_config, size_y), 1 },
+    { "bandwidth", CONFIG_FLOAT, offsetof(mesh_config, bandwidth), 0 },
+    { "seed", CONFIG_U64, offsetof(mesh_config, seed), 0 },
+    { "distribution", CONFIG_DISTRIBUTION, offsetof(mesh_config, distribution), 0 },
+    { "cluster_nodes", CONFIG_INT, offsetof(mesh_config, cluster_nodes), 1 },
+    { "cluster_spread", CONFIG_FLOAT, offsetof(mesh_config, cluster_spread), 0 },
+    { "topology", CONFIG_TOPOLOGY, offsetof(mesh_config, topology), 0 },
+    { "topology_neighbors", CONFIG_INT, offsetof(mesh_config, topology_neighbors), 0 },
+    { "threads", CONFIG_INT, offsetof(mesh_config, threads), 0 },
+    { "route_compress", CONFIG_BOOL, offsetof(mesh_config, route_compress), 0 },
+    { "lazy_paths", CONFIG_BOOL, offsetof(mesh_config, lazy_paths), 0 },
+    { "sim_packet_size", CONFIG_INT, offsetof(mesh_config, sim_packet_size), 1 },
+    { "sim_queue_limit", CONFIG_INT, offsetof(mesh_config, sim_queue_limit), 1 },
+    { "sim_flow_packets", CONFIG_INT, offsetof(mesh_config, sim_flow_packets), 0 },
+    { "sim_flow_interval", CONFIG_DOUBLE, offsetof(mesh_config, sim_flow_interval), 0 },
+    { "tile_count", CONFIG_INT, offsetof(mesh_config, tile_count), 1 },
+    { "tile_tick", CONFIG_DOUBLE, offsetof(mesh_config, tile_tick), 1e-6 },
+    { "tile_rebalance", CONFIG_INT, offsetof(mesh_config, tile_rebalance), 0 },
+    { "frame_width", CONFIG_INT, offsetof(mesh_config, frame_width), 1 },
+    { "frame_height", CONFIG_INT, offsetof(mesh_config, frame_height), 1 },
+    { "frame_tick", CONFIG_DOUBLE, offsetof(mesh_config, frame_tick), 1e-6 },
+};
+
+#define CONFIG_KEY_COUNT ((int)(sizeof(config_keys) / sizeof(config_keys[0])))
+
+static const char* config_distributions[] = { "uniform", "clustered", "poisson" };
+static const char* config_topologies[] = { "chain", "unit_disk", "gabriel", "rng", "knn", "capped_disk" };
+
+void mesh_config_defaults(mesh_config* config) {
+    memset(config, 0, sizeof(*config));
+    config->node_count = MESH_NODES_COUNT;
+    config->router_count = MESH_ROUTERS_COUNT;
+    config->max_input_links = MESH_MAX_LINKS_PER_NODE;
+    config->max_output_links = MESH_MAX_OUTPUT_LINKS;
+    config->max_link_distance = MESH_MAX_LINK_DISTANCE;
+    config->size_x = MESH_SIZE_X;
+    config->size_y = MESH_SIZE_Y;
+    config->bandwidth = MESH_DEFAULT_BANDWIDTH;
+    config->seed = MESH_SEED;
+    config->distribution = MESH_DISTRIBUTION;
+    config->cluster_nodes = MESH_CLUSTER_NODES;
+    config->cluster_spread = MESH_CLUSTER_SPREAD;
+    config->topology = MESH_TOPOLOGY;
+    config->topology_neighbors = MESH_TOPOLOGY_NEIGHBORS;
+    config->threads = MESH_THREADS;
+    config->route_compress = MESH_ROUTE_COMPRESS;
+    config->lazy_paths = MESH_LAZY_PATHS;
+    config->sim_packet_size = MESH_SIM_PACKET_SIZE;
+    config->sim_queue_limit = MESH_SIM_QUEUE_LIMIT;
+    config->sim_flow_packets = MESH_SIM_FLOW_PACKETS;
+    config->sim_flow_interval = MESH_SIM_FLOW_INTERVAL;
+    config->tile_count = MESH_TILE_COUNT;
+    config->tile_tick = MESH_TILE_TICK;
+    config->tile_rebalance = MESH_TILE_REBALANCE;
+    config->frame_width = MESH_FRAME_WIDTH;
+    config->frame_height = MESH_FRAME_HEIGHT;
+    config->frame_tick = MESH_FRAME_TICK;
+}
+
+static const config_key* config_find(const char* key) {
+    char name[CONFIG_KEY_SIZE];
+    size_t length = strlen(key);
+    if (length >= sizeof(name)) {
+        return NULL;
+    }
+    for (size_t i = 0; i <= length; i++) {
+        name[i] = key[i] == '-' ? '_' : key[i];
+    }
+    for (int k = 0; k < CONFIG_KEY_COUNT; k++) {
+        if (strcmp(config_keys[k].name, name) == 0) return &config_keys[k];
+    }
+    return NULL;
+}
+
+int mesh_config_set(mesh_config* config, const char* key, const char* value) {
+    const config_key* k = config_find(key);
+    if (!k || !value || !*value) {
+        return -1;
+    }
+    char* field = (char*)config + k->offset;
+    char* end;
+    switch (k->type) {
+        case CONFIG_BOOL:
+            if (strcmp(value, "true") == 0 || strcmp(value, "1") == 0) *(bool*)field = true;
+            else if (strcmp(value, "false") == 0 || strcmp(value, "0") == 0) *(bool*)field = false;
+            else return -1;
+            return 0;
+        case CONFIG_DISTRIBUTION:
+            for (int d = 0; d < (int)(sizeof(config_distributions) / sizeof(config_distributions[0])); d++) {
+                if (strcmp(value, config_distributions[d]) == 0) {
+                    *(mesh_distribution*)field = (mesh_distribution)d;
+                    return 0;
+                }
+            }
+            return -1;
+        case CONFIG_TOPOLOGY:
+            for (int t = 0; t < (int)(sizeof(config_topologies) / sizeof(config_topologies[0])); t++) {
+                if (strcmp(value, config_topologies[t]) == 0) {
+                    *(mesh_topology*)field = (mesh_topology)t;
+                    return 0;
+                }
+            }
+            return -1;
+        case CONFIG_U64: {
+            unsigned long long v = strtoull(value, &end, 0);
+            if (*end || value[0] == '-') return -1;
+            *(uint64_t*)field = v;
+            return 0;
+        }
+        default:
+            break;
+    }
+    double v = strtod(value, &end);
+    if (*end || v != v || v < k->min) {
+        return -1;
+    }
+    switch (k->type) {
+        case CONFIG_INT:
+            if (v > 2147483647.0 || v != (double)(int)v) return -1;
+            *(int*)field = (int)v;
+            break;
+        case CONFIG_FLOAT:
+            *(float*)field = (float)v;
+            break;
+        default:
+            *(double*)field = v;
+            break;
+    }
+    return 0;
+}
+
+int mesh_config_load(mesh_config* config, const char* filename) {
+    FILE* file = fopen(filename, "r");
+    if (!file) {
+        fprintf(stderr, "mesh_config: cannot read %s\n", filename);
+        return -1;
+    }
+    char line[CONFIG_LINE_SIZE];
+    int number = 0;
+    while (fgets(line, sizeof(line), file)) {
+        number++;
+        char* text = line;
+        while (isspace((unsigned char)*text)) text++;
+        if (*text == '\0' || *text == '#') continue;
+        char* equal = strchr(text, '=');
+        char* end = equal ? equal : text + strlen(text);
+        while (end > text && isspace((unsigned char)end[-1])) end--;
+        *end = '\0';
+        char* value = equal ? equal + 1 : end;
+        while (isspace((unsigned char)*value)) value++;
+        end = value + strlen(value);
+        while (end > value && isspace((unsigned char)end[-1])) end--;
+        *end = '\0';
+        if (!equal || mesh_config_set(config, text, value) != 0) {
+            fprintf(stderr, "mesh_config: %s:%d: bad setting '%s'\n", filename, number, text);
+            fclose(file);
+            return -1;
+        }
+    }
+    fclose(file);
+    return 0;
+}
+
+int mesh_config_parse(mesh_config* config, int argc, char* argv[]) {
+    for (int i = 0; i < argc; i++) {
+        const char* arg = argv[i];
+        if (strncmp(arg, "--", 2) != 0) {
+            fprintf(stderr, "mesh_config: unexpected argument '%s'\n", arg);
+            return -1;
+        }
+        char key[CONFIG_KEY_SIZE];
+        const char* value;
+        const char* equal = strchr(arg, '=');
+        size_t length = equal ? (size_t)(equal - arg - 2) : strlen(arg + 2);
+        if (length >= sizeof(key)) {
+            fprintf(stderr, "mesh_config: unknown option '%s'\n", arg);
+            return -1;
+        }
+        memcpy(key, arg + 2, length);
+        key[length] = '\0';
+        if (equal) {
+            value = equal + 1;
+        } else if (i + 1 < argc) {
+            value = argv[++i];
+        } else {
+            fprintf(stderr, "mesh_config: missing value after '%s'\n", arg);
+            return -1;
+        }
+        if (strcmp(key, "config") == 0) {
+            if (mesh_config_load(config, value) != 0) return -1;
+        } else if (mesh_config_set(config, key, value) != 0) {
+            fprintf(stderr, "mesh_config: bad option '--%s %s'\n", key, value);
+            return -1;
+        }
+    }
+    return 0;
+}
+
+void mesh_config_print(const mesh_config* config, FILE* file) {
+    for (int k = 0; k < CONFIG_KEY_COUNT; k++) {
+        const config_key* key = &config_keys[k];
+        const char* field = (const char*)config + key->offset;
+        fprintf(file, "%s = ", key->name);
+        switch (key->type) {
+            case CONFIG_INT: fprintf(file, "%d\n", *(const int*)field); break;
+            case CONFIG_FLOAT: fprintf(file, "%.9g\n", *(const float*)field); break;
+            case CONFIG_DOUBLE: fprintf(file, "%.17g\n", *(const double*)field); break;
+            case CONFIG_U64: fprintf(file, "%llu\n", (unsigned long long)*(const uint64_t*)field); break;
+            case CONFIG_BOOL: fprintf(file, "%s\n", *(const bool*)field ? "true" : "false"); break;
+            case CONFIG_DISTRIBUTION: fprintf(file, "%s\n", config_distributions[*(const mesh_distribution*)field]); break;
+            case CONFIG_TOPOLOGY: fprintf(file, "%s\n", config_topologies[*(const mesh_topology*)field]); break;
+        }
+    }
+}
@@ -0,0 +1,73 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include "mesh_settings.h"
+#include "mesh_place.h"
+#include "mesh_topology.h"
+
+typedef struct mesh_config mesh_config;
+
+
+/// @brief Parameters of a mesh, chosen at run time. mesh_config_defaults() gives the values of
+/// mesh_settings.h, files and command lines then override them key by key.
+struct mesh_config{
+    int node_count;             /// Number of nodes
+    int router_count;           /// The first N nodes are routers
+    int max_input_links;        /// Input links a node accepts
+    int max_output_links;       /// Output links a node opens
+    float max_link_distance;    /// In meters, also the side of the grid cells
+    float size_x, size_y;       /// Size of the area in meters
+    float bandwidth;            /// Bandwidth of new links in Mbps
+    uint64_t seed;              /// Seed of the node placement
+    mesh_distribution distribution; /// Distribution of the node positions
+    int cluster_nodes;          /// Average number of nodes per cluster (MESH_CLUSTERED)
+    float cluster_spread;       /// Standard deviation around a cluster center in meters (MESH_CLUSTERED)
+    mesh_topology topology;     /// Graph the program links the nodes into
+    int topology_neighbors;     /// Links each node opens with the knn topology, 0 for max_output_links
+    int threads;                /// Workers of the parallel algorithms, 0 for every online core
+    bool route_compress;        /// Store next hops as runs of destinations
+    bool lazy_paths;            /// Keep only the tree of each path source and walk the nodes when read
+    int sim_packet_size;        /// In bytes
+    int sim_queue_limit;        /// Packets waiting per link before drops
+    int sim_flow_packets;       /// Packets sent by each node to the gateway
+    double sim_flow_interval;   /// In ms between two packets of a flow
+    int tile_count;             /// Worker processes of a tiled simulation
+    double tile_tick;           /// In ms of simulated time between two synchronizations of the tiles
+    int tile_rebalance;         /// Ticks between two checks of the tile loads, 0 to keep the first boundaries
+    int frame_width;            /// Width of the offscreen frames in pixels
+    int frame_height;           /// Height of the offscreen frames in pixels
+    double frame_tick;          /// In ms of simulated time between two frames
+};
+
+
+///@brief Fills a configuration with the values of mesh_settings.h.
+///@param config The configuration to fill.
+void mesh_config_defaults(mesh_config* config);
+
+///@brief Sets one parameter from its text form.
+///@param config The configuration to update.
+///@param key The name of a field of mesh_config, dashes may replace the underscores.
+///@param value The value, distributions are uniform, clustered or poisson,
+/// topologies chain, unit_disk, gabriel, rng, knn or capped_disk, and booleans true or false.
+///@return int 0 on success, -1 on an unknown key or a value out of range.
+int mesh_config_set(mesh_config* config, const char* key, const char* value);
+
+///@brief Reads `key = value` lines, blank lines and lines starting with # are skipped.
+///@param config The configuration to update.
+///@param filename The path of the file.
+///@return int 0 on success, -1 if the file cannot be read or on the first bad line, reported on stderr.
+int mesh_config_load(mesh_config* config, const char* filename);
+
+///@brief Reads `--key value` and `--key=value` options, and `--config FILE` to load a file in between.
+///@param config The configuration to update.
+///@param argc The number of options.
+///@param argv The options, without the program name.
+///@return int 0 on success, -1 on the first bad option, reported on stderr.
+int mesh_config_parse(mesh_config* config, int argc, char* argv[]);
+
+///@brief Writes every parameter as `key = value` lines, the format mesh_config_load() reads.
+///@param config The configuration to write.
+///@param file The output stream.
+void mesh_config_print(const mesh_config* config, FILE* file);
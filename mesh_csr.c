@@ -0,0 +1,175 @@
+#include "mesh_compute.h"
+
+// Bytes needed by one direction: offsets and degrees, then node, link, bandwidth and latency per edge slot
+static size_t csr_block_size(int node_count, int edge_capacity) {
+    return sizeof(int) * (2 * (size_t)node_count + 1) + (2 * sizeof(int) + 2 * sizeof(float)) * (size_t)edge_capacity;
+}
+
+static void csr_carve(char* block, int node_count, int edge_capacity, int** offset, int** degree, int** node, int** link, float** bandwidth, float** latency) {
+    *offset = (int*)block;
+    *degree = *offset + node_count + 1;
+    *node = *degree + node_count;
+    *link = *node + edge_capacity;
+    *bandwidth = (float*)(*link + edge_capacity);
+    *latency = *bandwidth + edge_capacity;
+}
+
+// Slots given to a node of a given degree, the slack grows with the degree so busy nodes rarely overflow
+static int csr_slots(int degree) {
+    return degree + 1 + degree / 2;
+}
+
+int mesh_build_csr(mesh* m) {
+    MESH_TIMED(MESH_TIME_BUILD_CSR);
+    mesh_csr* csr = &m->csr;
+    int n = m->node_count;
+    int e = m->link_count;
+    // Upper bound of the sum of csr_slots() over the nodes
+    long needed = (long)e + e / 2 + n;
+
+    if (!csr->out_offset || csr->node_count != n || csr->edge_capacity < needed) {
+        // Outgrown buffers stay in the arena until the mesh is reset
+        long capacity = needed > 2L * csr->edge_capacity ? needed : 2L * csr->edge_capacity;
+        char* out_block = (char*)mesh_arena_alloc(&m->arena, csr_block_size(n, (int)capacity));
+        char* in_block = (char*)mesh_arena_alloc(&m->arena, csr_block_size(n, (int)capacity));
+        if (!out_block || !in_block) {
+            return -1;
+        }
+        csr_carve(out_block, n, (int)capacity, &csr->out_offset, &csr->out_degree, &csr->out_target, &csr->out_link, &csr->out_bandwidth, &csr->out_latency);
+        csr_carve(in_block, n, (int)capacity, &csr->in_offset, &csr->in_degree, &csr->in_source, &csr->in_link, &csr->in_bandwidth, &csr->in_latency);
+        csr->node_count = n;
+        csr->edge_capacity = (int)capacity;
+    }
+
+    // Counting sort of the links by source and by destination
+    memset(csr->out_degree, 0, sizeof(int) * n);
+    memset(csr->in_degree, 0, sizeof(int) * n);
+    for (int i = 0; i < e; i++) {
+        csr->out_degree[m->links[i].source_id]++;
+        csr->in_degree[m->links[i].destination_id]++;
+    }
+    csr->out_offset[0] = 0;
+    csr->in_offset[0] = 0;
+    for (int v = 0; v < n; v++) {
+        csr->out_offset[v + 1] = csr->out_offset[v] + csr_slots(csr->out_degree[v]);
+        csr->in_offset[v + 1] = csr->in_offset[v] + csr_slots(csr->in_degree[v]);
+    }
+    // The degrees serve as cursors while filling
+    memset(csr->out_degree, 0, sizeof(int) * n);
+    memset(csr->in_degree, 0, sizeof(int) * n);
+    for (int i = 0; i < e; i++) {
+        mesh_link* link = &m->links[i];
+        int s = link->source_id;
+        int d = link->destination_id;
+        int o = csr->out_offset[s] + csr->out_degree[s]++;
+        csr->out_target[o] = d;
+        csr->out_link[o] = i;
+        csr->out_bandwidth[o] = link->bandwidth;
+        csr->out_latency[o] = link->latency;
+        int in = csr->in_offset[d] + csr->in_degree[d]++;
+        csr->in_source[in] = s;
+        csr->in_link[in] = i;
+        csr->in_bandwidth[in] = link->bandwidth;
+        csr->in_latency[in] = link->latency;
+    }
+
+    csr->valid = true;
+    return 0;
+}
+
+mesh_csr* mesh_get_csr(mesh* m) {
+    if (!m->csr.valid && mesh_build_csr(m) != 0) {
+        return NULL;
+    }
+    return &m->csr;
+}
+
+void mesh_csr_insert(mesh* m, int link) {
+    mesh_csr* csr = &m->csr;
+    if (!csr->valid) return;
+    mesh_link* l = &m->links[link];
+    int s = l->source_id;
+    int d = l->destination_id;
+    if (csr->out_offset[s] + csr->out_degree[s] == csr->out_offset[s + 1]
+        || csr->in_offset[d] + csr->in_degree[d] == csr->in_offset[d + 1]) {
+        csr->valid = false; // No slack left, rebuilt in bulk on the next traversal
+        return;
+    }
+    int o = csr->out_offset[s] + csr->out_degree[s]++;
+    csr->out_target[o] = d;
+    csr->out_link[o] = link;
+    csr->out_bandwidth[o] = l->bandwidth;
+    csr->out_latency[o] = l->latency;
+    int in = csr->in_offset[d] + csr->in_degree[d]++;
+    csr->in_source[in] = s;
+    csr->in_link[in] = link;
+    csr->in_bandwidth[in] = l->bandwidth;
+    csr->in_latency[in] = l->latency;
+}
+
+// Slot of a link among the edges of a node, -1 if absent
+static int csr_find(const int* offset, const int* degree, const int* links, int v, int link) {
+    for (int e = offset[v]; e < offset[v] + degree[v]; e++) {
+        if (links[e] == link) return e;
+    }
+    return -1;
+}
+
+// An adjacency missing a link of the mesh is out of sync, it is rebuilt in bulk on the next traversal
+static int csr_out_of_sync(mesh_csr* csr) {
+    csr->valid = false;
+    return -1;
+}
+
+int mesh_csr_remove(mesh* m, int link) {
+    mesh_csr* csr = &m->csr;
+    if (!csr->valid) return 0;
+    int s = m->links[link].source_id;
+    int d = m->links[link].destination_id;
+    int o = csr_find(csr->out_offset, csr->out_degree, csr->out_link, s, link);
+    int in = csr_find(csr->in_offset, csr->in_degree, csr->in_link, d, link);
+    if (o < 0 || in < 0) {
+        return csr_out_of_sync(csr);
+    }
+    // The last edge of the node fills the hole
+    int last = csr->out_offset[s] + --csr->out_degree[s];
+    csr->out_target[o] = csr->out_target[last];
+    csr->out_link[o] = csr->out_link[last];
+    csr->out_bandwidth[o] = csr->out_bandwidth[last];
+    csr->out_latency[o] = csr->out_latency[last];
+    last = csr->in_offset[d] + --csr->in_degree[d];
+    csr->in_source[in] = csr->in_source[last];
+    csr->in_link[in] = csr->in_link[last];
+    csr->in_bandwidth[in] = csr->in_bandwidth[last];
+    csr->in_latency[in] = csr->in_latency[last];
+    return 0;
+}
+
+int mesh_csr_relink(mesh* m, int from, int to) {
+    mesh_csr* csr = &m->csr;
+    if (!csr->valid) return 0;
+    int o = csr_find(csr->out_offset, csr->out_degree, csr->out_link, m->links[to].source_id, from);
+    int in = csr_find(csr->in_offset, csr->in_degree, csr->in_link, m->links[to].destination_id, from);
+    if (o < 0 || in < 0) {
+        return csr_out_of_sync(csr);
+    }
+    csr->out_link[o] = to;
+    csr->in_link[in] = to;
+    return 0;
+}
+
+int mesh_csr_update(mesh* m, int link) {
+    mesh_csr* csr = &m->csr;
+    if (!csr->valid) return 0;
+    mesh_link* l = &m->links[link];
+    int o = csr_find(csr->out_offset, csr->out_degree, csr->out_link, l->source_id, link);
+    int in = csr_find(csr->in_offset, csr->in_degree, csr->in_link, l->destination_id, link);
+    if (o < 0 || in < 0) {
+        return csr_out_of_sync(csr);
+    }
+    csr->out_bandwidth[o] = l->bandwidth;
+    csr->out_latency[o] = l->latency;
+    csr->in_bandwidth[in] = l->bandwidth;
+    csr->in_latency[in] = l->latency;
+    return 0;
+}
@@ -0,0 +1,65 @@
+#pragma once
+
+#include <stdbool.h>
+
+typedef struct mesh mesh; // Forward declaration
+
+typedef struct mesh_csr mesh_csr;
+
+
+/// @brief Compressed sparse row adjacency of the mesh links, in both directions.
+/// Edges of node v are stored at [offset[v], offset[v] + degree[v]) of the matching arrays,
+/// the slots up to offset[v + 1] are slack so single links are added or removed in place.
+/// Each direction lives in a single allocation from the mesh arena.
+struct mesh_csr{
+    bool valid;                 /// False when links changed since the last build
+    int node_count;             /// Number of nodes the offsets were built for
+    int edge_capacity;          /// Number of edge slots the current buffers can hold
+    int* out_offset;            /// First slot of the outgoing edges of each node (node_count + 1)
+    int* out_degree;            /// Number of outgoing edges of each node
+    int* out_target;            /// Destination node of each outgoing edge
+    int* out_link;              /// Index in mesh->links of each outgoing edge
+    float* out_bandwidth;       /// Bandwidth of each outgoing edge in Mbps
+    float* out_latency;         /// Latency of each outgoing edge in ms
+    int* in_offset;             /// First slot of the incoming edges of each node (node_count + 1)
+    int* in_degree;             /// Number of incoming edges of each node
+    int* in_source;             /// Source node of each incoming edge
+    int* in_link;               /// Index in mesh->links of each incoming edge
+    float* in_bandwidth;        /// Bandwidth of each incoming edge in Mbps
+    float* in_latency;          /// Latency of each incoming edge in ms
+};
+
+
+///@brief Builds the CSR adjacency of the mesh from its link array in one pass.
+///@param m A pointer to the mesh structure.
+///@return int 0 on success, -1 on allocation failure.
+int mesh_build_csr(mesh* m);
+
+///@brief Returns the CSR adjacency of the mesh, rebuilding it if links changed.
+///@param m A pointer to the mesh structure.
+///@return mesh_csr* The up to date adjacency, or NULL on allocation failure.
+mesh_csr* mesh_get_csr(mesh* m);
+
+///@brief Adds a link to a built adjacency, or marks it for a rebuild when a node has no slack left.
+///@param m A pointer to the mesh structure.
+///@param link The index of the new link in mesh->links.
+void mesh_csr_insert(mesh* m, int link);
+
+///@brief Removes a link from a built adjacency.
+///@param m A pointer to the mesh structure.
+///@param link The index of the link in mesh->links, still in place.
+///@return int 0 on success, -1 if the adjacency does not list the link, it is then rebuilt on the next traversal.
+int mesh_csr_remove(mesh* m, int link);
+
+///@brief Renames a link after it moved in mesh->links.
+///@param m A pointer to the mesh structure.
+///@param from The old index of the link.
+///@param to The new index of the link, mesh->links[to] already holds it.
+///@return int 0 on success, -1 if the adjacency does not list the link, it is then rebuilt on the next traversal.
+int mesh_csr_relink(mesh* m, int from, int to);
+
+///@brief Copies the bandwidth and latency of a link into a built adjacency.
+///@param m A pointer to the mesh structure.
+///@param link The index of the link in mesh->links.
+///@return int 0 on success, -1 if the adjacency does not list the link, it is then rebuilt on the next traversal.
+int mesh_csr_update(mesh* m, int link);
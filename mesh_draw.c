@@ -1,5 +1,281 @@
 #include "mesh_draw.h"
 
+#define DRAW_CONNECTED 0        // Rect colors, also the node values of the level of detail cells minus one
+#define DRAW_OTHER 1
+#define DRAW_LINK 2
+#define DRAW_CELL_NODE 3        // Node bits of a level of detail cell
+#define DRAW_CELL_LINK 4        // Set when a link crosses the cell
+#define DRAW_LOD_RASTER 8       // Longest link, in level of detail cells, merged into the cells instead of drawn
+
+/// @brief Draw calls waiting to be sent. A frame fills them and sends one call per SDL_BATCH_SIZE
+/// items and color instead of one per node or link.
+typedef struct draw_batch {
+    SDL_Rect* rects[3];         /// Squares of connected nodes, other nodes and merged links
+    int rect_count[3];          /// Number of squares waiting of each color
+    SDL_Vertex* vertices;       /// Four corners per link quad
+    int* indices;               /// Two triangles per quad, the same for every call
+    int quad_count;             /// Number of quads waiting
+    unsigned char* cells;       /// Level of detail grid over the view, node color + 1 and DRAW_CELL_LINK
+    int cell_capacity;          /// Number of cells the grid can hold
+    const mesh* m;              /// Mesh longest was measured on
+    unsigned long version;      /// mesh->version longest was measured at
+    float longest;              /// Length of the longest link in meters
+} draw_batch;
+
+/// @brief Transform and bounds of the frame being drawn: a point (x, y) of the mesh lands on pixel
+/// (x * scale + shift_x, y * scale + shift_y), the top left corner of its node square.
+typedef struct draw_view {
+    float scale;
+    float shift_x, shift_y;
+    int width, height;          /// Size of the output in pixels
+    bool lod;                   /// Merge the nodes and short links per SDL_LOD_CELL square
+    int lod_cols, lod_rows;     /// Size of the level of detail grid, it starts one node square left and above the view
+} draw_view;
+
+static draw_batch draw_scratch; // Rendering happens on the thread owning the renderer
+
+static const SDL_Color draw_colors[3] = {
+    {0, 255, 0, 255},           // Green for connected nodes
+    {0, 0, 255, 255},           // Blue for the others
+    {255, 0, 0, 255}            // Red for links
+};
+
+static void draw_release(void) {
+    draw_batch* b = &draw_scratch;
+    for (int c = 0; c < 3; c++) {
+        free(b->rects[c]);
+    }
+    free(b->vertices);
+    free(b->indices);
+    free(b->cells);
+    memset(b, 0, sizeof(*b));
+}
+
+static int draw_reserve(int cells) {
+    draw_batch* b = &draw_scratch;
+    if (!b->vertices) {
+        for (int c = 0; c < 3; c++) {
+            b->rects[c] = (SDL_Rect*)malloc(sizeof(SDL_Rect) * SDL_BATCH_SIZE);
+        }
+        b->vertices = (SDL_Vertex*)malloc(sizeof(SDL_Vertex) * 4 * SDL_BATCH_SIZE);
+        b->indices = (int*)malloc(sizeof(int) * 6 * SDL_BATCH_SIZE);
+        if (!b->rects[0] || !b->rects[1] || !b->rects[2] || !b->vertices || !b->indices) {
+            draw_release();
+            return -1;
+        }
+        for (int q = 0; q < SDL_BATCH_SIZE; q++) {
+            int* i = b->indices + 6 * q;
+            i[0] = 4 * q;
+            i[1] = i[4] = 4 * q + 1;
+            i[2] = i[3] = 4 * q + 2;
+            i[5] = 4 * q + 3;
+        }
+    }
+    if (cells > b->cell_capacity) {
+        unsigned char* grown = (unsigned char*)realloc(b->cells, (size_t)cells);
+        if (!grown) {
+            return -1;
+        }
+        b->cells = grown;
+        b->cell_capacity = cells;
+    }
+    return 0;
+}
+
+static void draw_flush_rects(SDL_Renderer* renderer, int color) {
+    draw_batch* b = &draw_scratch;
+    if (b->rect_count[color] == 0) return;
+    SDL_Color c = draw_colors[color];
+    SDL_SetRenderDrawColor(renderer, c.r, c.g, c.b, c.a);
+    SDL_RenderFillRects(renderer, b->rects[color], b->rect_count[color]);
+    b->rect_count[color] = 0;
+}
+
+static void draw_rect(SDL_Renderer* renderer, int color, int x, int y, int size) {
+    draw_batch* b = &draw_scratch;
+    SDL_Rect* rect = &b->rects[color][b->rect_count[color]++];
+    rect->x = x;
+    rect->y = y;
+    rect->w = size;
+    rect->h = size;
+    if (b->rect_count[color] == SDL_BATCH_SIZE) draw_flush_rects(renderer, color);
+}
+
+static void draw_flush_quads(SDL_Renderer* renderer) {
+#if SDL_VERSION_ATLEAST(2, 0, 18)
+    draw_batch* b = &draw_scratch;
+    if (b->quad_count == 0) return;
+    SDL_RenderGeometry(renderer, NULL, b->vertices, 4 * b->quad_count, b->indices, 6 * b->quad_count);
+    b->quad_count = 0;
+#else
+    (void)renderer;
+#endif
+}
+
+// A link is a quad one pixel wide, SDL before 2.0.18 has no geometry and draws it as a line
+static void draw_link_quad(SDL_Renderer* renderer, float x0, float y0, float x1, float y1) {
+#if SDL_VERSION_ATLEAST(2, 0, 18)
+    draw_batch* b = &draw_scratch;
+    float dx = x1 - x0;
+    float dy = y1 - y0;
+    float length = sqrtf(dx * dx + dy * dy);
+    if (length == 0.0f) return;
+    float nx = -dy / length * 0.5f;
+    float ny = dx / length * 0.5f;
+    SDL_Vertex* v = b->vertices + 4 * b->quad_count;
+    v[0].position.x = x0 + nx; v[0].position.y = y0 + ny;
+    v[1].position.x = x0 - nx; v[1].position.y = y0 - ny;
+    v[2].position.x = x1 + nx; v[2].position.y = y1 + ny;
+    v[3].position.x = x1 - nx; v[3].position.y = y1 - ny;
+    for (int i = 0; i < 4; i++) {
+        v[i].color = draw_colors[DRAW_LINK];
+        v[i].tex_coord.x = 0.0f;
+        v[i].tex_coord.y = 0.0f;
+    }
+    if (++b->quad_count == SDL_BATCH_SIZE) draw_flush_quads(renderer);
+#else
+    SDL_SetRenderDrawColor(renderer, draw_colors[DRAW_LINK].r, draw_colors[DRAW_LINK].g, draw_colors[DRAW_LINK].b, draw_colors[DRAW_LINK].a);
+    SDL_RenderDrawLine(renderer, (int)x0, (int)y0, (int)x1, (int)y1);
+#endif
+}
+
+// Marks the level of detail cells a short link crosses, by steps of one cell
+static void draw_link_cells(const draw_view* v, float x0, float y0, float x1, float y1, int steps) {
+    unsigned char* cells = draw_scratch.cells;
+    float dx = (x1 - x0) / steps;
+    float dy = (y1 - y0) / steps;
+    for (int i = 0; i <= steps; i++) {
+        float x = (x0 + dx * i + SDL_NODE_SIZE) / SDL_LOD_CELL;
+        float y = (y0 + dy * i + SDL_NODE_SIZE) / SDL_LOD_CELL;
+        if (x < 0.0f || y < 0.0f || x >= v->lod_cols || y >= v->lod_rows) continue;
+        cells[(int)y * v->lod_cols + (int)x] |= DRAW_CELL_LINK;
+    }
+}
+
+// Endpoints are the centers of the node squares
+static void draw_link(SDL_Renderer* renderer, const draw_view* v, const mesh_node* source, const mesh_node* destination) {
+    float half = SDL_NODE_SIZE / 2.0f;
+    float x0 = source->x * v->scale + v->shift_x + half;
+    float y0 = source->y * v->scale + v->shift_y + half;
+    float x1 = destination->x * v->scale + v->shift_x + half;
+    float y1 = destination->y * v->scale + v->shift_y + half;
+    // Bounding box test, a link passing by a corner of the view is sent anyway
+    if ((x0 < 0.0f && x1 < 0.0f) || (y0 < 0.0f && y1 < 0.0f) || (x0 > v->width && x1 > v->width) || (y0 > v->height && y1 > v->height)) {
+        return;
+    }
+    if (v->lod) {
+        int steps = (int)(fmaxf(fabsf(x1 - x0), fabsf(y1 - y0)) / SDL_LOD_CELL) + 1;
+        if (steps <= DRAW_LOD_RASTER) {
+            draw_link_cells(v, x0, y0, x1, y1, steps);
+            return;
+        }
+    }
+    draw_link_quad(renderer, x0, y0, x1, y1);
+}
+
+// Mesh area whose points land in the view, grown by a margin in meters, as a range of grid cells
+static void draw_grid_range(const mesh_grid* g, const draw_view* v, float margin, int* cx0, int* cx1, int* cy0, int* cy1) {
+    float x0 = (-SDL_NODE_SIZE - v->shift_x) / v->scale - margin;
+    float x1 = (v->width - v->shift_x) / v->scale + margin;
+    float y0 = (-SDL_NODE_SIZE - v->shift_y) / v->scale - margin;
+    float y1 = (v->height - v->shift_y) / v->scale + margin;
+    // The edge cells also hold the nodes moved out of the area
+    *cx0 = x0 > 0.0f ? (x0 / g->cell_size < g->cols ? (int)(x0 / g->cell_size) : g->cols - 1) : 0;
+    *cx1 = x1 > 0.0f ? (x1 / g->cell_size < g->cols ? (int)(x1 / g->cell_size) : g->cols - 1) : 0;
+    *cy0 = y0 > 0.0f ? (y0 / g->cell_size < g->rows ? (int)(y0 / g->cell_size) : g->rows - 1) : 0;
+    *cy1 = y1 > 0.0f ? (y1 / g->cell_size < g->rows ? (int)(y1 / g->cell_size) : g->rows - 1) : 0;
+}
+
+// Length of the longest link, measured again only once the mesh changed
+static float draw_longest_link(mesh* m) {
+    draw_batch* b = &draw_scratch;
+    if (b->m != m || b->version != m->version) {
+        float longest = 0.0f;
+        for (int i = 0; i < m->link_count; i++) {
+            if (m->links[i].length > longest) longest = m->links[i].length;
+        }
+        b->m = m;
+        b->version = m->version;
+        b->longest = longest;
+    }
+    return b->longest;
+}
+
+static void draw_links(SDL_Renderer* renderer, mesh* m, const draw_view* v) {
+    mesh_csr* csr = m->grid.cell_head ? mesh_get_csr(m) : NULL;
+    if (!csr) {
+        for (int i = 0; i < m->link_count; i++) {
+            draw_link(renderer, v, &m->nodes[m->links[i].source_id], &m->nodes[m->links[i].destination_id]);
+        }
+    } else {
+        // A link reaching the view starts at most its length away from it
+        mesh_grid* g = &m->grid;
+        int cx0, cx1, cy0, cy1;
+        draw_grid_range(g, v, draw_longest_link(m), &cx0, &cx1, &cy0, &cy1);
+        for (int cy = cy0; cy <= cy1; cy++) {
+            for (int cx = cx0; cx <= cx1; cx++) {
+                for (int id = g->cell_head[cy * g->cols + cx]; id >= 0; id = g->next[id]) {
+                    for (int e = csr->out_offset[id]; e < csr->out_offset[id] + csr->out_degree[id]; e++) {
+                        draw_link(renderer, v, &m->nodes[id], &m->nodes[csr->out_target[e]]);
+                    }
+                }
+            }
+        }
+    }
+    draw_flush_quads(renderer);
+}
+
+static void draw_node(SDL_Renderer* renderer, const draw_view* v, const mesh_node* node) {
+    float x = node->x * v->scale + v->shift_x;
+    float y = node->y * v->scale + v->shift_y;
+    if (x <= -SDL_NODE_SIZE || y <= -SDL_NODE_SIZE || x >= v->width || y >= v->height) {
+        return;
+    }
+    int color = node->node_status == CONNECTED ? DRAW_CONNECTED : DRAW_OTHER;
+    if (v->lod) {
+        unsigned char* cell = &draw_scratch.cells[(int)((y + SDL_NODE_SIZE) / SDL_LOD_CELL) * v->lod_cols + (int)((x + SDL_NODE_SIZE) / SDL_LOD_CELL)];
+        *cell = (unsigned char)((*cell & ~DRAW_CELL_NODE) | (color + 1));
+        return;
+    }
+    draw_rect(renderer, color, (int)x, (int)y, SDL_NODE_SIZE);
+}
+
+static void draw_nodes(SDL_Renderer* renderer, mesh* m, const draw_view* v) {
+    mesh_grid* g = &m->grid;
+    if (!g->cell_head) {
+        for (int i = 0; i < m->node_count; i++) draw_node(renderer, v, &m->nodes[i]);
+    } else {
+        int cx0, cx1, cy0, cy1;
+        draw_grid_range(g, v, 0.0f, &cx0, &cx1, &cy0, &cy1);
+        for (int cy = cy0; cy <= cy1; cy++) {
+            for (int cx = cx0; cx <= cx1; cx++) {
+                for (int id = g->cell_head[cy * g->cols + cx]; id >= 0; id = g->next[id]) {
+                    draw_node(renderer, v, &m->nodes[id]);
+                }
+            }
+        }
+    }
+}
+
+// Sends the level of detail cells, merged links first and nodes on top
+static void draw_cells(SDL_Renderer* renderer, const draw_view* v) {
+    const unsigned char* cells = draw_scratch.cells;
+    for (int cy = 0; cy < v->lod_rows; cy++) {
+        for (int cx = 0; cx < v->lod_cols; cx++) {
+            if (cells[cy * v->lod_cols + cx] & DRAW_CELL_LINK) {
+                draw_rect(renderer, DRAW_LINK, cx * SDL_LOD_CELL - SDL_NODE_SIZE, cy * SDL_LOD_CELL - SDL_NODE_SIZE, SDL_LOD_CELL);
+            }
+        }
+    }
+    draw_flush_rects(renderer, DRAW_LINK);
+    for (int cy = 0; cy < v->lod_rows; cy++) {
+        for (int cx = 0; cx < v->lod_cols; cx++) {
+            int node = cells[cy * v->lod_cols + cx] & DRAW_CELL_NODE;
+            if (node) draw_rect(renderer, node - 1, cx * SDL_LOD_CELL - SDL_NODE_SIZE, cy * SDL_LOD_CELL - SDL_NODE_SIZE, SDL_NODE_SIZE);
+        }
+    }
+}
+
 SDL_Window* create_window() {
     SDL_Window* window = SDL_CreateWindow("Mesh Render", SDL_WINDOWPOS_UNDEFINED, SDL_WINDOWPOS_UNDEFINED, SDL_WIDTH, SDL_HEIGHT, SDL_WINDOW_SHOWN);
     if (!window) {
@@ -25,29 +301,15 @@ void Sdl_DrawNode(SDL_Renderer* renderer, mesh_node* node) {
     SDL_RenderFillRect(renderer, &rect);
 }
 
-void Sdl_DrawLink(SDL_Renderer* renderer, mesh_link* link) {
+void Sdl_DrawLink(SDL_Renderer* renderer, mesh* m, mesh_link* link) {
+    mesh_node* source = &m->nodes[link->source_id];
+    mesh_node* destination = &m->nodes[link->destination_id];
     SDL_SetRenderDrawColor(renderer, 255, 0, 0, 255); // Red for links
-    SDL_RenderDrawLine(renderer, (int)link->source->x*SIZE_MULTIPLIER + 5, (int)link->source->y*SIZE_MULTIPLIER + 5, (int)link->destination->x*SIZE_MULTIPLIER + 5, (int)link->destination->y*SIZE_MULTIPLIER + 5);
+    SDL_RenderDrawLine(renderer, (int)source->x*SIZE_MULTIPLIER + 5, (int)source->y*SIZE_MULTIPLIER + 5, (int)destination->x*SIZE_MULTIPLIER + 5, (int)destination->y*SIZE_MULTIPLIER + 5);
 }
 
 void Sdl_RenderMesh(SDL_Renderer* renderer, mesh* m) {
-    SDL_SetRenderDrawColor(renderer, 0, 0, 0, 255); // Black background
-    SDL_RenderClear(renderer);
-
-    // Draw links first
-    for (int i = 0; i < m->node_count; i++) {
-        mesh_node* node = &m->nodes[i];
-        for (int j = 0; j < node->output_link_count; j++) {
-            Sdl_DrawLink(renderer, &node->output_link[j]);
-        }
-    }
-
-    // Draw nodes on top of links
-    for (int i = 0; i < m->node_count; i++) {
-        Sdl_DrawNode(renderer, &m->nodes[i]);
-    }
-
-    SDL_RenderPresent(renderer);
+    Sdl_RenderZoomedMesh(renderer, m, 1.0f, 0.0f, 0.0f);
 }
 
 void Sdl_Delay(int milliseconds) {
@@ -55,6 +317,7 @@ void Sdl_Delay(int milliseconds) {
 }
 
 void Sdl_Cleanup(SDL_Window* window, SDL_Renderer* renderer) {
+    draw_release();
     if (renderer) {
         SDL_DestroyRenderer(renderer);
     }
@@ -64,30 +327,35 @@ void Sdl_Cleanup(SDL_Window* window, SDL_Renderer* renderer) {
     SDL_Quit();
 }
 
-// function to render a zoomed view of the mesh
 void Sdl_RenderZoomedMesh(SDL_Renderer* renderer, mesh* m, float zoom_factor, float offset_x, float offset_y) {
     SDL_SetRenderDrawColor(renderer, 0, 0, 0, 255); // Black background
     SDL_RenderClear(renderer);
-    // Draw links first
-    for (int i = 0; i < m->node_count; i++) {
-        mesh_node* node = &m->nodes[i];
-        for (int j = 0; j < node->output_link_count; j++) {
-            SDL_SetRenderDrawColor(renderer, 255, 0, 0, 255); // Red for links
-            SDL_RenderDrawLine(renderer,
-                (int)((node->x * zoom_factor + offset_x) * SIZE_MULTIPLIER) + 5,
-                (int)((node->y * zoom_factor + offset_y) * SIZE_MULTIPLIER) + 5,
-                (int)((node->output_link[j].destination->x * zoom_factor + offset_x) * SIZE_MULTIPLIER) + 5,
-                (int)((node->output_link[j].destination->y * zoom_factor + offset_y) * SIZE_MULTIPLIER) + 5);
-        }
-    }   
-    // Draw nodes on top of links
-    for (int i = 0; i < m->node_count; i++) {
-        mesh_node* node = &m->nodes[i];
-        if(node->node_status == CONNECTED) SDL_SetRenderDrawColor(renderer, 0, 255, 0, 255); // Green for nodes
-        else SDL_SetRenderDrawColor(renderer, 0, 0, 255, 255); // Blue for inactive nodes
-        SDL_Rect rect = { (int)((node->x * zoom_factor + offset_x) * SIZE_MULTIPLIER), (int)((node->y * zoom_factor + offset_y) * SIZE_MULTIPLIER), 10, 10 };
-        SDL_RenderFillRect(renderer, &rect);
-    }   
+
+    draw_view v;
+    if (SDL_GetRendererOutputSize(renderer, &v.width, &v.height) != 0) {
+        v.width = SDL_WIDTH;
+        v.height = SDL_HEIGHT;
+    }
+    v.scale = zoom_factor * SIZE_MULTIPLIER;
+    v.shift_x = offset_x * SIZE_MULTIPLIER;
+    v.shift_y = offset_y * SIZE_MULTIPLIER;
+    v.lod_cols = (v.width + SDL_NODE_SIZE) / SDL_LOD_CELL + 1;
+    v.lod_rows = (v.height + SDL_NODE_SIZE) / SDL_LOD_CELL + 1;
+
+    // Nodes expected in the view, from the share of the mesh area it covers
+    float view_w = fminf((v.width - v.shift_x) / v.scale, m->size_x) - fmaxf(-v.shift_x / v.scale, 0.0f);
+    float view_h = fminf((v.height - v.shift_y) / v.scale, m->size_y) - fmaxf(-v.shift_y / v.scale, 0.0f);
+    double visible = view_w > 0.0f && view_h > 0.0f ? (double)m->node_count * view_w * view_h / ((double)m->size_x * m->size_y) : 0.0;
+    v.lod = visible > (double)v.lod_cols * v.lod_rows / 8.0;
+
+    if (v.scale > 0.0f && draw_reserve(v.lod ? v.lod_cols * v.lod_rows : 0) == 0) {
+        if (v.lod) memset(draw_scratch.cells, 0, (size_t)v.lod_cols * v.lod_rows);
+        // Links first, nodes on top
+        draw_links(renderer, m, &v);
+        draw_nodes(renderer, m, &v);
+        if (v.lod) draw_cells(renderer, &v);
+        draw_flush_rects(renderer, DRAW_CONNECTED);
+        draw_flush_rects(renderer, DRAW_OTHER);
+    }
     SDL_RenderPresent(renderer);
 }
-    
@@ -7,6 +7,9 @@
 #define SDL_HEIGHT 800
 #define SDL_TITLE "Mesh Network Visualization"
 #define SIZE_MULTIPLIER 24
+#define SDL_NODE_SIZE 10 // side of a node square in pixels
+#define SDL_BATCH_SIZE 16384 // node squares or link quads sent per draw call
+#define SDL_LOD_CELL 2 // side in pixels of the cells crowded nodes are merged into
 
 SDL_Window* create_window();
 
@@ -14,19 +17,30 @@ SDL_Renderer* create_renderer(SDL_Window* window);
 
 void Sdl_DrawNode(SDL_Renderer* renderer, mesh_node* node);
 
-void Sdl_DrawLink(SDL_Renderer* renderer, mesh_link* link);
+void Sdl_DrawLink(SDL_Renderer* renderer, mesh* m, mesh_link* link);
 
 void Sdl_DrawMesh(SDL_Renderer* renderer, mesh_node* nodes, int node_count);
 
+///@brief Draws every link then every node, batched by color, and presents the frame.
+///@param renderer The renderer to draw with.
+///@param m A pointer to the mesh structure.
 void Sdl_RenderMesh(SDL_Renderer* renderer, mesh* m);
 
 void Sdl_DrawPath(SDL_Renderer* renderer, mesh_node* nodes, mesh_path* path);
 
 void Sdl_Delay(int milliseconds);
 
+///@brief Destroys the renderer and the window, frees the draw batches and quits SDL.
 void Sdl_Cleanup(SDL_Window* window, SDL_Renderer* renderer);
 
-// function to render a zoomed view of the mesh
+///@brief Draws a zoomed view of the mesh and presents the frame. Nodes and links outside the view are
+/// skipped, nodes through the spatial grid of the mesh. Once the view holds more nodes than it has pixels
+/// to show them, nodes falling into the same SDL_LOD_CELL square are drawn once, and links shorter than a pixel are dropped.
+///@param renderer The renderer to draw with.
+///@param m A pointer to the mesh structure.
+///@param zoom_factor The scale of the view, 1 for Sdl_RenderMesh().
+///@param offset_x The shift of the view along X, in meters after scaling.
+///@param offset_y The shift of the view along Y, in meters after scaling.
 void Sdl_RenderZoomedMesh(SDL_Renderer* renderer, mesh* m, float zoom_factor, float offset_x, float offset_y);
 
 
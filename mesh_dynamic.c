@@ -0,0 +1,125 @@
+#include "mesh_compute.h"
+
+#define DYNAMIC_LOCAL_LINKS 32
+
+// Room for three lists of the links around a node, on the stack for usual degrees
+static int* dynamic_buffer(int* local, int degree) {
+    return degree <= DYNAMIC_LOCAL_LINKS ? local : (int*)malloc(sizeof(int) * 3 * (size_t)degree);
+}
+
+int mesh_move_node(mesh* m, int id, float x, float y) {
+    MESH_COUNT(MESH_COUNT_NODES_MOVED, 1);
+    mesh_grid_move_node(m, id, x, y);
+    m->version++;
+    int result = 0;
+    if (m->link_count > 0) {
+        mesh_csr* csr = mesh_get_csr(m);
+        int local[3 * DYNAMIC_LOCAL_LINKS];
+        int degree = csr ? csr->out_degree[id] + csr->in_degree[id] : 0;
+        int* worse = csr ? dynamic_buffer(local, degree) : NULL;
+        if (!worse) {
+            return -1;
+        }
+        int* targets = worse + degree;
+        int* better = targets + degree;
+        int worse_count = 0, better_count = 0;
+        for (int side = 0; side < 2; side++) {
+            const int* offset = side == 0 ? csr->out_offset : csr->in_offset;
+            const int* count = side == 0 ? csr->out_degree : csr->in_degree;
+            const int* links = side == 0 ? csr->out_link : csr->in_link;
+            for (int e = offset[id]; e < offset[id] + count[id]; e++) {
+                int l = links[e];
+                mesh_link* link = &m->links[l];
+                float latency = link->latency;
+                mesh_measure_link(m, link);
+                if (mesh_csr_update(m, l) != 0) {
+                    result = -1;
+                }
+                if (link->latency > latency) {
+                    worse[worse_count] = l;
+                    targets[worse_count++] = link->destination_id;
+                } else if (link->latency < latency) {
+                    better[better_count++] = l;
+                }
+            }
+        }
+        // Longer links first: the subtrees they reset are reattached with every new weight in place
+        if (mesh_spt_links_worse(m, worse, targets, worse_count) != 0 || mesh_spt_links_better(m, better, better_count) != 0) {
+            result = -1;
+        }
+        if (worse != local) free(worse);
+    }
+    return result;
+}
+
+int mesh_set_node_status(mesh* m, int id, status node_status) {
+    bool was_inactive = m->nodes[id].node_status == INACTIVE;
+    bool inactive = node_status == INACTIVE;
+    m->nodes[id].node_status = node_status;
+    m->soa.node_status[id] = (unsigned char)node_status;
+    m->version++;
+    int result = 0;
+    if (was_inactive != inactive && m->spt.count > 0) {
+        mesh_csr* csr = mesh_get_csr(m);
+        int local[3 * DYNAMIC_LOCAL_LINKS];
+        int degree = csr ? csr->out_degree[id] + csr->in_degree[id] : 0;
+        int* links = csr ? dynamic_buffer(local, degree) : NULL;
+        if (!links) {
+            return -1;
+        }
+        int* targets = links + degree;
+        int count = 0;
+        for (int e = csr->out_offset[id]; e < csr->out_offset[id] + csr->out_degree[id]; e++) {
+            links[count] = csr->out_link[e];
+            targets[count++] = csr->out_target[e];
+        }
+        for (int e = csr->in_offset[id]; e < csr->in_offset[id] + csr->in_degree[id]; e++) {
+            links[count] = csr->in_link[e];
+            targets[count++] = id;
+        }
+        result = inactive ? mesh_spt_links_worse(m, links, targets, count) : mesh_spt_links_better(m, links, count);
+        if (links != local) free(links);
+    }
+    return result;
+}
+
+int mesh_add_link(mesh* m, int source_id, int destination_id) {
+    int result = init_mesh_link(m, m->next_link_id, &m->nodes[source_id], &m->nodes[destination_id]);
+    return result < 0 ? -1 : m->link_count - 1;
+}
+
+int mesh_remove_link(mesh* m, int link) {
+    MESH_COUNT(MESH_COUNT_LINKS_REMOVED, 1);
+    mesh_node* source = &m->nodes[m->links[link].source_id];
+    mesh_node* destination = &m->nodes[m->links[link].destination_id];
+    // The trees are repaired on the adjacency, build it while the link is still listed
+    if (m->spt.count > 0 && !mesh_get_csr(m)) {
+        return -1;
+    }
+    if (mesh_csr_remove(m, link) != 0) {
+        return -1;
+    }
+    source->output_link_count--;
+    destination->input_link_count--;
+    m->soa.output_link_count[source->id]--;
+    m->soa.input_link_count[destination->id]--;
+    if (source->output_link_count == 0 && source->node_status == CONNECTED) {
+        source->node_status = DISCONNECTED;
+        m->soa.node_status[source->id] = DISCONNECTED;
+    }
+    // Union-find cannot split, components are labelled again on the next query
+    mesh_components_invalidate(m);
+    m->version++;
+    int result = mesh_spt_links_worse(m, &link, &destination->id, 1);
+
+    int last = m->link_count - 1;
+    if (link != last) {
+        m->links[link] = m->links[last];
+        if (mesh_csr_relink(m, last, link) != 0) {
+            result = -1;
+        }
+        mesh_spt_relink(m, last, link);
+    }
+    m->link_count--;
+    return result;
+}
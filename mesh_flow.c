@@ -0,0 +1,341 @@
+#include "mesh_compute.h"
+#include "mesh_parallel.h"
+
+#define FLOW_EPSILON 1e-6 // in Mbps, residual capacity below which an arc counts as saturated
+
+typedef struct flow_job {
+    mesh* m;
+    const int* source_ids;
+    const int* sink_ids;
+    double* results;
+    bool widest;
+} flow_job;
+
+static void flow_build(mesh* m, mesh_flow* f) {
+    int n = m->node_count;
+    // Counting sort of the arcs by tail node, offset[v] is the fill cursor of v until the final shift
+    memset(f->offset, 0, sizeof(int) * (n + 1));
+    for (int l = 0; l < m->link_count; l++) {
+        f->offset[m->links[l].source_id]++;
+        f->offset[m->links[l].destination_id]++;
+    }
+    int sum = 0;
+    for (int v = 0; v < n; v++) {
+        int count = f->offset[v];
+        f->offset[v] = sum;
+        sum += count;
+    }
+    for (int l = 0; l < m->link_count; l++) {
+        mesh_link* link = &m->links[l];
+        int s = link->source_id;
+        int d = link->destination_id;
+        int out = f->offset[s]++;
+        f->arc[out] = 2 * l;
+        f->head[out] = d;
+        int back = f->offset[d]++;
+        f->arc[back] = 2 * l + 1;
+        f->head[back] = s;
+        bool inactive = m->soa.node_status[s] == INACTIVE || m->soa.node_status[d] == INACTIVE;
+        f->capacity[l] = inactive ? 0.0f : link->bandwidth;
+    }
+    for (int v = n; v > 0; v--) {
+        f->offset[v] = f->offset[v - 1];
+    }
+    f->offset[0] = 0;
+    f->version = m->version;
+    f->built = true;
+}
+
+static int flow_prepare(mesh* m, int workers) {
+    mesh_flow* f = &m->flow;
+    int n = m->node_count;
+    if (f->node_count != n || f->link_capacity < m->link_count) {
+        // Outgrown buffers stay in the arena until the mesh is reset, like the adjacency
+        int capacity = m->link_count > 2 * f->link_capacity ? m->link_count : 2 * f->link_capacity;
+        if (capacity < 64) capacity = 64;
+        f->offset = (int*)mesh_arena_alloc(&m->arena, sizeof(int) * (n + 1));
+        f->arc = (int*)mesh_arena_alloc(&m->arena, sizeof(int) * 2 * (size_t)capacity);
+        f->head = (int*)mesh_arena_alloc(&m->arena, sizeof(int) * 2 * (size_t)capacity);
+        f->capacity = (float*)mesh_arena_alloc(&m->arena, sizeof(float) * capacity);
+        if (!f->offset || !f->arc || !f->head || !f->capacity) {
+            f->node_count = 0;
+            return -1;
+        }
+        f->node_count = n;
+        f->link_capacity = capacity;
+        f->built = false;
+        f->scratch_count = 0; // Per link buffers of the workers are too small now
+    }
+    if (!f->built || f->version != m->version) {
+        flow_build(m, f);
+    }
+    if (f->scratch_count < workers) {
+        mesh_flow_scratch* scratch = (mesh_flow_scratch*)mesh_arena_realloc(&m->arena, f->scratch, sizeof(mesh_flow_scratch) * f->scratch_count, sizeof(mesh_flow_scratch) * workers);
+        if (!scratch) {
+            return -1;
+        }
+        f->scratch = scratch;
+        for (int i = f->scratch_count; i < workers; i++) {
+            mesh_flow_scratch* s = &scratch[i];
+            memset(s, 0, sizeof(*s));
+            s->flow = (double*)mesh_arena_calloc(&m->arena, sizeof(double) * f->link_capacity);
+            s->stamp = (unsigned int*)mesh_arena_calloc(&m->arena, sizeof(unsigned int) * f->link_capacity);
+            s->touched = (int*)mesh_arena_alloc(&m->arena, sizeof(int) * f->link_capacity);
+            s->level = (int*)mesh_arena_alloc(&m->arena, sizeof(int) * n);
+            s->iter = (int*)mesh_arena_alloc(&m->arena, sizeof(int) * n);
+            s->queue = (int*)mesh_arena_alloc(&m->arena, sizeof(int) * n);
+            s->path = (int*)mesh_arena_alloc(&m->arena, sizeof(int) * n);
+            s->width = (double*)mesh_arena_calloc(&m->arena, sizeof(double) * n);
+            s->heap_pos = (int*)mesh_arena_alloc(&m->arena, sizeof(int) * n);
+            if (!s->flow || !s->stamp || !s->touched || !s->level || !s->iter || !s->queue || !s->path || !s->width || !s->heap_pos) {
+                return -1;
+            }
+            memset(s->level, -1, sizeof(int) * n);
+            memset(s->heap_pos, -1, sizeof(int) * n);
+            f->scratch_count = i + 1;
+        }
+    }
+    return 0;
+}
+
+// Even arcs follow their link, odd arcs cancel flow already sent over it
+static double flow_residual(const mesh_flow* f, const mesh_flow_scratch* s, int a) {
+    int l = a >> 1;
+    return (a & 1) ? s->flow[l] : f->capacity[l] - s->flow[l];
+}
+
+static void flow_push(mesh_flow_scratch* s, int a, double amount) {
+    int l = a >> 1;
+    if (s->stamp[l] != s->query) {
+        s->stamp[l] = s->query;
+        s->touched[s->touched_count++] = l;
+    }
+    s->flow[l] += (a & 1) ? -amount : amount;
+}
+
+// Levels of the residual network up to the level of the sink, returns false once the sink is cut off
+static bool flow_levels(const mesh_flow* f, mesh_flow_scratch* s, int source, int sink) {
+    for (int i = 0; i < s->queued; i++) {
+        s->level[s->queue[i]] = -1;
+    }
+    s->level[source] = 0;
+    s->queue[0] = source;
+    int tail = 1;
+    for (int head = 0; head < tail; head++) {
+        int v = s->queue[head];
+        if (s->level[sink] >= 0 && s->level[v] >= s->level[sink]) break;
+        for (int slot = f->offset[v]; slot < f->offset[v + 1]; slot++) {
+            int w = f->head[slot];
+            if (s->level[w] < 0 && flow_residual(f, s, f->arc[slot]) > FLOW_EPSILON) {
+                s->level[w] = s->level[v] + 1;
+                s->queue[tail++] = w;
+            }
+        }
+    }
+    s->queued = tail;
+    return s->level[sink] >= 0;
+}
+
+// Blocking flow over the level graph, walking augmenting paths without recursion
+static double flow_blocking(const mesh_flow* f, mesh_flow_scratch* s, int source, int sink) {
+    for (int i = 0; i < s->queued; i++) {
+        int v = s->queue[i];
+        s->iter[v] = f->offset[v];
+    }
+    double total = 0.0;
+    int depth = 0;
+    int v = source;
+    for (;;) {
+        if (v == sink) {
+            double amount = INFINITY;
+            for (int i = 0; i < depth; i++) {
+                double r = flow_residual(f, s, f->arc[s->path[i]]);
+                if (r < amount) amount = r;
+            }
+            for (int i = 0; i < depth; i++) {
+                flow_push(s, f->arc[s->path[i]], amount);
+            }
+            total += amount;
+            // Resume from the tail of the first saturated arc
+            int cut = 0;
+            while (cut < depth && flow_residual(f, s, f->arc[s->path[cut]]) > FLOW_EPSILON) cut++;
+            depth = cut;
+            v = depth > 0 ? f->head[s->path[depth - 1]] : source;
+            continue;
+        }
+        int slot = s->iter[v];
+        for (; slot < f->offset[v + 1]; slot++) {
+            int w = f->head[slot];
+            if (s->level[w] == s->level[v] + 1 && flow_residual(f, s, f->arc[slot]) > FLOW_EPSILON) break;
+        }
+        s->iter[v] = slot;
+        if (slot < f->offset[v + 1]) {
+            s->path[depth++] = slot;
+            v = f->head[slot];
+            continue;
+        }
+        // Dead end, no later path of this phase goes through v
+        s->level[v] = -1;
+        if (depth == 0) break;
+        depth--;
+        v = depth > 0 ? f->head[s->path[depth - 1]] : source;
+        s->iter[v]++;
+    }
+    return total;
+}
+
+static double flow_max(mesh* m, mesh_flow_scratch* s, int source, int sink) {
+    MESH_TIMED(MESH_TIME_FLOW);
+    const mesh_flow* f = &m->flow;
+    if (source == sink) {
+        return 0.0;
+    }
+    if (++s->query == 0) {
+        memset(s->stamp, 0, sizeof(unsigned int) * f->link_capacity);
+        s->query = 1;
+    }
+    // Neither end can carry more than its own links, stop as soon as one is full
+    double out = 0.0, in = 0.0;
+    for (int slot = f->offset[source]; slot < f->offset[source + 1]; slot++) {
+        if (!(f->arc[slot] & 1)) out += f->capacity[f->arc[slot] >> 1];
+    }
+    for (int slot = f->offset[sink]; slot < f->offset[sink + 1]; slot++) {
+        if (f->arc[slot] & 1) in += f->capacity[f->arc[slot] >> 1];
+    }
+    double bound = out < in ? out : in;
+    double total = 0.0;
+    while (total < bound - FLOW_EPSILON && flow_levels(f, s, source, sink)) {
+        total += flow_blocking(f, s, source, sink);
+    }
+    for (int i = 0; i < s->queued; i++) {
+        s->level[s->queue[i]] = -1;
+    }
+    s->queued = 0;
+    for (int i = 0; i < s->touched_count; i++) {
+        s->flow[s->touched[i]] = 0.0;
+    }
+    s->touched_count = 0;
+    return total;
+}
+
+static void flow_heap_up(mesh_flow_scratch* s, int i) {
+    int v = s->queue[i];
+    while (i > 0) {
+        int parent = (i - 1) / 2;
+        int p = s->queue[parent];
+        if (s->width[p] >= s->width[v]) break;
+        s->queue[i] = p;
+        s->heap_pos[p] = i;
+        i = parent;
+    }
+    s->queue[i] = v;
+    s->heap_pos[v] = i;
+}
+
+static void flow_heap_down(mesh_flow_scratch* s, int size, int i) {
+    int v = s->queue[i];
+    for (;;) {
+        int child = 2 * i + 1;
+        if (child >= size) break;
+        if (child + 1 < size && s->width[s->queue[child + 1]] > s->width[s->queue[child]]) child++;
+        int c = s->queue[child];
+        if (s->width[c] <= s->width[v]) break;
+        s->queue[i] = c;
+        s->heap_pos[c] = i;
+        i = child;
+    }
+    s->queue[i] = v;
+    s->heap_pos[v] = i;
+}
+
+// Dijkstra on the bottleneck instead of the sum, the widest node is settled first
+static double flow_widest(mesh* m, mesh_flow_scratch* s, int source, int sink) {
+    MESH_TIMED(MESH_TIME_FLOW);
+    const mesh_flow* f = &m->flow;
+    if (source == sink) {
+        return 0.0;
+    }
+    int reached = 0; // Nodes with a width to clear, listed in path
+    int size = 1;
+    s->width[source] = INFINITY;
+    s->path[reached++] = source;
+    s->queue[0] = source;
+    s->heap_pos[source] = 0;
+    double result = 0.0;
+    while (size > 0) {
+        int x = s->queue[0];
+        s->heap_pos[x] = -1;
+        if (--size > 0) {
+            s->queue[0] = s->queue[size];
+            flow_heap_down(s, size, 0);
+        }
+        if (x == sink) {
+            result = s->width[x];
+            break;
+        }
+        for (int slot = f->offset[x]; slot < f->offset[x + 1]; slot++) {
+            int a = f->arc[slot];
+            if (a & 1) continue;
+            int y = f->head[slot];
+            double w = f->capacity[a >> 1] < s->width[x] ? f->capacity[a >> 1] : s->width[x];
+            if (w > s->width[y]) {
+                if (s->width[y] == 0.0) s->path[reached++] = y;
+                s->width[y] = w;
+                if (s->heap_pos[y] < 0) {
+                    s->queue[size] = y;
+                    s->heap_pos[y] = size++;
+                }
+                flow_heap_up(s, s->heap_pos[y]);
+            }
+        }
+    }
+    for (int i = 0; i < size; i++) {
+        s->heap_pos[s->queue[i]] = -1;
+    }
+    for (int i = 0; i < reached; i++) {
+        s->width[s->path[i]] = 0.0;
+    }
+    return result;
+}
+
+double mesh_max_flow(mesh* m, int source_id, int sink_id) {
+    if (flow_prepare(m, 1) != 0) {
+        return -1.0;
+    }
+    return flow_max(m, &m->flow.scratch[0], source_id, sink_id);
+}
+
+double mesh_widest_path(mesh* m, int source_id, int sink_id) {
+    if (flow_prepare(m, 1) != 0) {
+        return -1.0;
+    }
+    return flow_widest(m, &m->flow.scratch[0], source_id, sink_id);
+}
+
+static void flow_batch_range(void* ctx, int worker, int begin, int end) {
+    flow_job* job = (flow_job*)ctx;
+    mesh_flow_scratch* s = &job->m->flow.scratch[worker];
+    for (int i = begin; i < end; i++) {
+        job->results[i] = job->widest ? flow_widest(job->m, s, job->source_ids[i], job->sink_ids[i])
+                                      : flow_max(job->m, s, job->source_ids[i], job->sink_ids[i]);
+    }
+}
+
+static int flow_batch(mesh* m, const int* source_ids, const int* sink_ids, int count, double* results, int threads, bool widest) {
+    int workers = mesh_thread_count(threads);
+    // The network and every worker buffer exist before the threads start, workers only read the mesh
+    if (flow_prepare(m, workers) != 0) {
+        return -1;
+    }
+    flow_job job = { m, source_ids, sink_ids, results, widest };
+    mesh_parallel_for(count, 4, workers, flow_batch_range, &job);
+    return 0;
+}
+
+int mesh_max_flow_batch(mesh* m, const int* source_ids, const int* sink_ids, int count, double* results, int threads) {
+    return flow_batch(m, source_ids, sink_ids, count, results, threads, false);
+}
+
+int mesh_widest_path_batch(mesh* m, const int* source_ids, const int* sink_ids, int count, double* results, int threads) {
+    return flow_batch(m, source_ids, sink_ids, count, results, threads, true);
+}
@@ -0,0 +1,78 @@
+#pragma once
+
+#include <stdbool.h>
+
+typedef struct mesh mesh; // Forward declaration
+
+typedef struct mesh_flow_scratch mesh_flow_scratch;
+
+typedef struct mesh_flow mesh_flow;
+
+
+/// @brief Buffers of one worker running flow queries. Only the links a query pushed flow
+/// through are cleared afterwards, so a query costs what it explores, not the mesh size.
+struct mesh_flow_scratch{
+    double* flow;               /// Flow through each link
+    unsigned int* stamp;        /// Query in which each link last carried flow
+    unsigned int query;         /// Generation of the current query
+    int* touched;               /// Links carrying flow in the current query
+    int touched_count;          /// Number of entries in touched
+    int* level;                 /// BFS level of each node in the residual network, -1 if unreached
+    int* iter;                  /// Next arc to try from each node during a blocking flow
+    int* queue;                 /// BFS queue, also the heap of the widest path search
+    int queued;                 /// Number of nodes the last BFS reached, their levels are cleared before the next one
+    int* path;                  /// Slots of the augmenting path being explored, the reached nodes in the widest path search
+    double* width;              /// Bottleneck bandwidth from the source in the widest path search
+    int* heap_pos;              /// Position of each node in the widest path heap, -1 outside
+};
+
+/// @brief Residual network of the links with their bandwidth as capacity, in both directions.
+/// Link i gives arc 2i from its source and the reverse arc 2i + 1 from its destination.
+/// Links touching an INACTIVE node have no capacity. Rebuilt once mesh->version changed.
+struct mesh_flow{
+    bool built;                 /// False until the first build
+    unsigned long version;      /// mesh->version the network was built for
+    int node_count;             /// Number of nodes the buffers were sized for
+    int link_capacity;          /// Number of links the buffers can hold
+    int* offset;                /// First slot of the arcs of each node (node_count + 1)
+    int* arc;                   /// Arc of each slot, grouped by tail node
+    int* head;                  /// Head node of the arc of each slot
+    float* capacity;            /// Capacity of each link in Mbps
+    mesh_flow_scratch* scratch; /// Buffers of each worker
+    int scratch_count;          /// Number of workers with buffers
+};
+
+
+///@brief Computes the maximum flow between two nodes with Dinic's algorithm.
+///@param m A pointer to the mesh structure.
+///@param source_id The ID of the node sending.
+///@param sink_id The ID of the node receiving.
+///@return double The throughput in Mbps, 0 if the sink is unreachable or the same node, -1 on allocation failure.
+double mesh_max_flow(mesh* m, int source_id, int sink_id);
+
+///@brief Finds the path between two nodes whose narrowest link is the widest.
+///@param m A pointer to the mesh structure.
+///@param source_id The ID of the node sending.
+///@param sink_id The ID of the node receiving.
+///@return double The bandwidth of the narrowest link of that path in Mbps, 0 if the sink is unreachable or the same node, -1 on allocation failure.
+double mesh_widest_path(mesh* m, int source_id, int sink_id);
+
+///@brief Computes the maximum flow of many node pairs on worker threads.
+///@param m A pointer to the mesh structure.
+///@param source_ids The ID of the node sending, for each pair.
+///@param sink_ids The ID of the node receiving, for each pair.
+///@param count The number of pairs.
+///@param results Output buffer receiving the throughput of each pair in Mbps.
+///@param threads The number of workers, 0 to use every online core.
+///@return int 0 on success, -1 on allocation failure.
+int mesh_max_flow_batch(mesh* m, const int* source_ids, const int* sink_ids, int count, double* results, int threads);
+
+///@brief Finds the widest path bandwidth of many node pairs on worker threads.
+///@param m A pointer to the mesh structure.
+///@param source_ids The ID of the node sending, for each pair.
+///@param sink_ids The ID of the node receiving, for each pair.
+///@param count The number of pairs.
+///@param results Output buffer receiving the bottleneck bandwidth of each pair in Mbps.
+///@param threads The number of workers, 0 to use every online core.
+///@return int 0 on success, -1 on allocation failure.
+int mesh_widest_path_batch(mesh* m, const int* source_ids, const int* sink_ids, int count, double* results, int threads);
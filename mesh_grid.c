@@ -0,0 +1,97 @@
+#include "mesh_compute.h"
+
+static int grid_cell_coord(float v, float cell_size, int cells) {
+    int c = (int)(v / cell_size);
+    if (c < 0) return 0;
+    if (c >= cells) return cells - 1;
+    return c;
+}
+
+static int grid_cell_of(mesh_grid* g, float x, float y) {
+    return grid_cell_coord(y, g->cell_size, g->rows) * g->cols + grid_cell_coord(x, g->cell_size, g->cols);
+}
+
+static void grid_link(mesh_grid* g, int id, int cell) {
+    int head = g->cell_head[cell];
+    g->prev[id] = -1;
+    g->next[id] = head;
+    if (head >= 0) g->prev[head] = id;
+    g->cell_head[cell] = id;
+    g->cell_of[id] = cell;
+}
+
+static void grid_unlink(mesh_grid* g, int id) {
+    int cell = g->cell_of[id];
+    if (g->prev[id] >= 0) g->next[g->prev[id]] = g->next[id];
+    else g->cell_head[cell] = g->next[id];
+    if (g->next[id] >= 0) g->prev[g->next[id]] = g->prev[id];
+}
+
+int mesh_grid_build(mesh* m) {
+    mesh_grid* g = &m->grid;
+    if (!g->cell_head) {
+        // Cells are widened when a short link distance would give far more cells than nodes
+        g->cell_size = m->config.max_link_distance;
+        while ((double)ceilf(m->size_x / g->cell_size) * ceilf(m->size_y / g->cell_size) > 4.0 * m->node_count + 64.0) {
+            g->cell_size *= 2.0f;
+        }
+        g->cols = (int)ceilf(m->size_x / g->cell_size);
+        g->rows = (int)ceilf(m->size_y / g->cell_size);
+        if (g->cols < 1) g->cols = 1;
+        if (g->rows < 1) g->rows = 1;
+
+        g->cell_head = (int*)mesh_arena_alloc(&m->arena, sizeof(int) * g->cols * g->rows);
+        g->next = (int*)mesh_arena_alloc(&m->arena, sizeof(int) * m->node_count);
+        g->prev = (int*)mesh_arena_alloc(&m->arena, sizeof(int) * m->node_count);
+        g->cell_of = (int*)mesh_arena_alloc(&m->arena, sizeof(int) * m->node_count);
+        if (!g->cell_head || !g->next || !g->prev || !g->cell_of) {
+            g->cell_head = NULL;
+            return -1;
+        }
+    }
+
+    memset(g->cell_head, -1, sizeof(int) * g->cols * g->rows);
+    // Insert in reverse so every cell lists its nodes by increasing id
+    for (int i = m->node_count - 1; i >= 0; i--) {
+        grid_link(g, i, grid_cell_of(g, m->nodes[i].x, m->nodes[i].y));
+    }
+    return 0;
+}
+
+void mesh_grid_move_node(mesh* m, int id, float x, float y) {
+    mesh_grid* g = &m->grid;
+    mesh_node* node = &m->nodes[id];
+    node->x = x;
+    node->y = y;
+    m->soa.x[id] = x;
+    m->soa.y[id] = y;
+    int cell = grid_cell_of(g, x, y);
+    if (cell == g->cell_of[id]) return;
+    grid_unlink(g, id);
+    grid_link(g, id, cell);
+}
+
+int mesh_grid_query(mesh* m, float x, float y, float range, int exclude_id, int* ids, int max_ids) {
+    MESH_COUNT(MESH_COUNT_GRID_QUERIES, 1);
+    mesh_grid* g = &m->grid;
+    float range_sq = range * range;
+    int cx0 = grid_cell_coord(x - range, g->cell_size, g->cols);
+    int cx1 = grid_cell_coord(x + range, g->cell_size, g->cols);
+    int cy0 = grid_cell_coord(y - range, g->cell_size, g->rows);
+    int cy1 = grid_cell_coord(y + range, g->cell_size, g->rows);
+    int found = 0;
+
+    for (int cy = cy0; cy <= cy1; cy++) {
+        for (int cx = cx0; cx <= cx1; cx++) {
+            for (int id = g->cell_head[cy * g->cols + cx]; id >= 0; id = g->next[id]) {
+                if (id == exclude_id) continue;
+                float dx = m->soa.x[id] - x;
+                float dy = m->soa.y[id] - y;
+                if (dx * dx + dy * dy > range_sq) continue;
+                if (ids && found < max_ids) ids[found] = id;
+                found++;
+            }
+        }
+    }
+    return found;
+}
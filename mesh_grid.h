@@ -0,0 +1,45 @@
+#pragma once
+
+#include "mesh_settings.h"
+
+typedef struct mesh mesh; // Forward declaration
+
+typedef struct mesh_grid mesh_grid;
+
+
+/// @brief Uniform bucket grid over the mesh area used for neighbor discovery.
+/// Each cell keeps a doubly linked list of node ids so nodes can move in O(1).
+struct mesh_grid{
+    float cell_size;            /// Side of a cell in meters, the max link distance unless that gives too many cells
+    int cols;                   /// Number of cells along X
+    int rows;                   /// Number of cells along Y
+    int* cell_head;             /// First node id of each cell, -1 if the cell is empty
+    int* next;                  /// Next node id in the same cell, -1 at the end
+    int* prev;                  /// Previous node id in the same cell, -1 at the head
+    int* cell_of;               /// Cell index of each node
+};
+
+
+///@brief Builds the spatial grid of the mesh from the current node positions.
+/// The buffers are taken from the mesh arena on the first build and reused afterwards.
+///@param m A pointer to the mesh structure.
+///@return int 0 on success, -1 on allocation failure.
+int mesh_grid_build(mesh* m);
+
+///@brief Moves a node to new coordinates and updates its grid cell.
+///@param m A pointer to the mesh structure.
+///@param id The ID of the node to move.
+///@param x The new X coordinate.
+///@param y The new Y coordinate.
+void mesh_grid_move_node(mesh* m, int id, float x, float y);
+
+///@brief List the nodes within a range of a point.
+///@param m A pointer to the mesh structure.
+///@param x The X coordinate of the center.
+///@param y The Y coordinate of the center.
+///@param range The distance range to search for nodes.
+///@param exclude_id A node ID to skip (-1 to keep all nodes).
+///@param ids Output buffer for the node IDs found, may be NULL to only count.
+///@param max_ids The capacity of the ids buffer.
+///@return int The number of nodes found, which may exceed max_ids.
+int mesh_grid_query(mesh* m, float x, float y, float range, int exclude_id, int* ids, int max_ids);
@@ -0,0 +1,169 @@
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "mesh_metrics.h"
+
+#if MESH_METRICS
+
+static const char* metrics_counter_names[MESH_COUNTER_COUNT] = {
+    "links_added", "links_removed", "nodes_moved", "grid_queries", "route_lookups", "sim_events"
+};
+
+static const char* metrics_timer_names[MESH_TIMER_COUNT] = {
+    "init_mesh", "place_nodes", "form_links", "build_csr", "components", "shortest_paths", "eccentricity",
+    "diameter", "spt_repair", "build_routes", "flow", "sim_run", "dump", "snapshot", "raster",
+    "betweenness", "topology"
+};
+
+__thread mesh_metrics_block* mesh_metrics_local;
+
+static pthread_mutex_t metrics_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_once_t metrics_once = PTHREAD_ONCE_INIT;
+static pthread_key_t metrics_key;
+static mesh_metrics_block* metrics_live;        // Blocks of the running threads
+static mesh_metrics_block metrics_retired;      // Sum of the blocks of the threads that ended
+
+static void metrics_add(mesh_metrics_block* to, const mesh_metrics_block* from) {
+    for (int c = 0; c < MESH_COUNTER_COUNT; c++) {
+        to->counters[c] += from->counters[c];
+    }
+    for (int t = 0; t < MESH_TIMER_COUNT; t++) {
+        to->calls[t] += from->calls[t];
+        to->total_ns[t] += from->total_ns[t];
+        if (from->max_ns[t] > to->max_ns[t]) to->max_ns[t] = from->max_ns[t];
+        for (int b = 0; b < MESH_METRICS_BUCKETS; b++) {
+            to->histogram[t][b] += from->histogram[t][b];
+        }
+    }
+}
+
+// Worker threads are short lived, their block is folded into the retired sum when they end
+static void metrics_detach(void* arg) {
+    mesh_metrics_block* block = (mesh_metrics_block*)arg;
+    pthread_mutex_lock(&metrics_lock);
+    mesh_metrics_block** link = &metrics_live;
+    while (*link && *link != block) link = &(*link)->next;
+    if (*link) *link = block->next;
+    metrics_add(&metrics_retired, block);
+    pthread_mutex_unlock(&metrics_lock);
+    free(block);
+}
+
+static void metrics_exit_report(void) {
+    if (MESH_METRICS_REPORT[0] != '\0') {
+        mesh_metrics_report(MESH_METRICS_REPORT);
+    }
+}
+
+static void metrics_init(void) {
+    pthread_key_create(&metrics_key, metrics_detach);
+    atexit(metrics_exit_report);
+}
+
+mesh_metrics_block* mesh_metrics_attach(void) {
+    pthread_once(&metrics_once, metrics_init);
+    mesh_metrics_block* block = (mesh_metrics_block*)calloc(1, sizeof(mesh_metrics_block));
+    if (!block) {
+        return NULL;
+    }
+    pthread_mutex_lock(&metrics_lock);
+    block->next = metrics_live;
+    metrics_live = block;
+    pthread_mutex_unlock(&metrics_lock);
+    pthread_setspecific(metrics_key, block);
+    mesh_metrics_local = block;
+    return block;
+}
+
+// Upper bound of the bucket holding the given fraction of the calls
+static uint64_t metrics_percentile(const uint64_t* histogram, uint64_t calls, double fraction) {
+    uint64_t rank = (uint64_t)(fraction * (double)calls);
+    uint64_t seen = 0;
+    for (int b = 0; b < MESH_METRICS_BUCKETS; b++) {
+        seen += histogram[b];
+        if (seen > rank) return (uint64_t)2 << b;
+    }
+    return (uint64_t)2 << (MESH_METRICS_BUCKETS - 1);
+}
+
+int mesh_metrics_report(const char* filename) {
+    FILE* file = fopen(filename, "w");
+    if (!file) {
+        return -1;
+    }
+    mesh_metrics_block sum;
+    pthread_mutex_lock(&metrics_lock);
+    sum = metrics_retired;
+    for (mesh_metrics_block* b = metrics_live; b; b = b->next) {
+        metrics_add(&sum, b);
+    }
+    pthread_mutex_unlock(&metrics_lock);
+
+    size_t length = strlen(filename);
+    int json = length >= 5 && strcmp(filename + length - 5, ".json") == 0;
+    if (json) {
+        fprintf(file, "{\n  \"counters\": {");
+        for (int c = 0; c < MESH_COUNTER_COUNT; c++) {
+            fprintf(file, "%s\n    \"%s\": %llu", c ? "," : "", metrics_counter_names[c], (unsigned long long)sum.counters[c]);
+        }
+        fprintf(file, "\n  },\n  \"timers\": {");
+        for (int t = 0; t < MESH_TIMER_COUNT; t++) {
+            uint64_t calls = sum.calls[t];
+            fprintf(file, "%s\n    \"%s\": {\"calls\": %llu, \"total_ns\": %llu, \"mean_ns\": %.1f, \"max_ns\": %llu, "
+                    "\"p50_ns\": %llu, \"p90_ns\": %llu, \"p99_ns\": %llu, \"histogram\": [",
+                    t ? "," : "", metrics_timer_names[t], (unsigned long long)calls, (unsigned long long)sum.total_ns[t],
+                    calls ? (double)sum.total_ns[t] / calls : 0.0, (unsigned long long)sum.max_ns[t],
+                    (unsigned long long)(calls ? metrics_percentile(sum.histogram[t], calls, 0.50) : 0),
+                    (unsigned long long)(calls ? metrics_percentile(sum.histogram[t], calls, 0.90) : 0),
+                    (unsigned long long)(calls ? metrics_percentile(sum.histogram[t], calls, 0.99) : 0));
+            for (int b = 0; b < MESH_METRICS_BUCKETS; b++) {
+                fprintf(file, "%s%llu", b ? ", " : "", (unsigned long long)sum.histogram[t][b]);
+            }
+            fprintf(file, "]}");
+        }
+        fprintf(file, "\n  }\n}\n");
+    } else {
+        fprintf(file, "kind,name,count,total_ns,mean_ns,max_ns,p50_ns,p90_ns,p99_ns\n");
+        for (int c = 0; c < MESH_COUNTER_COUNT; c++) {
+            fprintf(file, "counter,%s,%llu,,,,,,\n", metrics_counter_names[c], (unsigned long long)sum.counters[c]);
+        }
+        for (int t = 0; t < MESH_TIMER_COUNT; t++) {
+            uint64_t calls = sum.calls[t];
+            if (calls == 0) {
+                fprintf(file, "timer,%s,0,0,0,0,0,0,0\n", metrics_timer_names[t]);
+                continue;
+            }
+            fprintf(file, "timer,%s,%llu,%llu,%.1f,%llu,%llu,%llu,%llu\n", metrics_timer_names[t], (unsigned long long)calls,
+                    (unsigned long long)sum.total_ns[t], (double)sum.total_ns[t] / calls, (unsigned long long)sum.max_ns[t],
+                    (unsigned long long)metrics_percentile(sum.histogram[t], calls, 0.50),
+                    (unsigned long long)metrics_percentile(sum.histogram[t], calls, 0.90),
+                    (unsigned long long)metrics_percentile(sum.histogram[t], calls, 0.99));
+        }
+    }
+    fclose(file);
+    return 0;
+}
+
+void mesh_metrics_reset(void) {
+    pthread_mutex_lock(&metrics_lock);
+    memset(&metrics_retired, 0, sizeof(metrics_retired));
+    for (mesh_metrics_block* b = metrics_live; b; b = b->next) {
+        mesh_metrics_block* next = b->next;
+        memset(b, 0, sizeof(*b));
+        b->next = next;
+    }
+    pthread_mutex_unlock(&metrics_lock);
+}
+
+#else
+
+int mesh_metrics_report(const char* filename) {
+    (void)filename;
+    return -1;
+}
+
+void mesh_metrics_reset(void) {
+}
+
+#endif
@@ -0,0 +1,123 @@
+#pragma once
+
+#include <stdint.h>
+#include <time.h>
+#include "mesh_settings.h"
+
+// Counters and timers compiled in with MESH_METRICS=1 (`make METRICS=1`), they vanish otherwise.
+// Each thread adds to its own block, blocks are only summed when a report is written.
+
+typedef enum mesh_counter {
+    MESH_COUNT_LINKS_ADDED,
+    MESH_COUNT_LINKS_REMOVED,
+    MESH_COUNT_NODES_MOVED,
+    MESH_COUNT_GRID_QUERIES,
+    MESH_COUNT_ROUTE_LOOKUPS,
+    MESH_COUNT_SIM_EVENTS,
+    MESH_COUNTER_COUNT
+}mesh_counter;
+
+typedef enum mesh_timer {
+    MESH_TIME_INIT_MESH,
+    MESH_TIME_PLACE_NODES,
+    MESH_TIME_FORM_LINKS,
+    MESH_TIME_BUILD_CSR,
+    MESH_TIME_COMPONENTS,
+    MESH_TIME_SHORTEST_PATHS,
+    MESH_TIME_ECCENTRICITY,
+    MESH_TIME_DIAMETER,
+    MESH_TIME_SPT_REPAIR,
+    MESH_TIME_BUILD_ROUTES,
+    MESH_TIME_FLOW,
+    MESH_TIME_SIM_RUN,
+    MESH_TIME_DUMP,
+    MESH_TIME_SNAPSHOT,
+    MESH_TIME_RASTER,
+    MESH_TIME_BETWEENNESS,
+    MESH_TIME_TOPOLOGY,
+    MESH_TIMER_COUNT
+}mesh_timer;
+
+#define MESH_METRICS_BUCKETS 48 // Histogram buckets, bucket b holds durations in [2^b, 2^(b+1)) ns
+
+typedef struct mesh_metrics_block mesh_metrics_block;
+
+/// @brief Counters and timer statistics of one thread.
+struct mesh_metrics_block{
+    uint64_t counters[MESH_COUNTER_COUNT];                          /// Value of each counter
+    uint64_t calls[MESH_TIMER_COUNT];                               /// Number of timed calls
+    uint64_t total_ns[MESH_TIMER_COUNT];                            /// Sum of the durations in ns
+    uint64_t max_ns[MESH_TIMER_COUNT];                              /// Longest duration in ns
+    uint64_t histogram[MESH_TIMER_COUNT][MESH_METRICS_BUCKETS];     /// Durations by power of two of ns
+    mesh_metrics_block* next;                                       /// Next block of a live thread
+};
+
+
+///@brief Writes the sum of every thread block, as JSON if the name ends in .json and CSV otherwise.
+/// Blocks of threads still running are read as they are.
+///@param filename The path of the report.
+///@return int 0 on success, -1 on failure or when metrics are compiled out.
+int mesh_metrics_report(const char* filename);
+
+///@brief Clears every counter and timer.
+void mesh_metrics_reset(void);
+
+#if MESH_METRICS
+
+extern __thread mesh_metrics_block* mesh_metrics_local;
+
+///@brief Creates the block of the calling thread, the first call also schedules the exit report.
+///@return mesh_metrics_block* The block, NULL on allocation failure.
+mesh_metrics_block* mesh_metrics_attach(void);
+
+static inline mesh_metrics_block* mesh_metrics_block_get(void) {
+    mesh_metrics_block* b = mesh_metrics_local;
+    return b ? b : mesh_metrics_attach();
+}
+
+static inline uint64_t mesh_metrics_now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+}
+
+static inline void mesh_metrics_count(mesh_counter counter, uint64_t n) {
+    mesh_metrics_block* b = mesh_metrics_block_get();
+    if (b) b->counters[counter] += n;
+}
+
+static inline void mesh_metrics_record(mesh_timer timer, uint64_t ns) {
+    mesh_metrics_block* b = mesh_metrics_block_get();
+    if (!b) return;
+    int bucket = 63 - __builtin_clzll(ns | 1);
+    if (bucket >= MESH_METRICS_BUCKETS) bucket = MESH_METRICS_BUCKETS - 1;
+    b->calls[timer]++;
+    b->total_ns[timer] += ns;
+    if (ns > b->max_ns[timer]) b->max_ns[timer] = ns;
+    b->histogram[timer][bucket]++;
+}
+
+typedef struct mesh_scope_timer {
+    mesh_timer timer;
+    uint64_t start;
+} mesh_scope_timer;
+
+static inline void mesh_scope_timer_end(mesh_scope_timer* t) {
+    mesh_metrics_record(t->timer, mesh_metrics_now() - t->start);
+}
+
+#define MESH_METRICS_JOIN_(a, b) a##b
+#define MESH_METRICS_JOIN(a, b) MESH_METRICS_JOIN_(a, b)
+
+/// Times the rest of the enclosing block, every return included.
+#define MESH_TIMED(timer) \
+    mesh_scope_timer MESH_METRICS_JOIN(mesh_scope_timer_, __LINE__) __attribute__((cleanup(mesh_scope_timer_end))) = { (timer), mesh_metrics_now() }
+/// Adds n to a counter of the calling thread.
+#define MESH_COUNT(counter, n) mesh_metrics_count((counter), (uint64_t)(n))
+
+#else
+
+#define MESH_TIMED(timer) ((void)0)
+#define MESH_COUNT(counter, n) ((void)0)
+
+#endif
@@ -0,0 +1,70 @@
+#include <pthread.h>
+#include <stdatomic.h>
+#include <unistd.h>
+#include "mesh_settings.h"
+#include "mesh_parallel.h"
+
+typedef struct parallel_job {
+    atomic_int next;            /// Next item to hand out
+    int count;                  /// Number of items
+    int chunk;                  /// Items per chunk
+    mesh_parallel_fn fn;        /// Loop body
+    void* ctx;                  /// Loop body context
+} parallel_job;
+
+typedef struct parallel_worker {
+    parallel_job* job;
+    int index;
+} parallel_worker;
+
+static void parallel_run(parallel_job* job, int worker) {
+    for (;;) {
+        int begin = atomic_fetch_add(&job->next, job->chunk);
+        if (begin >= job->count) break;
+        int end = begin + job->chunk < job->count ? begin + job->chunk : job->count;
+        job->fn(job->ctx, worker, begin, end);
+    }
+}
+
+static void* parallel_thread(void* arg) {
+    parallel_worker* w = (parallel_worker*)arg;
+    parallel_run(w->job, w->index);
+    return NULL;
+}
+
+int mesh_thread_count(int requested) {
+    if (requested <= 0) {
+        long cores = sysconf(_SC_NPROCESSORS_ONLN);
+        requested = cores > 0 ? (int)cores : 1;
+    }
+    return requested > MESH_MAX_THREADS ? MESH_MAX_THREADS : requested;
+}
+
+int mesh_parallel_for(int count, int chunk, int threads, mesh_parallel_fn fn, void* ctx) {
+    parallel_job job;
+    atomic_init(&job.next, 0);
+    job.count = count;
+    job.chunk = chunk > 0 ? chunk : 1;
+    job.fn = fn;
+    job.ctx = ctx;
+
+    // No point in starting more threads than there are chunks
+    int chunks = (count + job.chunk - 1) / job.chunk;
+    if (threads > chunks) threads = chunks;
+    if (threads > MESH_MAX_THREADS) threads = MESH_MAX_THREADS;
+
+    // If a thread cannot be started the others simply pull more chunks
+    pthread_t tids[MESH_MAX_THREADS];
+    parallel_worker workers[MESH_MAX_THREADS];
+    int started = 1;
+    for (; started < threads; started++) {
+        workers[started].job = &job;
+        workers[started].index = started;
+        if (pthread_create(&tids[started], NULL, parallel_thread, &workers[started]) != 0) break;
+    }
+    parallel_run(&job, 0);
+    for (int i = 1; i < started; i++) {
+        pthread_join(tids[i], NULL);
+    }
+    return started;
+}
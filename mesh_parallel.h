@@ -0,0 +1,24 @@
+#pragma once
+
+/// @brief Body of a parallel loop, called with consecutive chunks [begin, end).
+/// @param ctx The context given to mesh_parallel_for().
+/// @param worker The index of the calling worker, below the thread count.
+/// @param begin The first item of the chunk.
+/// @param end One past the last item of the chunk.
+typedef void (*mesh_parallel_fn)(void* ctx, int worker, int begin, int end);
+
+
+///@brief Resolves a requested worker count.
+///@param requested The number of threads wanted, 0 to use every online core.
+///@return int The number of workers to use, between 1 and MESH_MAX_THREADS.
+int mesh_thread_count(int requested);
+
+///@brief Runs a loop over [0, count) on a group of threads pulling chunks from a shared counter.
+/// The calling thread takes part as worker 0.
+///@param count The number of items.
+///@param chunk The number of items handed out at once.
+///@param threads The number of workers, as returned by mesh_thread_count().
+///@param fn The loop body.
+///@param ctx The context passed to the loop body.
+///@return int The number of workers that took part, every item is processed even if threads could not be started.
+int mesh_parallel_for(int count, int chunk, int threads, mesh_parallel_fn fn, void* ctx);
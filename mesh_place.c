@@ -0,0 +1,122 @@
+#include "mesh_compute.h"
+#include "mesh_parallel.h"
+#include "mesh_rng.h"
+
+#define PLACE_CHUNK 4096
+
+// Streams of the placement, each counter is derived from the node or cluster index
+#define PLACE_STREAM_NODE 0
+#define PLACE_STREAM_CENTER 1
+
+typedef struct place_job {
+    mesh* m;
+    float size_x, size_y;       /// Area of the placement
+    float cluster_spread;       /// Standard deviation around a cluster center (MESH_CLUSTERED)
+    uint64_t seed;
+    mesh_distribution distribution;
+    int clusters;               /// Number of clusters (MESH_CLUSTERED)
+    int cols, rows;             /// Grid of cells (MESH_POISSON_DISK)
+} place_job;
+
+static float place_clamp(float v, float size) {
+    if (v < 0.0f) return 0.0f;
+    if (v >= size) return nextafterf(size, 0.0f);
+    return v;
+}
+
+static void place_node(const place_job* job, int i, float* x, float* y) {
+    uint64_t c = (uint64_t)i * 4;
+    switch (job->distribution) {
+        case MESH_CLUSTERED: {
+            int k = (int)(mesh_rng_double(job->seed, PLACE_STREAM_NODE, c) * job->clusters);
+            float cx = mesh_rng_float(job->seed, PLACE_STREAM_CENTER, 2 * (uint64_t)k) * job->size_x;
+            float cy = mesh_rng_float(job->seed, PLACE_STREAM_CENTER, 2 * (uint64_t)k + 1) * job->size_y;
+            // Box-Muller
+            double r = sqrt(-2.0 * log(1.0 - mesh_rng_double(job->seed, PLACE_STREAM_NODE, c + 1))) * job->cluster_spread;
+            double a = 2.0 * M_PI * mesh_rng_double(job->seed, PLACE_STREAM_NODE, c + 2);
+            *x = place_clamp(cx + (float)(r * cos(a)), job->size_x);
+            *y = place_clamp(cy + (float)(r * sin(a)), job->size_y);
+            break;
+        }
+        case MESH_POISSON_DISK: {
+            // Jitter stays in the middle half of the cell, which keeps neighbors half a cell apart
+            float w = job->size_x / job->cols;
+            float h = job->size_y / job->rows;
+            *x = place_clamp(((i % job->cols) + 0.25f + 0.5f * mesh_rng_float(job->seed, PLACE_STREAM_NODE, c)) * w, job->size_x);
+            *y = place_clamp(((i / job->cols) + 0.25f + 0.5f * mesh_rng_float(job->seed, PLACE_STREAM_NODE, c + 1)) * h, job->size_y);
+            break;
+        }
+        default:
+            *x = mesh_rng_float(job->seed, PLACE_STREAM_NODE, c) * job->size_x;
+            *y = mesh_rng_float(job->seed, PLACE_STREAM_NODE, c + 1) * job->size_y;
+            break;
+    }
+}
+
+static void place_job_init(place_job* job, int node_count, float size_x, float size_y, const mesh_config* config, uint64_t seed, mesh_distribution distribution) {
+    job->m = NULL;
+    job->size_x = size_x;
+    job->size_y = size_y;
+    job->cluster_spread = config->cluster_spread;
+    job->seed = seed;
+    job->distribution = distribution;
+    job->clusters = node_count / config->cluster_nodes > 0 ? node_count / config->cluster_nodes : 1;
+    // Cells as square as the area allows, enough of them for every node
+    job->cols = (int)ceil(sqrt((double)node_count * size_x / size_y));
+    if (job->cols < 1) job->cols = 1;
+    job->rows = (node_count + job->cols - 1) / job->cols;
+    if (job->rows < 1) job->rows = 1;
+}
+
+static void place_chunk(void* ctx, int worker, int begin, int end) {
+    place_job* job = (place_job*)ctx;
+    mesh* m = job->m;
+    (void)worker;
+    for (int i = begin; i < end; i++) {
+        mesh_node* node = init_mesh_node(&m->nodes[i], i, &m->config);
+        place_node(job, i, &node->x, &node->y);
+    }
+}
+
+int mesh_place_nodes(mesh* m, uint64_t seed, mesh_distribution distribution, int threads) {
+    MESH_TIMED(MESH_TIME_PLACE_NODES);
+    if (m->link_count > 0) {
+        return -1;
+    }
+    place_job job;
+    place_job_init(&job, m->node_count, m->size_x, m->size_y, &m->config, seed, distribution);
+    job.m = m;
+    mesh_parallel_for(m->node_count, PLACE_CHUNK, mesh_thread_count(threads), place_chunk, &job);
+    m->seed = seed;
+    m->distribution = distribution;
+    if (mesh_soa_build(m) != 0 || mesh_grid_build(m) != 0) {
+        return -1;
+    }
+    return 0;
+}
+
+void mesh_place_position(const mesh_config* config, int i, float* x, float* y) {
+    // Same area clamp as init_mesh()
+    place_job job;
+    place_job_init(&job, config->node_count, config->size_x >= 1.0f ? config->size_x : 1.0f, config->size_y >= 1.0f ? config->size_y : 1.0f,
+                   config, config->seed, config->distribution);
+    place_node(&job, i, x, y);
+}
+
+int mesh_place_nodes_at(mesh* m, const float* x, const float* y, const int* ids) {
+    MESH_TIMED(MESH_TIME_PLACE_NODES);
+    if (m->link_count > 0) {
+        return -1;
+    }
+    for (int i = 0; i < m->node_count; i++) {
+        // The type follows the id the node has in the whole network, the index stays its id in this mesh
+        mesh_node* node = init_mesh_node(&m->nodes[i], ids ? ids[i] : i, &m->config);
+        node->id = i;
+        node->x = x[i];
+        node->y = y[i];
+    }
+    if (mesh_soa_build(m) != 0 || mesh_grid_build(m) != 0) {
+        return -1;
+    }
+    return 0;
+}
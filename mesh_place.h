@@ -0,0 +1,40 @@
+#pragma once
+
+#include <stdint.h>
+#include "mesh_settings.h"
+
+typedef struct mesh mesh; // Forward declaration
+
+typedef struct mesh_config mesh_config; // Forward declaration
+
+typedef enum mesh_distribution {
+    MESH_UNIFORM,               /// Independent uniform positions over the area
+    MESH_CLUSTERED,             /// Gaussian clusters of about MESH_CLUSTER_NODES nodes around uniform centers
+    MESH_POISSON_DISK           /// One node per cell of a jittered grid, nodes at least half a cell apart
+}mesh_distribution;
+
+
+///@brief Places every node of the mesh, resets its status and link counts and rebuilds the spatial index.
+/// The position of node i depends only on (seed, distribution, i) so the result does not depend on the thread count.
+///@param m A pointer to the mesh structure, which must not have links yet (see reset_mesh()).
+///@param seed The seed of the placement.
+///@param distribution The distribution of the positions.
+///@param threads The number of workers, 0 to use every online core.
+///@return int 0 on success, -1 if the mesh has links or on allocation failure.
+int mesh_place_nodes(mesh* m, uint64_t seed, mesh_distribution distribution, int threads);
+
+///@brief Computes the position mesh_place_nodes() gives to one node of a mesh built by init_mesh(), without the mesh.
+/// Processes that each hold part of a mesh find their nodes this way.
+///@param config The parameters of the mesh: node count, area, seed, distribution and clusters.
+///@param i The ID of the node.
+///@param x Receives the X coordinate.
+///@param y Receives the Y coordinate.
+void mesh_place_position(const mesh_config* config, int i, float* x, float* y);
+
+///@brief Places every node at a given position, resets its status and link counts and rebuilds the spatial index.
+///@param m A pointer to the mesh structure, which must not have links yet (see reset_mesh()).
+///@param x The X coordinate of each node.
+///@param y The Y coordinate of each node.
+///@param ids The ID of each node in the whole network, which picks its type, NULL when it is the index.
+///@return int 0 on success, -1 if the mesh has links or on allocation failure.
+int mesh_place_nodes_at(mesh* m, const float* x, const float* y, const int* ids);
@@ -0,0 +1,579 @@
+#include <limits.h>
+#include "mesh_compute.h"
+#include "mesh_sim.h"
+#include "mesh_parallel.h"
+#include "mesh_raster.h"
+
+#define RASTER_PATH_SIZE 4096       // Longest frame file name
+#define RASTER_PNG_BLOCK 65535      // Largest stored deflate block
+#define RASTER_ADLER_RUN 5552       // Bytes summed before the Adler-32 sums can overflow
+#define RASTER_HIDDEN UINT64_MAX    // Tile box of the items off the frame
+#define RASTER_FAR (1 << 28)        // Pixel coordinates are clamped to +-RASTER_FAR so the line steps stay in 64 bits
+
+typedef struct raster_job {
+    mesh_raster* r;
+    mesh* m;
+    const mesh_sim* sim;
+    bool fill;                  /// Second sorting pass, entries are written instead of counted
+} raster_job;
+
+/// @brief PNG file being written, the checksums are kept up to date with every byte.
+typedef struct raster_png {
+    FILE* file;
+    uint32_t crc_table[256];
+    uint32_t crc;               /// CRC-32 of the current chunk
+    uint32_t adler_a, adler_b;  /// Adler-32 of the image data
+    size_t left;                /// Image data bytes still to write
+    size_t block_left;          /// Bytes still to write in the current deflate block
+} raster_png;
+
+static uint32_t raster_rgba(unsigned char red, unsigned char green, unsigned char blue, unsigned char alpha) {
+    unsigned char bytes[4] = { red, green, blue, alpha };
+    uint32_t color;
+    memcpy(&color, bytes, sizeof(color));
+    return color;
+}
+
+int mesh_raster_init(mesh_raster* r, int width, int height, int threads) {
+    memset(r, 0, sizeof(*r));
+    if (width <= 0 || height <= 0 || width / MESH_FRAME_TILE >= 0xffff || height / MESH_FRAME_TILE >= 0xffff) {
+        return -1;
+    }
+    r->width = width;
+    r->height = height;
+    r->scale = MESH_FRAME_SCALE;
+    r->threads = mesh_thread_count(threads);
+    r->tiles_x = (width + MESH_FRAME_TILE - 1) / MESH_FRAME_TILE;
+    r->tiles_y = (height + MESH_FRAME_TILE - 1) / MESH_FRAME_TILE;
+    r->slices = r->threads;
+    int tiles = r->tiles_x * r->tiles_y;
+    r->pixels = (uint32_t*)malloc(sizeof(uint32_t) * (size_t)width * height);
+    r->counts = (int*)malloc(sizeof(int) * 2 * tiles * r->slices);
+    r->link_start = (int*)malloc(sizeof(int) * (tiles + 1));
+    r->node_start = (int*)malloc(sizeof(int) * (tiles + 1));
+    if (!r->pixels || !r->counts || !r->link_start || !r->node_start) {
+        mesh_raster_free(r);
+        return -1;
+    }
+    return 0;
+}
+
+void mesh_raster_free(mesh_raster* r) {
+    free(r->pixels);
+    free(r->counts);
+    free(r->link_start);
+    free(r->node_start);
+    free(r->x);
+    free(r->y);
+    free(r->boxes);
+    free(r->link_packets);
+    free(r->link_bin);
+    free(r->node_bin);
+    memset(r, 0, sizeof(*r));
+}
+
+void mesh_raster_fit(mesh_raster* r, mesh* m) {
+    float scale_x = (r->width - MESH_FRAME_NODE_SIZE) / m->size_x;
+    float scale_y = (r->height - MESH_FRAME_NODE_SIZE) / m->size_y;
+    float scale = scale_x < scale_y ? scale_x : scale_y;
+    r->scale = scale > 0.0f ? scale : 1.0f / (m->size_x > m->size_y ? m->size_x : m->size_y);
+    r->shift_x = 0.0f;
+    r->shift_y = 0.0f;
+}
+
+// Projects a slice of the nodes to the top left corners of their squares, in pixels
+static void raster_project(void* ctx, int worker, int begin, int end) {
+    raster_job* job = (raster_job*)ctx;
+    (void)worker;
+    mesh_raster* r = job->r;
+    const mesh_node* nodes = job->m->nodes;
+    for (int i = begin; i < end; i++) {
+        float x = floorf(nodes[i].x * r->scale + r->shift_x);
+        float y = floorf(nodes[i].y * r->scale + r->shift_y);
+        r->x[i] = x > RASTER_FAR ? RASTER_FAR : x < -RASTER_FAR ? -RASTER_FAR : (int)x;
+        r->y[i] = y > RASTER_FAR ? RASTER_FAR : y < -RASTER_FAR ? -RASTER_FAR : (int)y;
+    }
+}
+
+// Tiles under the pixels [x0, x1] x [y0, y1], RASTER_HIDDEN when the box misses the frame
+static uint64_t raster_box(const mesh_raster* r, int x0, int y0, int x1, int y1) {
+    if (x1 < 0 || y1 < 0 || x0 >= r->width || y0 >= r->height) {
+        return RASTER_HIDDEN;
+    }
+    uint64_t tx0 = x0 > 0 ? x0 / MESH_FRAME_TILE : 0;
+    uint64_t ty0 = y0 > 0 ? y0 / MESH_FRAME_TILE : 0;
+    uint64_t tx1 = (x1 < r->width ? x1 : r->width - 1) / MESH_FRAME_TILE;
+    uint64_t ty1 = (y1 < r->height ? y1 : r->height - 1) / MESH_FRAME_TILE;
+    return tx0 | ty0 << 16 | tx1 << 32 | ty1 << 48;
+}
+
+// Counts the tile entries of a slice of items
+static void raster_count(mesh_raster* r, const uint64_t* boxes, int first, int last, int* slot) {
+    for (int i = first; i < last; i++) {
+        uint64_t box = boxes[i];
+        if (box == RASTER_HIDDEN) continue;
+        for (int ty = (int)(box >> 16 & 0xffff); ty <= (int)(box >> 48); ty++) {
+            for (int tx = (int)(box & 0xffff); tx <= (int)(box >> 32 & 0xffff); tx++) {
+                slot[(ty * r->tiles_x + tx) * r->slices]++;
+            }
+        }
+    }
+}
+
+// Finds the tiles of a slice of the links and a slice of the nodes, then counts their entries or, on the
+// fill pass, writes them. Entries carry what the tiles draw so drawing never goes back to the mesh.
+static void raster_sort_slice(void* ctx, int worker, int begin, int end) {
+    raster_job* job = (raster_job*)ctx;
+    (void)worker;
+    mesh_raster* r = job->r;
+    mesh* m = job->m;
+    int tiles = r->tiles_x * r->tiles_y;
+    int half = MESH_FRAME_NODE_SIZE / 2;
+    uint64_t* link_boxes = r->boxes;
+    uint64_t* node_boxes = r->boxes + m->link_count;
+    const uint32_t link_color = raster_rgba(255, 0, 0, 255);
+    const uint32_t busy_color = raster_rgba(255, 255, 0, 255);
+    const uint32_t connected_color = raster_rgba(0, 255, 0, 255);
+    const uint32_t other_color = raster_rgba(0, 0, 255, 255);
+    for (int s = begin; s < end; s++) {
+        int link_first = (int)((long)m->link_count * s / r->slices);
+        int link_last = (int)((long)m->link_count * (s + 1) / r->slices);
+        int node_first = (int)((long)m->node_count * s / r->slices);
+        int node_last = (int)((long)m->node_count * (s + 1) / r->slices);
+        int* link_slot = r->counts + s;
+        int* node_slot = r->counts + (size_t)tiles * r->slices + s;
+        if (!job->fill) {
+            for (int i = link_first; i < link_last; i++) {
+                int source = m->links[i].source_id;
+                int destination = m->links[i].destination_id;
+                int x0 = r->x[source], y0 = r->y[source], x1 = r->x[destination], y1 = r->y[destination];
+                link_boxes[i] = raster_box(r, (x0 < x1 ? x0 : x1) + half, (y0 < y1 ? y0 : y1) + half, (x0 > x1 ? x0 : x1) + half, (y0 > y1 ? y0 : y1) + half);
+            }
+            for (int i = node_first; i < node_last; i++) {
+                node_boxes[i] = raster_box(r, r->x[i], r->y[i], r->x[i] + MESH_FRAME_NODE_SIZE - 1, r->y[i] + MESH_FRAME_NODE_SIZE - 1);
+            }
+            raster_count(r, link_boxes, link_first, link_last, link_slot);
+            raster_count(r, node_boxes, node_first, node_last, node_slot);
+            continue;
+        }
+        for (int i = link_first; i < link_last; i++) {
+            bool busy = false;
+            if (job->sim) {
+                const mesh_sim_link* l = &job->sim->links[i];
+                busy = l->sending >= 0 || l->packets != r->link_packets[i];
+                r->link_packets[i] = l->packets;
+            }
+            uint64_t box = link_boxes[i];
+            if (box == RASTER_HIDDEN) continue;
+            int source = m->links[i].source_id;
+            int destination = m->links[i].destination_id;
+            mesh_raster_line line = { r->x[source] + half, r->y[source] + half, r->x[destination] + half, r->y[destination] + half,
+                                      busy ? busy_color : link_color };
+            for (int ty = (int)(box >> 16 & 0xffff); ty <= (int)(box >> 48); ty++) {
+                for (int tx = (int)(box & 0xffff); tx <= (int)(box >> 32 & 0xffff); tx++) {
+                    r->link_bin[link_slot[(ty * r->tiles_x + tx) * r->slices]++] = line;
+                }
+            }
+        }
+        for (int i = node_first; i < node_last; i++) {
+            uint64_t box = node_boxes[i];
+            if (box == RASTER_HIDDEN) continue;
+            mesh_raster_square square = { r->x[i], r->y[i], m->nodes[i].node_status == CONNECTED ? connected_color : other_color };
+            for (int ty = (int)(box >> 16 & 0xffff); ty <= (int)(box >> 48); ty++) {
+                for (int tx = (int)(box & 0xffff); tx <= (int)(box >> 32 & 0xffff); tx++) {
+                    r->node_bin[node_slot[(ty * r->tiles_x + tx) * r->slices]++] = square;
+                }
+            }
+        }
+    }
+}
+
+// Turns the counts of one kind of item into the offsets each slice writes its entries at, slices in order within a tile
+static int raster_offsets(mesh_raster* r, int* slot, int* start) {
+    int tiles = r->tiles_x * r->tiles_y;
+    int total = 0;
+    for (int t = 0; t < tiles; t++) {
+        start[t] = total;
+        for (int s = 0; s < r->slices; s++) {
+            int count = slot[t * r->slices + s];
+            slot[t * r->slices + s] = total;
+            if (count > INT_MAX - total) {
+                return -1;
+            }
+            total += count;
+        }
+    }
+    start[tiles] = total;
+    return total;
+}
+
+static int raster_reserve_items(mesh_raster* r, int count) {
+    if (count > r->item_capacity) {
+        int* x = (int*)realloc(r->x, sizeof(int) * count);
+        if (x) r->x = x;
+        int* y = (int*)realloc(r->y, sizeof(int) * count);
+        if (y) r->y = y;
+        uint64_t* boxes = (uint64_t*)realloc(r->boxes, sizeof(uint64_t) * count);
+        if (boxes) r->boxes = boxes;
+        if (!x || !y || !boxes) {
+            return -1;
+        }
+        r->item_capacity = count;
+    }
+    return 0;
+}
+
+static int raster_reserve(void** bin, int* capacity, int count, size_t size) {
+    if (count > *capacity) {
+        int grown = *capacity > 0 ? *capacity : 1024;
+        while (grown < count) grown = grown > INT_MAX / 2 ? count : grown * 2;
+        void* entries = realloc(*bin, size * grown);
+        if (!entries) {
+            return -1;
+        }
+        *bin = entries;
+        *capacity = grown;
+    }
+    return 0;
+}
+
+// One pixel wide line between the centers of two node squares, one pixel per column, or per row when steep.
+// The pixels are found with exact integer steps and only depend on the line, so the tiles join without seams.
+static void raster_line(mesh_raster* r, uint32_t color, int x0, int y0, int x1, int y1, int left, int top, int right, int bottom) {
+    bool steep = abs(y1 - y0) > abs(x1 - x0);
+    int t;
+    if (steep) {
+        t = x0; x0 = y0; y0 = t;
+        t = x1; x1 = y1; y1 = t;
+        t = left; left = top; top = t;
+        t = right; right = bottom; bottom = t;
+    }
+    if (x1 < x0) {
+        t = x0; x0 = x1; x1 = t;
+        t = y0; y0 = y1; y1 = t;
+    }
+    int64_t dx = x1 - x0;
+    int64_t dy = y1 - y0;
+    if (dx == 0) {
+        return;
+    }
+    // Step k crosses the pixel center x0 + k + 0.5, at the row y0 + floor((2k + 1) dy / 2dx)
+    int64_t k = left > x0 ? left - x0 : 0;
+    int64_t k_end = right - x0 < dx ? right - x0 : dx;
+    // Walked with the remainder of the division, away from y0 by |dy| / dx rows per step
+    int64_t direction = dy < 0 ? -1 : 1;
+    int64_t rise = 2 * (dy < 0 ? -dy : dy);
+    int64_t den = 2 * dx;
+    int64_t num = (2 * k + 1) * (rise / 2) + (dy < 0 ? den - 1 : 0);
+    int64_t v = y0 + direction * (num / den);
+    int64_t rem = num % den;
+    uint32_t* pixels = r->pixels;
+    int64_t width = r->width;
+    int64_t stride = steep ? width : 1;     // From one step to the next
+    int64_t row_stride = steep ? 1 : width; // From one row to the next
+    for (; k < k_end; k++) {
+        if (v >= top && v < bottom) {
+            pixels[(x0 + k) * stride + v * row_stride] = color;
+        } else if ((direction > 0) == (v >= bottom)) {
+            break; // Left the tile for good
+        }
+        rem += rise;
+        int64_t carry = rem >= den;
+        rem -= carry * den;
+        v += carry * direction;
+    }
+}
+
+static void raster_tile(void* ctx, int worker, int begin, int end) {
+    raster_job* job = (raster_job*)ctx;
+    (void)worker;
+    mesh_raster* r = job->r;
+    const uint32_t background = raster_rgba(0, 0, 0, 255);
+    for (int t = begin; t < end; t++) {
+        int left = t % r->tiles_x * MESH_FRAME_TILE;
+        int top = t / r->tiles_x * MESH_FRAME_TILE;
+        int right = left + MESH_FRAME_TILE < r->width ? left + MESH_FRAME_TILE : r->width;
+        int bottom = top + MESH_FRAME_TILE < r->height ? top + MESH_FRAME_TILE : r->height;
+        for (int y = top; y < bottom; y++) {
+            uint32_t* row = r->pixels + (size_t)y * r->width;
+            for (int x = left; x < right; x++) row[x] = background;
+        }
+        // Links first, nodes on top
+        for (int e = r->link_start[t]; e < r->link_start[t + 1]; e++) {
+            const mesh_raster_line* line = &r->link_bin[e];
+            raster_line(r, line->color, line->x0, line->y0, line->x1, line->y1, left, top, right, bottom);
+        }
+        for (int e = r->node_start[t]; e < r->node_start[t + 1]; e++) {
+            const mesh_raster_square* square = &r->node_bin[e];
+            int x0 = square->x > left ? square->x : left;
+            int x1 = square->x + MESH_FRAME_NODE_SIZE < right ? square->x + MESH_FRAME_NODE_SIZE : right;
+            int y0 = square->y > top ? square->y : top;
+            int y1 = square->y + MESH_FRAME_NODE_SIZE < bottom ? square->y + MESH_FRAME_NODE_SIZE : bottom;
+            for (int py = y0; py < y1; py++) {
+                uint32_t* row = r->pixels + (size_t)py * r->width;
+                for (int px = x0; px < x1; px++) row[px] = square->color;
+            }
+        }
+    }
+}
+
+int mesh_raster_draw(mesh_raster* r, mesh* m, const mesh_sim* sim) {
+    MESH_TIMED(MESH_TIME_RASTER);
+    int tiles = r->tiles_x * r->tiles_y;
+    raster_job job = { r, m, sim, false };
+    if (sim && (sim != r->sim || m->link_count > r->packet_capacity)) {
+        // A new simulation, its links are busy from the next frame on
+        long* packets = (long*)realloc(r->link_packets, sizeof(long) * (m->link_count > 0 ? m->link_count : 1));
+        if (!packets) {
+            return -1;
+        }
+        r->link_packets = packets;
+        r->packet_capacity = m->link_count;
+        for (int i = 0; i < m->link_count; i++) r->link_packets[i] = sim->links[i].packets;
+    }
+    r->sim = sim;
+
+    if (raster_reserve_items(r, m->node_count + m->link_count) != 0) {
+        return -1;
+    }
+    mesh_parallel_for(m->node_count, 4096, r->threads, raster_project, &job);
+
+    // Count the entries of every slice per tile, turn the counts into write offsets, then write the entries
+    memset(r->counts, 0, sizeof(int) * 2 * tiles * r->slices);
+    mesh_parallel_for(r->slices, 1, r->threads, raster_sort_slice, &job);
+    int links = raster_offsets(r, r->counts, r->link_start);
+    int nodes = raster_offsets(r, r->counts + (size_t)tiles * r->slices, r->node_start);
+    if (links < 0 || nodes < 0 || raster_reserve((void**)&r->link_bin, &r->link_capacity, links, sizeof(mesh_raster_line)) != 0 ||
+        raster_reserve((void**)&r->node_bin, &r->node_capacity, nodes, sizeof(mesh_raster_square)) != 0) {
+        return -1;
+    }
+    job.fill = true;
+    mesh_parallel_for(r->slices, 1, r->threads, raster_sort_slice, &job);
+
+    mesh_parallel_for(tiles, 1, r->threads, raster_tile, &job);
+    r->frames++;
+    return 0;
+}
+
+int mesh_raster_write_ppm(const mesh_raster* r, const char* filename) {
+    FILE* file = fopen(filename, "wb");
+    if (!file) {
+        return -1;
+    }
+    unsigned char* row = (unsigned char*)malloc((size_t)3 * r->width);
+    int status = row ? 0 : -1;
+    fprintf(file, "P6\n%d %d\n255\n", r->width, r->height);
+    for (int y = 0; y < r->height && status == 0; y++) {
+        const unsigned char* pixel = (const unsigned char*)(r->pixels + (size_t)y * r->width);
+        for (int x = 0; x < r->width; x++) {
+            memcpy(row + 3 * x, pixel + 4 * x, 3);
+        }
+        if (fwrite(row, 3, r->width, file) != (size_t)r->width) status = -1;
+    }
+    free(row);
+    if (fclose(file) != 0) status = -1;
+    return status;
+}
+
+static void png_write(raster_png* p, const void* data, size_t size) {
+    const unsigned char* bytes = (const unsigned char*)data;
+    uint32_t crc = p->crc;
+    for (size_t i = 0; i < size; i++) {
+        crc = p->crc_table[(crc ^ bytes[i]) & 0xff] ^ (crc >> 8);
+    }
+    p->crc = crc;
+    fwrite(data, 1, size, p->file);
+}
+
+static void png_u32(raster_png* p, uint32_t value) {
+    unsigned char bytes[4] = { (unsigned char)(value >> 24), (unsigned char)(value >> 16), (unsigned char)(value >> 8), (unsigned char)value };
+    png_write(p, bytes, 4);
+}
+
+static void png_chunk_begin(raster_png* p, uint32_t length, const char* type) {
+    png_u32(p, length); // The length is not part of the CRC, it restarts below
+    p->crc = 0xffffffffu;
+    png_write(p, type, 4);
+}
+
+static void png_chunk_end(raster_png* p) {
+    png_u32(p, p->crc ^ 0xffffffffu);
+}
+
+// Image data as stored deflate blocks, each opened with its header once the previous one is full
+static void png_data(raster_png* p, const unsigned char* data, size_t size) {
+    while (size > 0) {
+        if (p->block_left == 0) {
+            size_t length = p->left < RASTER_PNG_BLOCK ? p->left : RASTER_PNG_BLOCK;
+            unsigned char header[5] = { (unsigned char)(length == p->left), (unsigned char)length, (unsigned char)(length >> 8),
+                                        (unsigned char)~length, (unsigned char)(~length >> 8) };
+            png_write(p, header, sizeof(header));
+            p->block_left = length;
+        }
+        size_t run = size < p->block_left ? size : p->block_left;
+        if (run > RASTER_ADLER_RUN) run = RASTER_ADLER_RUN;
+        uint32_t a = p->adler_a, b = p->adler_b;
+        for (size_t i = 0; i < run; i++) {
+            a += data[i];
+            b += a;
+        }
+        p->adler_a = a % 65521;
+        p->adler_b = b % 65521;
+        png_write(p, data, run);
+        p->block_left -= run;
+        p->left -= run;
+        data += run;
+        size -= run;
+    }
+}
+
+int mesh_raster_write_png(const mesh_raster* r, const char* filename) {
+    size_t row_size = (size_t)4 * r->width + 1; // Filter byte, then the pixels
+    size_t raw = row_size * r->height;
+    size_t blocks = (raw + RASTER_PNG_BLOCK - 1) / RASTER_PNG_BLOCK;
+    size_t idat = 2 + raw + 5 * blocks + 4;
+    if (idat > 0x7fffffffu) {
+        return -1;
+    }
+    raster_png p;
+    p.file = fopen(filename, "wb");
+    if (!p.file) {
+        return -1;
+    }
+    for (uint32_t n = 0; n < 256; n++) {
+        uint32_t c = n;
+        for (int k = 0; k < 8; k++) c = c & 1 ? 0xedb88320u ^ (c >> 1) : c >> 1;
+        p.crc_table[n] = c;
+    }
+    static const unsigned char signature[8] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1a, '\n' };
+    fwrite(signature, 1, sizeof(signature), p.file);
+
+    png_chunk_begin(&p, 13, "IHDR");
+    png_u32(&p, (uint32_t)r->width);
+    png_u32(&p, (uint32_t)r->height);
+    const unsigned char format[5] = { 8, 6, 0, 0, 0 }; // 8 bits RGBA, deflate, adaptive filters, no interlace
+    png_write(&p, format, sizeof(format));
+    png_chunk_end(&p);
+
+    png_chunk_begin(&p, (uint32_t)idat, "IDAT");
+    const unsigned char zlib_header[2] = { 0x78, 0x01 };
+    png_write(&p, zlib_header, sizeof(zlib_header));
+    p.adler_a = 1;
+    p.adler_b = 0;
+    p.left = raw;
+    p.block_left = 0;
+    const unsigned char filter = 0;
+    for (int y = 0; y < r->height; y++) {
+        png_data(&p, &filter, 1);
+        png_data(&p, (const unsigned char*)(r->pixels + (size_t)y * r->width), row_size - 1);
+    }
+    png_u32(&p, p.adler_b << 16 | p.adler_a);
+    png_chunk_end(&p);
+
+    png_chunk_begin(&p, 0, "IEND");
+    png_chunk_end(&p);
+    int status = ferror(p.file) ? -1 : 0;
+    if (fclose(p.file) != 0) status = -1;
+    return status;
+}
+
+int mesh_raster_write_raw(const mesh_raster* r, FILE* file) {
+    size_t count = (size_t)r->width * r->height;
+    return fwrite(r->pixels, sizeof(uint32_t), count, file) == count ? 0 : -1;
+}
+
+// The pattern is handed to snprintf() with the frame number alone: one %d or %i with flags, width and precision
+// but no '*' or length modifier, and any number of %%
+static bool raster_pattern_valid(const char* pattern) {
+    int conversions = 0;
+    for (const char* c = strchr(pattern, '%'); c; c = strchr(c + 1, '%')) {
+        c++;
+        if (*c == '%') continue;
+        c += strspn(c, "-+ #0");
+        c += strspn(c, "0123456789");
+        if (*c == '.') {
+            c++;
+            c += strspn(c, "0123456789");
+        }
+        if (*c != 'd' && *c != 'i') {
+            return false;
+        }
+        conversions++;
+    }
+    return conversions == 1;
+}
+
+long mesh_raster_play(mesh_raster* r, mesh_sim* sim, double tick, double until, const char* output) {
+    size_t length = strlen(output);
+    bool stdout_stream = strcmp(output, "-") == 0;
+    bool stream = stdout_stream || (length > 5 && strcmp(output + length - 5, ".rgba") == 0);
+    bool png = length > 4 && strcmp(output + length - 4, ".png") == 0;
+    // Images need the frame number in their names, or each one would replace the previous one
+    if (!(tick > 0.0)) {
+        return -1;
+    }
+    if (!stream && !raster_pattern_valid(output)) {
+        fprintf(stderr, "mesh_raster_play: '%s' needs exactly one %%d for the frame number\n", output);
+        return -1;
+    }
+    FILE* file = NULL;
+    if (stream) {
+        file = stdout_stream ? stdout : fopen(output, "wb");
+        if (!file) {
+            return -1;
+        }
+    }
+
+    long frames = 0;
+    int status = 0;
+    double now = sim->now;
+    double next;
+    for (;;) {
+        status = mesh_raster_draw(r, sim->m, sim);
+        if (status == 0) {
+            if (stream) {
+                status = mesh_raster_write_raw(r, file);
+            } else {
+                char name[RASTER_PATH_SIZE];
+                int written = snprintf(name, sizeof(name), output, (int)frames);
+                status = written < 0 || written >= (int)sizeof(name) ? -1
+                       : png ? mesh_raster_write_png(r, name) : mesh_raster_write_ppm(r, name);
+            }
+        }
+        if (status != 0) break;
+        frames++;
+        if (!mesh_calendar_peek(&sim->queue, &next) || now >= until) break;
+        now = now + tick < until ? now + tick : until;
+        if (mesh_sim_run(sim, now) < 0) {
+            status = -1;
+            break;
+        }
+    }
+
+    if (file) {
+        if (fflush(file) != 0) status = -1;
+        if (!stdout_stream && fclose(file) != 0) status = -1;
+    }
+    return status == 0 ? frames : -1;
+}
+
+long compute_mesh_frames(mesh* m, const char* output) {
+    mesh_sim sim;
+    if (mesh_sim_init(&sim, m) != 0) {
+        return -1;
+    }
+    mesh_raster r;
+    if (mesh_raster_init(&r, m->config.frame_width, m->config.frame_height, m->threads) != 0) {
+        mesh_sim_free(&sim);
+        return -1;
+    }
+    mesh_raster_fit(&r, m);
+    mesh_sim_add_gateway_flows(&sim);
+    long frames = mesh_raster_play(&r, &sim, m->config.frame_tick, INFINITY, output);
+    if (frames >= 0 && mesh_sim_write_stats(&sim, "mesh_sim.csv") != 0) {
+        frames = -1;
+    }
+    mesh_raster_free(&r);
+    mesh_sim_free(&sim);
+    return frames;
+}
@@ -0,0 +1,117 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdio.h>
+#include "mesh_settings.h"
+
+typedef struct mesh mesh; // Forward declaration
+typedef struct mesh_sim mesh_sim;
+
+typedef struct mesh_raster_line mesh_raster_line;
+typedef struct mesh_raster_square mesh_raster_square;
+typedef struct mesh_raster mesh_raster;
+
+
+/// @brief Link as sorted into a tile, from the center of the source square to the center of the destination square.
+struct mesh_raster_line{
+    int x0, y0;                 /// Start pixel
+    int x1, y1;                 /// End pixel
+    uint32_t color;             /// RGBA bytes
+};
+
+/// @brief Node as sorted into a tile.
+struct mesh_raster_square{
+    int x, y;                   /// Top left pixel
+    uint32_t color;             /// RGBA bytes
+};
+
+/// @brief Offscreen frame drawing the picture of Sdl_RenderMesh() without SDL: black background,
+/// red links, green connected nodes and blue other nodes. The frame is cut in MESH_FRAME_TILE tiles,
+/// nodes and links are sorted into the tiles they cover, then the tiles are drawn in parallel.
+struct mesh_raster{
+    int width, height;          /// Size of the frame in pixels
+    uint32_t* pixels;           /// R, G, B and A bytes of each pixel, row by row from the top left
+    float scale;                /// Pixels per meter
+    float shift_x, shift_y;     /// Pixel position of the mesh origin
+    int threads;                /// Workers drawing the tiles
+    int tiles_x, tiles_y;       /// Number of tiles along X and Y
+    int slices;                 /// Parts the nodes and links are split in to be sorted in parallel
+    int* x;                     /// Left pixel of the square of each node
+    int* y;                     /// Top pixel of the square of each node
+    uint64_t* boxes;            /// Tiles covered by each link then each node, 16 bits per bound, all ones off the frame
+    int item_capacity;          /// Entries x, y and boxes can hold
+    int* counts;                /// Nodes and links of each slice per tile, then where the slice writes them
+    int* link_start;            /// First entry of each tile in link_bin, one more entry for the end
+    int* node_start;            /// First entry of each tile in node_bin, one more entry for the end
+    mesh_raster_line* link_bin; /// Links sorted by tile
+    mesh_raster_square* node_bin; /// Nodes sorted by tile
+    int link_capacity;          /// Entries link_bin can hold
+    int node_capacity;          /// Entries node_bin can hold
+    const mesh_sim* sim;        /// Simulation of the last frame, NULL if it had none
+    long* link_packets;         /// Packets each link had sent at the last frame of sim
+    int packet_capacity;        /// Entries link_packets can hold
+    long frames;                /// Number of frames drawn
+};
+
+
+///@brief Allocates a frame, with the view of Sdl_RenderMesh(): MESH_FRAME_SCALE pixels per meter from the top left corner.
+///@param r A pointer to the frame to initialize.
+///@param width The width in pixels.
+///@param height The height in pixels.
+///@param threads The number of workers, 0 to use every online core.
+///@return int 0 on success, -1 on allocation failure.
+int mesh_raster_init(mesh_raster* r, int width, int height, int threads);
+
+///@brief Frees the buffers of a frame.
+///@param r A pointer to the frame.
+void mesh_raster_free(mesh_raster* r);
+
+///@brief Sets the view so that the whole mesh area fits in the frame.
+///@param r A pointer to the frame.
+///@param m A pointer to the mesh structure.
+void mesh_raster_fit(mesh_raster* r, mesh* m);
+
+///@brief Draws the links then the nodes of a mesh into the frame.
+///@param r A pointer to the frame.
+///@param m A pointer to the mesh structure.
+///@param sim A simulation over the mesh, or NULL. Links serializing a packet, or that sent one since the previous
+/// frame of the same simulation, are drawn in yellow.
+///@return int 0 on success, -1 on allocation failure.
+int mesh_raster_draw(mesh_raster* r, mesh* m, const mesh_sim* sim);
+
+///@brief Writes the frame as a binary PPM image, the alpha channel is dropped.
+///@param r A pointer to the frame.
+///@param filename The path of the image.
+///@return int 0 on success, -1 on failure.
+int mesh_raster_write_ppm(const mesh_raster* r, const char* filename);
+
+///@brief Writes the frame as an RGBA PNG image. The image data is stored without compression.
+///@param r A pointer to the frame.
+///@param filename The path of the image.
+///@return int 0 on success, -1 on failure.
+int mesh_raster_write_png(const mesh_raster* r, const char* filename);
+
+///@brief Appends the frame to a stream of raw RGBA frames, as read by `ffmpeg -f rawvideo -pix_fmt rgba -s WxH -i -`.
+///@param r A pointer to the frame.
+///@param file The stream.
+///@return int 0 on success, -1 on failure.
+int mesh_raster_write_raw(const mesh_raster* r, FILE* file);
+
+///@brief Runs a simulation tick by tick and writes a frame after every tick, and one of the start.
+/// Stops when no event is left or the time limit is reached.
+///@param r A pointer to the frame.
+///@param sim A pointer to the simulation.
+///@param tick The simulated time between two frames, in ms.
+///@param until The time at which to stop, in ms.
+///@param output "-" streams raw frames to stdout, a path ending in .rgba streams them to a file,
+/// anything else is a printf pattern of the image names with the frame number, PNG when it ends in .png, PPM otherwise.
+/// The pattern must hold exactly one %d or %i conversion, such as frame_%05d.png, and may hold %%.
+///@return long The number of frames written, -1 on failure or on a bad pattern.
+long mesh_raster_play(mesh_raster* r, mesh_sim* sim, double tick, double until, const char* output);
+
+///@brief Simulates the gateway traffic of compute_mesh() and records it with mesh_raster_play(), with the frame
+/// size and tick of the mesh configuration and the whole area in view. Statistics go to mesh_sim.csv.
+///@param m A pointer to the mesh structure.
+///@param output The frames, as for mesh_raster_play().
+///@return long The number of frames written, -1 on failure.
+long compute_mesh_frames(mesh* m, const char* output);
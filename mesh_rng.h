@@ -0,0 +1,32 @@
+#pragma once
+
+#include <stdint.h>
+
+/// Counter-based generator: every draw is a pure function of (seed, stream, counter), so any
+/// item of a parallel loop computes its own numbers without shared state. The mixing is the
+/// SplitMix64 finalizer (Steele et al., 2014), applied to a key derived from seed and stream.
+
+static inline uint64_t mesh_rng_mix(uint64_t z) {
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+    return z ^ (z >> 31);
+}
+
+///@brief Returns 64 random bits.
+///@param seed The seed of the sequence.
+///@param stream Separates the independent uses of one seed.
+///@param counter The index of the draw in the stream.
+static inline uint64_t mesh_rng_u64(uint64_t seed, uint64_t stream, uint64_t counter) {
+    uint64_t key = mesh_rng_mix(seed + 0x9e3779b97f4a7c15ULL * (2 * stream + 1));
+    return mesh_rng_mix(key + 0x9e3779b97f4a7c15ULL * (counter + 1));
+}
+
+///@brief Returns a float uniformly drawn in [0, 1).
+static inline float mesh_rng_float(uint64_t seed, uint64_t stream, uint64_t counter) {
+    return (float)(mesh_rng_u64(seed, stream, counter) >> 40) * (1.0f / 16777216.0f);
+}
+
+///@brief Returns a double uniformly drawn in [0, 1).
+static inline double mesh_rng_double(uint64_t seed, uint64_t stream, uint64_t counter) {
+    return (double)(mesh_rng_u64(seed, stream, counter) >> 11) * (1.0 / 9007199254740992.0);
+}
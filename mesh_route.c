@@ -0,0 +1,348 @@
+#include "mesh_compute.h"
+#include "mesh_parallel.h"
+
+typedef struct route_job {
+    mesh* m;
+    mesh_routes* r;
+    mesh_csr* csr;
+    int* owner;                 /// Worker holding the runs of each table until they are merged
+    int failed;                 /// Set by a worker that could not grow its run buffers
+} route_job;
+
+static int route_prepare(mesh* m, mesh_routes* r, int workers) {
+    int n = m->node_count;
+    if (r->node_count != n) {
+        r->table_of = (int*)mesh_arena_alloc(&m->arena, sizeof(int) * n);
+        if (!r->table_of) {
+            return -1;
+        }
+        memset(r->table_of, -1, sizeof(int) * n);
+        r->node_count = n;
+        r->table_count = 0;
+        for (int v = 0; v < n; v++) {
+            if (m->nodes[v].node_type != ROUTER) continue;
+            if (r->table_count == r->table_capacity) {
+                int capacity = r->table_capacity ? r->table_capacity * 2 : 64;
+                mesh_route_table* tables = (mesh_route_table*)mesh_arena_realloc(&m->arena, r->tables, sizeof(mesh_route_table) * r->table_capacity, sizeof(mesh_route_table) * capacity);
+                if (!tables) {
+                    return -1;
+                }
+                r->tables = tables;
+                r->table_capacity = capacity;
+            }
+            r->tables[r->table_count].node_id = v;
+            r->table_of[v] = r->table_count++;
+        }
+    }
+    if (r->scratch_count < workers) {
+        mesh_route_scratch* scratch = (mesh_route_scratch*)mesh_arena_realloc(&m->arena, r->scratch, sizeof(mesh_route_scratch) * r->scratch_count, sizeof(mesh_route_scratch) * workers);
+        if (!scratch) {
+            return -1;
+        }
+        r->scratch = scratch;
+        for (int i = r->scratch_count; i < workers; i++) {
+            mesh_route_scratch* s = &scratch[i];
+            memset(s, 0, sizeof(*s));
+            s->dist = (float*)mesh_arena_alloc(&m->arena, sizeof(float) * n);
+            s->port = (unsigned char*)mesh_arena_alloc(&m->arena, n);
+            s->heap = (int*)mesh_arena_alloc(&m->arena, sizeof(int) * n);
+            s->heap_pos = (int*)mesh_arena_alloc(&m->arena, sizeof(int) * n);
+            if (!s->dist || !s->port || !s->heap || !s->heap_pos) {
+                return -1;
+            }
+            memset(s->heap_pos, -1, sizeof(int) * n);
+            r->scratch_count = i + 1;
+        }
+    }
+    return 0;
+}
+
+// Outgrown buffers stay in the arena until the mesh is reset, like the adjacency
+static int route_reserve(mesh* m, mesh_routes* r, int tables, int ports, int runs) {
+    if (tables > r->table_capacity) {
+        int capacity = r->table_capacity * 2 > tables ? r->table_capacity * 2 : tables;
+        mesh_route_table* grown = (mesh_route_table*)mesh_arena_realloc(&m->arena, r->tables, sizeof(mesh_route_table) * r->table_capacity, sizeof(mesh_route_table) * capacity);
+        if (!grown) {
+            return -1;
+        }
+        r->tables = grown;
+        r->table_capacity = capacity;
+    }
+    if (!r->compress && r->next_capacity < r->table_capacity) {
+        size_t row = (size_t)r->node_count;
+        unsigned char* next = (unsigned char*)mesh_arena_realloc(&m->arena, r->next, row * r->next_capacity, row * r->table_capacity);
+        if (!next) {
+            return -1;
+        }
+        r->next = next;
+        r->next_capacity = r->table_capacity;
+    }
+    if (ports > r->port_capacity) {
+        int capacity = r->port_capacity * 2 > ports ? r->port_capacity * 2 : ports;
+        int* port_link = (int*)mesh_arena_realloc(&m->arena, r->port_link, sizeof(int) * r->port_capacity, sizeof(int) * capacity);
+        if (!port_link) {
+            return -1;
+        }
+        r->port_link = port_link;
+        r->port_capacity = capacity;
+    }
+    if (runs > r->run_capacity) {
+        int capacity = r->run_capacity * 2 > runs ? r->run_capacity * 2 : runs;
+        int* run_start = (int*)mesh_arena_realloc(&m->arena, r->run_start, sizeof(int) * r->run_capacity, sizeof(int) * capacity);
+        unsigned char* run_port = run_start ? (unsigned char*)mesh_arena_realloc(&m->arena, r->run_port, r->run_capacity, capacity) : NULL;
+        if (!run_start || !run_port) {
+            return -1;
+        }
+        r->run_start = run_start;
+        r->run_port = run_port;
+        r->run_capacity = capacity;
+    }
+    return 0;
+}
+
+// Numbers the outgoing links of the node of a table as its ports
+static void route_set_ports(mesh_routes* r, const mesh_csr* csr, int table) {
+    mesh_route_table* t = &r->tables[table];
+    int v = t->node_id;
+    int count = csr->out_degree[v] < MESH_ROUTE_MAX_PORTS ? csr->out_degree[v] : MESH_ROUTE_MAX_PORTS;
+    t->port_offset = r->port_count;
+    t->port_count = count;
+    memcpy(r->port_link + r->port_count, csr->out_link + csr->out_offset[v], sizeof(int) * count);
+    r->port_count += count;
+}
+
+static void route_heap_up(mesh_route_scratch* s, int i) {
+    int v = s->heap[i];
+    while (i > 0) {
+        int parent = (i - 1) / 2;
+        int p = s->heap[parent];
+        if (s->dist[p] <= s->dist[v]) break;
+        s->heap[i] = p;
+        s->heap_pos[p] = i;
+        i = parent;
+    }
+    s->heap[i] = v;
+    s->heap_pos[v] = i;
+}
+
+static void route_heap_down(mesh_route_scratch* s, int size, int i) {
+    int v = s->heap[i];
+    for (;;) {
+        int child = 2 * i + 1;
+        if (child >= size) break;
+        if (child + 1 < size && s->dist[s->heap[child + 1]] < s->dist[s->heap[child]]) child++;
+        int c = s->heap[child];
+        if (s->dist[c] >= s->dist[v]) break;
+        s->heap[i] = c;
+        s->heap_pos[c] = i;
+        i = child;
+    }
+    s->heap[i] = v;
+    s->heap_pos[v] = i;
+}
+
+// Dijkstra from a node carrying the port of the first link along, only routers forward
+static void route_search(mesh* m, const mesh_csr* csr, path_metric metric, mesh_route_scratch* s, int source) {
+    int n = m->node_count;
+    for (int v = 0; v < n; v++) {
+        s->dist[v] = INFINITY;
+        s->port[v] = MESH_ROUTE_NONE;
+    }
+    s->dist[source] = 0.0f;
+    s->heap[0] = source;
+    s->heap_pos[source] = 0;
+    int size = 1;
+    while (size > 0) {
+        int x = s->heap[0];
+        s->heap_pos[x] = -1;
+        if (--size > 0) {
+            s->heap[0] = s->heap[size];
+            route_heap_down(s, size, 0);
+        }
+        if (m->soa.node_status[x] == INACTIVE) continue;
+        if (x != source && m->nodes[x].node_type != ROUTER) continue;
+        int first = csr->out_offset[x];
+        int last = first + csr->out_degree[x];
+        if (x == source && last - first > MESH_ROUTE_MAX_PORTS) last = first + MESH_ROUTE_MAX_PORTS;
+        for (int e = first; e < last; e++) {
+            int y = csr->out_target[e];
+            if (m->soa.node_status[y] == INACTIVE) continue;
+            float candidate = s->dist[x] + (metric == METRIC_HOPS ? 1.0f : csr->out_latency[e]);
+            if (candidate < s->dist[y]) {
+                s->dist[y] = candidate;
+                s->port[y] = x == source ? (unsigned char)(e - first) : s->port[x];
+                if (s->heap_pos[y] < 0) {
+                    s->heap[size] = y;
+                    s->heap_pos[y] = size++;
+                }
+                route_heap_up(s, s->heap_pos[y]);
+            }
+        }
+    }
+}
+
+// Builds one table, into its row or into the runs of the worker
+static int route_compute(mesh* m, mesh_routes* r, const mesh_csr* csr, mesh_route_scratch* s, int table) {
+    mesh_route_table* t = &r->tables[table];
+    int n = m->node_count;
+    route_search(m, csr, r->metric, s, t->node_id);
+    if (!r->compress) {
+        memcpy(r->next + (size_t)table * n, s->port, n);
+        return 0;
+    }
+    t->run_offset = s->run_count;
+    for (int d = 0; d < n; d++) {
+        if (d > 0 && s->port[d] == s->port[d - 1]) continue;
+        if (s->run_count == s->run_capacity) {
+            int capacity = s->run_capacity ? s->run_capacity * 2 : 1024;
+            int* run_start = (int*)realloc(s->run_start, sizeof(int) * capacity);
+            if (!run_start) {
+                return -1;
+            }
+            s->run_start = run_start;
+            unsigned char* run_port = (unsigned char*)realloc(s->run_port, capacity);
+            if (!run_port) {
+                return -1;
+            }
+            s->run_port = run_port;
+            s->run_capacity = capacity;
+        }
+        s->run_start[s->run_count] = d;
+        s->run_port[s->run_count++] = s->port[d];
+    }
+    t->run_count = s->run_count - t->run_offset;
+    return 0;
+}
+
+// Copies the runs of a table from its worker into the shared arrays, room must be reserved
+static void route_move_runs(mesh_routes* r, mesh_route_table* t, const mesh_route_scratch* s) {
+    memcpy(r->run_start + r->run_count, s->run_start + t->run_offset, sizeof(int) * t->run_count);
+    memcpy(r->run_port + r->run_count, s->run_port + t->run_offset, t->run_count);
+    t->run_offset = r->run_count;
+    r->run_count += t->run_count;
+}
+
+static void route_release_runs(mesh_routes* r) {
+    for (int i = 0; i < r->scratch_count; i++) {
+        mesh_route_scratch* s = &r->scratch[i];
+        free(s->run_start);
+        free(s->run_port);
+        s->run_start = NULL;
+        s->run_port = NULL;
+        s->run_count = 0;
+        s->run_capacity = 0;
+    }
+}
+
+static void route_build_range(void* ctx, int worker, int begin, int end) {
+    route_job* job = (route_job*)ctx;
+    for (int i = begin; i < end; i++) {
+        if (route_compute(job->m, job->r, job->csr, &job->r->scratch[worker], i) != 0) {
+            job->failed = 1;
+        }
+        job->owner[i] = worker;
+    }
+}
+
+int mesh_build_routes(mesh* m, path_metric metric, bool compress, int threads) {
+    MESH_TIMED(MESH_TIME_BUILD_ROUTES);
+    mesh_routes* r = &m->routes;
+    int workers = mesh_thread_count(threads);
+    r->built = false;
+    mesh_csr* csr = mesh_get_csr(m);
+    if (!csr || route_prepare(m, r, workers) != 0) {
+        return -1;
+    }
+    r->metric = metric;
+    r->compress = compress;
+    int ports = 0;
+    for (int i = 0; i < r->table_count; i++) {
+        int v = r->tables[i].node_id;
+        ports += csr->out_degree[v] < MESH_ROUTE_MAX_PORTS ? csr->out_degree[v] : MESH_ROUTE_MAX_PORTS;
+    }
+    if (route_reserve(m, r, r->table_count, ports, 0) != 0) {
+        return -1;
+    }
+    r->port_count = 0;
+    for (int i = 0; i < r->table_count; i++) {
+        route_set_ports(r, csr, i);
+    }
+
+    // Rows are disjoint and written in place, runs wait in the worker buffers until merged in table order
+    route_job job = { m, r, csr, (int*)malloc(sizeof(int) * (r->table_count > 0 ? r->table_count : 1)), 0 };
+    if (!job.owner) {
+        return -1;
+    }
+    mesh_parallel_for(r->table_count, 1, workers, route_build_range, &job);
+
+    int status = job.failed ? -1 : 0;
+    if (status == 0 && compress) {
+        int runs = 0;
+        for (int i = 0; i < r->table_count; i++) runs += r->tables[i].run_count;
+        r->run_count = 0;
+        if (route_reserve(m, r, r->table_count, ports, runs) != 0) {
+            status = -1;
+        } else {
+            for (int i = 0; i < r->table_count; i++) {
+                route_move_runs(r, &r->tables[i], &r->scratch[job.owner[i]]);
+            }
+        }
+    }
+    route_release_runs(r);
+    free(job.owner);
+    if (status == 0) {
+        r->version = m->version;
+        r->built = true;
+    }
+    return status;
+}
+
+mesh_routes* mesh_get_routes(mesh* m, path_metric metric) {
+    mesh_routes* r = &m->routes;
+    if (!r->built || r->version != m->version || r->metric != metric) {
+        if (mesh_build_routes(m, metric, r->built ? r->compress : m->config.route_compress, m->threads) != 0) {
+            return NULL;
+        }
+    }
+    return r;
+}
+
+// End devices get their table the first time they send, later builds keep it
+static int route_add_table(mesh* m, mesh_routes* r, int node_id) {
+    mesh_csr* csr = mesh_get_csr(m);
+    int degree = csr ? (csr->out_degree[node_id] < MESH_ROUTE_MAX_PORTS ? csr->out_degree[node_id] : MESH_ROUTE_MAX_PORTS) : 0;
+    if (!csr || route_reserve(m, r, r->table_count + 1, r->port_count + degree, 0) != 0) {
+        return -1;
+    }
+    int table = r->table_count;
+    r->tables[table].node_id = node_id;
+    route_set_ports(r, csr, table);
+    mesh_route_scratch* s = &r->scratch[0];
+    int status = route_compute(m, r, csr, s, table);
+    if (status == 0 && r->compress) {
+        status = route_reserve(m, r, table + 1, r->port_count, r->run_count + r->tables[table].run_count);
+        if (status == 0) route_move_runs(r, &r->tables[table], s);
+    }
+    route_release_runs(r);
+    if (status != 0) {
+        r->port_count -= r->tables[table].port_count;
+        return -1;
+    }
+    r->table_of[node_id] = table;
+    r->table_count++;
+    return table;
+}
+
+int mesh_route_next_link(mesh* m, int node_id, int destination_id, path_metric metric) {
+    MESH_COUNT(MESH_COUNT_ROUTE_LOOKUPS, 1);
+    mesh_routes* r = mesh_get_routes(m, metric);
+    if (!r) {
+        return -1;
+    }
+    int table = r->table_of[node_id];
+    if (table < 0 && (table = route_add_table(m, r, node_id)) < 0) {
+        return -1;
+    }
+    int port = mesh_route_port(r, table, destination_id);
+    return port == MESH_ROUTE_NONE ? -1 : r->port_link[r->tables[table].port_offset + port];
+}
@@ -0,0 +1,110 @@
+#pragma once
+
+#include <stdbool.h>
+#include "mesh_sssp.h"
+
+typedef struct mesh mesh; // Forward declaration
+
+typedef struct mesh_route_table mesh_route_table;
+
+typedef struct mesh_route_scratch mesh_route_scratch;
+
+typedef struct mesh_routes mesh_routes;
+
+#define MESH_ROUTE_NONE 255 // Port of the destinations a node cannot reach
+#define MESH_ROUTE_MAX_PORTS 255 // Outgoing links past this one are not used for routing
+
+
+/// @brief Next hops of one node. Its outgoing links are numbered as ports, and each
+/// destination maps to the port of the first link of a shortest path towards it.
+struct mesh_route_table{
+    int node_id;                /// Node forwarding with this table
+    int port_offset;            /// First entry of the ports of the node in mesh_routes.port_link
+    int port_count;             /// Number of ports of the node
+    int run_offset;             /// First run of the table in mesh_routes.run_start, when compressed
+    int run_count;              /// Number of runs of the table, when compressed
+};
+
+/// @brief Dijkstra buffers of one worker building tables.
+struct mesh_route_scratch{
+    float* dist;                /// Distance from the node whose table is built
+    unsigned char* port;        /// Port of the first link towards each node
+    int* heap;                  /// Binary min-heap of node ids keyed by dist
+    int* heap_pos;              /// Position of each node in the heap, -1 outside
+    int* run_start;             /// Runs built by the worker before they are merged, malloc'ed
+    unsigned char* run_port;    /// Port of each run built by the worker, malloc'ed
+    int run_count;              /// Number of runs built by the worker
+    int run_capacity;           /// Number of runs the worker buffers can hold
+};
+
+/// @brief Next-hop tables of the routers. Paths only cross ROUTER nodes, END_DEVICE nodes
+/// are sources and destinations and get a table when they first send. A table stores one
+/// byte per destination, or runs of consecutive destinations sharing a port when compressed.
+/// Tables are rebuilt on the next lookup once mesh->version changed.
+struct mesh_routes{
+    bool built;                 /// False until the first build
+    unsigned long version;      /// mesh->version the tables were built for
+    path_metric metric;         /// Weight of the links
+    bool compress;              /// True when tables are stored as runs
+    int node_count;             /// Number of nodes the buffers were sized for
+    int* table_of;              /// Index in tables of the table of each node, -1 if it has none
+    mesh_route_table* tables;   /// Tables of the routers, then of the end devices that sent
+    int table_count;            /// Number of tables
+    int table_capacity;         /// Number of tables the buffers can hold
+    int* port_link;             /// Index in mesh->links of each port, tables back to back
+    int port_count;             /// Number of entries used in port_link
+    int port_capacity;          /// Number of entries port_link can hold
+    unsigned char* next;        /// Port towards each destination, node_count entries per table, when not compressed
+    int next_capacity;          /// Number of tables next can hold
+    int* run_start;             /// First destination of each run, when compressed
+    unsigned char* run_port;    /// Port of each run, when compressed
+    int run_count;              /// Number of runs
+    int run_capacity;           /// Number of runs the buffers can hold
+    mesh_route_scratch* scratch; /// Buffers of each worker
+    int scratch_count;          /// Number of workers with buffers
+};
+
+
+///@brief Builds the tables of every router, and of the end devices that already had one, on worker threads.
+///@param m A pointer to the mesh structure.
+///@param metric The link weight, latency or one per hop.
+///@param compress True to store runs of destinations, lookups then search the runs.
+///@param threads The number of workers, 0 to use every online core.
+///@return int 0 on success, -1 on allocation failure.
+int mesh_build_routes(mesh* m, path_metric metric, bool compress, int threads);
+
+///@brief Returns the tables of the mesh, rebuilding them if the mesh changed or the metric differs.
+/// The first build uses the route_compress setting of the mesh, later ones keep the choice of the last build.
+///@param m A pointer to the mesh structure.
+///@param metric The link weight, latency or one per hop.
+///@return mesh_routes* The up to date tables, or NULL on allocation failure.
+mesh_routes* mesh_get_routes(mesh* m, path_metric metric);
+
+///@brief Returns the link a node forwards a packet on, building the table of an end device on first use.
+///@param m A pointer to the mesh structure.
+///@param node_id The ID of the node holding the packet.
+///@param destination_id The ID of the destination of the packet.
+///@param metric The link weight, latency or one per hop.
+///@return int The index in mesh->links of the next link, -1 if the destination is unreachable or on allocation failure.
+int mesh_route_next_link(mesh* m, int node_id, int destination_id, path_metric metric);
+
+///@brief Looks up the port of a destination in a table.
+///@param r The tables returned by mesh_get_routes().
+///@param table The index of the table.
+///@param destination_id The ID of the destination.
+///@return int The port, MESH_ROUTE_NONE if the destination is unreachable.
+static inline int mesh_route_port(const mesh_routes* r, int table, int destination_id) {
+    if (!r->compress) {
+        return r->next[(size_t)table * r->node_count + destination_id];
+    }
+    // Last run starting at or before the destination
+    const mesh_route_table* t = &r->tables[table];
+    const int* start = r->run_start + t->run_offset;
+    int low = 0, high = t->run_count - 1;
+    while (low < high) {
+        int mid = (low + high + 1) / 2;
+        if (start[mid] <= destination_id) low = mid;
+        else high = mid - 1;
+    }
+    return r->run_port[t->run_offset + low];
+}
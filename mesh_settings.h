@@ -2,14 +2,54 @@
 
 #if 1
 
+#ifndef MESH_METRICS
+#define MESH_METRICS 0 // 1 compiles in the counters and timers of mesh_metrics.h, or build with `make METRICS=1`
+#endif
+
 #define MESH_NAME = "Default Mesh Network"
 #define MESH_NODES_COUNT 40
 #define MESH_ROUTERS_COUNT 50 // the First N nodes will be routers
-#define MESH_MAX_LINKS_PER_NODE 8
+#define MESH_MAX_LINKS_PER_NODE 8 // input links a node accepts
+#define MESH_MAX_OUTPUT_LINKS 2
 #define MESH_DEFAULT_BANDWIDTH 10000.0f // in Mbps
 #define MESH_DEFAULT_LATENCY 00.0f    // in ms per meter
 #define MESH_SIZE_X 30.0f  // in meters
 #define MESH_SIZE_Y 30.0f  // in meters
 #define MESH_MAX_LINK_DISTANCE 50.0f // in meters
+#define MESH_SEED 1 // seed of the node placement
+#define MESH_DISTRIBUTION MESH_UNIFORM // MESH_UNIFORM, MESH_CLUSTERED or MESH_POISSON_DISK
+#define MESH_CLUSTER_NODES 50 // average number of nodes per cluster
+#define MESH_CLUSTER_SPREAD 10.0f // in meters, standard deviation around the cluster center
+#define MESH_TOPOLOGY MESH_TOPOLOGY_CHAIN // MESH_TOPOLOGY_CHAIN, _UNIT_DISK, _GABRIEL, _RNG or _KNN, links built by the program
+#define MESH_TOPOLOGY_NEIGHBORS 0 // links each node opens with MESH_TOPOLOGY_KNN, 0 for MESH_MAX_OUTPUT_LINKS
+#define MESH_THREADS 0 // worker threads of the parallel algorithms, 0 uses every online core
+#define MESH_MAX_THREADS 64
+#define MESH_ARENA_BLOCK_SIZE (1 << 20) // in bytes, first block of each mesh arena
+#define MESH_ROUTE_COMPRESS false // store next hops as runs of destinations instead of one byte per destination
+#define MESH_BETWEENNESS_EPSILON 0.05 // error bound of the sampled betweenness on scores normalized by the number of pairs
+#define MESH_BETWEENNESS_DELTA 0.1 // probability that a sampled betweenness score misses the bound
+#define MESH_LAZY_PATHS false // keep only the shortest path tree of each source and walk the path nodes when read
+#define MESH_METRICS_REPORT "mesh_metrics.json" // written at exit when metrics are compiled in, .json or CSV, "" to disable
+#define MESH_BATCH_OUTPUT "mesh_batch.csv" // statistics written by `mesh --batch`, one line per sweep point
+#define MESH_DEBUG_PRINT_LIMIT 200 // meshes with more nodes are printed as a summary
+#define MESH_SIM_PACKET_SIZE 1500 // in bytes
+#define MESH_SIM_QUEUE_LIMIT 64 // packets waiting per link before drops
+#define MESH_SIM_FLOW_PACKETS 100 // packets sent by each node to the gateway
+#define MESH_SIM_FLOW_INTERVAL 1.0 // in ms between two packets of a flow
+#define MESH_TILE_COUNT 4 // worker processes of `mesh --tiled`, each owns a strip of the area
+#define MESH_TILE_NODES_COUNT 4000 // nodes of `mesh --tiled` unless --node_count is given
+#define MESH_TILE_SIZE_X 400.0f // in meters, area of `mesh --tiled`, each strip must be as wide as the link distance
+#define MESH_TILE_SIZE_Y 400.0f // in meters
+#define MESH_TILE_TICK 1.0 // in ms of simulated time between two synchronizations of the tiles
+#define MESH_TILE_REBALANCE 100 // ticks between two checks of the tile loads, 0 keeps the first boundaries
+#define MESH_TILE_IMBALANCE 0.1 // boundaries move when the busiest tile exceeds the mean load by this fraction
+#define MESH_TILE_RING_RECORDS 65536 // messages each shared-memory ring between two neighbor tiles holds
+#define MESH_TILE_OUTPUT "mesh_tiles.csv" // statistics written by `mesh --tiled`, one line per tile
+#define MESH_FRAME_WIDTH 800 // in pixels, frames of the offscreen renderer
+#define MESH_FRAME_HEIGHT 800 // in pixels
+#define MESH_FRAME_TICK 1.0 // in ms of simulated time between two frames
+#define MESH_FRAME_SCALE 24.0f // pixels per meter before fitting, as SIZE_MULTIPLIER in mesh_draw.h
+#define MESH_FRAME_NODE_SIZE 10 // side of a node square in pixels, as SDL_NODE_SIZE
+#define MESH_FRAME_TILE 64 // side in pixels of the tiles frames are drawn by
 
 #endif
\ No newline at end of file
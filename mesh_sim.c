@@ -0,0 +1,259 @@
+#include "mesh_compute.h"
+#include "mesh_sim.h"
+
+static int sim_alloc_packet(mesh_sim* sim) {
+    if (sim->free_packet < 0) {
+        int capacity = sim->packet_capacity * 2;
+        mesh_sim_packet* packets = (mesh_sim_packet*)realloc(sim->packets, sizeof(mesh_sim_packet) * capacity);
+        if (!packets) {
+            return -1;
+        }
+        for (int i = sim->packet_capacity; i < capacity; i++) {
+            packets[i].next = i + 1 < capacity ? i + 1 : -1;
+        }
+        sim->packets = packets;
+        sim->free_packet = sim->packet_capacity;
+        sim->packet_capacity = capacity;
+    }
+    int p = sim->free_packet;
+    sim->free_packet = sim->packets[p].next;
+    sim->packets[p].next = -1;
+    return p;
+}
+
+static void sim_free_packet(mesh_sim* sim, int p) {
+    sim->packets[p].next = sim->free_packet;
+    sim->free_packet = p;
+}
+
+// Serialization delay from the link bandwidth, propagation is added when the packet leaves
+static int sim_transmit(mesh_sim* sim, int link, int p) {
+    mesh_sim_link* l = &sim->links[link];
+    float bandwidth = sim->m->links[link].bandwidth;
+    int size = sim->flows[sim->packets[p].flow].packet_size;
+    double serialization = bandwidth > 0.0f ? size * 8.0 / (bandwidth * 1000.0) : 0.0; // Mbps to bits per ms
+    l->sending = p;
+    l->busy_time += serialization;
+    l->packets++;
+    l->bytes += size;
+    return mesh_calendar_push(&sim->queue, sim->now + serialization, SIM_LINK_DONE, link);
+}
+
+static void sim_drop(mesh_sim* sim, int p) {
+    sim->flows[sim->packets[p].flow].dropped++;
+    sim_free_packet(sim, p);
+}
+
+// Hands a packet at a node to the next link towards its destination, queueing or dropping it if the link is busy
+static int sim_forward(mesh_sim* sim, int p, int node_id) {
+    mesh_sim_packet* packet = &sim->packets[p];
+    mesh_sim_flow* flow = &sim->flows[packet->flow];
+    int link = mesh_route_next_link(sim->m, node_id, flow->destination_id, METRIC_LATENCY);
+    // Tables of different nodes may pick different equal routes, crossing more links than there are nodes means a loop
+    if (link < 0 || packet->hops >= sim->m->node_count) {
+        sim_drop(sim, p);
+        return 0;
+    }
+    packet->link = link;
+    mesh_sim_link* l = &sim->links[link];
+    if (l->sending < 0) {
+        return sim_transmit(sim, link, p);
+    }
+    if (l->queue_length >= sim->queue_limit) {
+        l->drops++;
+        sim_drop(sim, p);
+        return 0;
+    }
+    packet->enqueued = sim->now;
+    packet->next = -1;
+    if (l->queue_head < 0) l->queue_head = p;
+    else sim->packets[l->queue_tail].next = p;
+    l->queue_tail = p;
+    l->queue_length++;
+    return 0;
+}
+
+static int sim_flow_inject(mesh_sim* sim, int f) {
+    int p = sim_alloc_packet(sim);
+    if (p < 0) {
+        return -1;
+    }
+    mesh_sim_flow* flow = &sim->flows[f];
+    mesh_sim_packet* packet = &sim->packets[p];
+    packet->flow = f;
+    packet->hops = 0;
+    packet->created = sim->now;
+    flow->sent++;
+    if (--flow->packets_left > 0 && mesh_calendar_push(&sim->queue, sim->now + flow->interval, SIM_FLOW_INJECT, f) != 0) {
+        return -1;
+    }
+    return sim_forward(sim, p, flow->source_id);
+}
+
+static int sim_link_done(mesh_sim* sim, int link) {
+    mesh_sim_link* l = &sim->links[link];
+    int p = l->sending;
+    l->sending = -1;
+    if (mesh_calendar_push(&sim->queue, sim->now + sim->m->links[link].latency, SIM_PACKET_ARRIVE, p) != 0) {
+        return -1;
+    }
+    if (l->queue_head < 0) {
+        return 0;
+    }
+    int next = l->queue_head;
+    l->queue_head = sim->packets[next].next;
+    l->queue_length--;
+    l->queue_delay += sim->now - sim->packets[next].enqueued;
+    return sim_transmit(sim, link, next);
+}
+
+static int sim_packet_arrive(mesh_sim* sim, int p) {
+    mesh_sim_packet* packet = &sim->packets[p];
+    mesh_sim_flow* flow = &sim->flows[packet->flow];
+    int node_id = sim->m->links[packet->link].destination_id;
+    packet->hops++;
+    if (node_id != flow->destination_id) {
+        return sim_forward(sim, p, node_id);
+    }
+    flow->delivered++;
+    flow->latency += sim->now - packet->created;
+    sim_free_packet(sim, p);
+    return 0;
+}
+
+int mesh_sim_init(mesh_sim* sim, mesh* m) {
+    memset(sim, 0, sizeof(*sim));
+    sim->m = m;
+    sim->queue_limit = m->config.sim_queue_limit;
+    sim->packet_capacity = 1024;
+    sim->links = (mesh_sim_link*)calloc(m->link_count > 0 ? m->link_count : 1, sizeof(mesh_sim_link));
+    sim->packets = (mesh_sim_packet*)malloc(sizeof(mesh_sim_packet) * sim->packet_capacity);
+    if (!sim->links || !sim->packets || mesh_calendar_init(&sim->queue, 1.0) != 0) {
+        mesh_sim_free(sim);
+        return -1;
+    }
+    for (int i = 0; i < m->link_count; i++) {
+        sim->links[i].queue_head = -1;
+        sim->links[i].queue_tail = -1;
+        sim->links[i].sending = -1;
+    }
+    for (int i = 0; i < sim->packet_capacity; i++) {
+        sim->packets[i].next = i + 1 < sim->packet_capacity ? i + 1 : -1;
+    }
+    sim->free_packet = 0;
+    return 0;
+}
+
+void mesh_sim_free(mesh_sim* sim) {
+    mesh_calendar_free(&sim->queue);
+    free(sim->links);
+    free(sim->flows);
+    free(sim->packets);
+    memset(sim, 0, sizeof(*sim));
+}
+
+int mesh_sim_add_flow(mesh_sim* sim, int source_id, int destination_id, double start, int packets, double interval, int packet_size) {
+    mesh* m = sim->m;
+    if (source_id == destination_id || packets <= 0) {
+        return -1;
+    }
+    if (mesh_route_next_link(m, source_id, destination_id, METRIC_LATENCY) < 0) {
+        return -1;
+    }
+
+    if (sim->flow_count == sim->flow_capacity) {
+        int capacity = sim->flow_capacity ? sim->flow_capacity * 2 : 64;
+        mesh_sim_flow* flows = (mesh_sim_flow*)realloc(sim->flows, sizeof(mesh_sim_flow) * capacity);
+        if (!flows) {
+            return -1;
+        }
+        sim->flows = flows;
+        sim->flow_capacity = capacity;
+    }
+
+    int f = sim->flow_count;
+    mesh_sim_flow* flow = &sim->flows[f];
+    memset(flow, 0, sizeof(*flow));
+    flow->source_id = source_id;
+    flow->destination_id = destination_id;
+    flow->packet_size = packet_size;
+    flow->interval = interval;
+    flow->packets_left = packets;
+    if (mesh_calendar_push(&sim->queue, start, SIM_FLOW_INJECT, f) != 0) {
+        return -1;
+    }
+    sim->flow_count++;
+    return f;
+}
+
+long mesh_sim_run(mesh_sim* sim, double until) {
+    MESH_TIMED(MESH_TIME_SIM_RUN);
+    long processed = 0;
+    double next;
+    while (mesh_calendar_peek(&sim->queue, &next) && next <= until) {
+        mesh_event e;
+        mesh_calendar_pop(&sim->queue, &e);
+        sim->now = e.time;
+        int status = 0;
+        switch (e.type) {
+            case SIM_FLOW_INJECT: status = sim_flow_inject(sim, e.data); break;
+            case SIM_LINK_DONE: status = sim_link_done(sim, e.data); break;
+            case SIM_PACKET_ARRIVE: status = sim_packet_arrive(sim, e.data); break;
+        }
+        if (status != 0) {
+            return -1;
+        }
+        processed++;
+    }
+    sim->events += processed;
+    MESH_COUNT(MESH_COUNT_SIM_EVENTS, processed);
+    return processed;
+}
+
+int mesh_sim_write_stats(mesh_sim* sim, const char* filename) {
+    FILE* file = fopen(filename, "w");
+    if (!file) {
+        return -1;
+    }
+    mesh* m = sim->m;
+    fprintf(file, "LinkID,SourceID,DestinationID,Utilization,AvgQueueDelay,Packets,Bytes,Drops\n");
+    for (int i = 0; i < m->link_count; i++) {
+        mesh_sim_link* l = &sim->links[i];
+        double utilization = sim->now > 0.0 ? l->busy_time / sim->now : 0.0;
+        double delay = l->packets > 0 ? l->queue_delay / l->packets : 0.0;
+        fprintf(file, "%d,%d,%d,%.4f,%.4f,%ld,%ld,%ld\n", m->links[i].id, m->links[i].source_id, m->links[i].destination_id,
+                utilization, delay, l->packets, l->bytes, l->drops);
+    }
+    fprintf(file, "FlowID,SourceID,DestinationID,Sent,Delivered,Dropped,AvgLatency\n");
+    for (int i = 0; i < sim->flow_count; i++) {
+        mesh_sim_flow* f = &sim->flows[i];
+        fprintf(file, "%d,%d,%d,%ld,%ld,%ld,%.4f\n", i, f->source_id, f->destination_id, f->sent, f->delivered, f->dropped,
+                f->delivered > 0 ? f->latency / f->delivered : 0.0);
+    }
+    fclose(file);
+    return 0;
+}
+
+int mesh_sim_add_gateway_flows(mesh_sim* sim) {
+    // Sink traffic: every node streams to the last node, the end of the default link chain
+    mesh* m = sim->m;
+    int sink = m->node_count - 1;
+    int added = 0;
+    for (int i = 0; i < sink; i++) {
+        if (mesh_sim_add_flow(sim, i, sink, 0.0, m->config.sim_flow_packets, m->config.sim_flow_interval, m->config.sim_packet_size) >= 0) {
+            added++;
+        }
+    }
+    return added;
+}
+
+int compute_mesh(mesh* m) {
+    mesh_sim sim;
+    if (mesh_sim_init(&sim, m) != 0) {
+        return -1;
+    }
+    mesh_sim_add_gateway_flows(&sim);
+    int status = mesh_sim_run(&sim, INFINITY) < 0 ? -1 : mesh_sim_write_stats(&sim, "mesh_sim.csv");
+    mesh_sim_free(&sim);
+    return status;
+}
@@ -0,0 +1,110 @@
+#pragma once
+
+#include "mesh_calendar.h"
+
+typedef struct mesh mesh; // Forward declaration
+
+typedef struct mesh_sim_packet mesh_sim_packet;
+typedef struct mesh_sim_link mesh_sim_link;
+typedef struct mesh_sim_flow mesh_sim_flow;
+typedef struct mesh_sim mesh_sim;
+
+typedef enum sim_event {
+    SIM_FLOW_INJECT,            /// A flow emits its next packet, data is the flow
+    SIM_LINK_DONE,              /// A link finished serializing its packet, data is the link
+    SIM_PACKET_ARRIVE           /// A packet reached the end of a link, data is the packet
+}sim_event;
+
+
+/// @brief Packet in flight, stored in a pool and chained by index in link queues.
+struct mesh_sim_packet{
+    int flow;                   /// Flow that emitted the packet
+    int link;                   /// Link the packet is crossing or waiting for
+    int hops;                   /// Number of links crossed
+    double created;             /// Time the packet was emitted, in ms
+    double enqueued;            /// Time the packet entered its current link queue, in ms
+    int next;                   /// Next packet in the link queue or in the free list, -1 at the end
+};
+
+/// @brief Transmission state and counters of a link.
+struct mesh_sim_link{
+    int queue_head;             /// First waiting packet, -1 if the queue is empty
+    int queue_tail;             /// Last waiting packet
+    int queue_length;           /// Number of waiting packets
+    int sending;                /// Packet being serialized, -1 when the link is idle
+    double busy_time;           /// Time spent serializing packets, in ms
+    double queue_delay;         /// Sum of the time packets waited in the queue, in ms
+    long packets;               /// Number of packets sent
+    long bytes;                 /// Number of bytes sent
+    long drops;                 /// Number of packets dropped because the queue was full
+};
+
+/// @brief Constant rate flow between two nodes. Packets are forwarded hop by hop along
+/// the lowest latency routes of the next-hop tables (see mesh_route.h).
+struct mesh_sim_flow{
+    int source_id;              /// ID of the emitting node
+    int destination_id;         /// ID of the receiving node
+    int packet_size;            /// Size of each packet in bytes
+    double interval;            /// Time between two packets, in ms
+    int packets_left;           /// Packets still to emit
+    long sent;                  /// Packets emitted
+    long delivered;             /// Packets that reached the destination
+    long dropped;               /// Packets dropped on the way, by full queues or lost routes
+    double latency;             /// Sum of the end to end delays of delivered packets, in ms
+};
+
+/// @brief Discrete-event traffic simulation over the links of a mesh.
+struct mesh_sim{
+    mesh* m;                    /// Simulated mesh
+    mesh_calendar queue;        /// Pending events
+    mesh_sim_link* links;       /// State of each mesh link, indexed like mesh->links
+    mesh_sim_flow* flows;       /// Injected flows
+    int flow_count;             /// Number of flows
+    int flow_capacity;          /// Number of flows the flows array can hold
+    mesh_sim_packet* packets;   /// Packet pool
+    int packet_capacity;        /// Number of packets the pool can hold
+    int free_packet;            /// First unused packet, -1 if the pool is full
+    int queue_limit;            /// Packets a link can hold waiting before dropping
+    double now;                 /// Current simulation time, in ms
+    long events;                /// Number of events processed
+};
+
+
+///@brief Prepares a simulation over the current links of a mesh.
+///@param sim A pointer to the simulation to initialize.
+///@param m A pointer to the mesh structure, its links must not change while the simulation lives.
+///@return int 0 on success, -1 on allocation failure.
+int mesh_sim_init(mesh_sim* sim, mesh* m);
+
+///@brief Frees the buffers of a simulation.
+///@param sim A pointer to the simulation.
+void mesh_sim_free(mesh_sim* sim);
+
+///@brief Adds a constant rate flow between two nodes.
+///@param sim A pointer to the simulation.
+///@param source_id The ID of the emitting node.
+///@param destination_id The ID of the receiving node.
+///@param start The time of the first packet, in ms.
+///@param packets The number of packets to emit.
+///@param interval The time between two packets, in ms.
+///@param packet_size The size of each packet in bytes.
+///@return int The index of the flow, or -1 if the source has no route to the destination or on allocation failure.
+int mesh_sim_add_flow(mesh_sim* sim, int source_id, int destination_id, double start, int packets, double interval, int packet_size);
+
+///@brief Adds the gateway traffic of compute_mesh(): every node streams to the last node with the
+/// packet count, interval and size of the mesh configuration.
+///@param sim A pointer to the simulation.
+///@return int The number of flows added, nodes without a route to the gateway are skipped.
+int mesh_sim_add_gateway_flows(mesh_sim* sim);
+
+///@brief Processes events in time order until the queue is empty or the time limit is reached.
+///@param sim A pointer to the simulation.
+///@param until The time at which to stop, in ms.
+///@return long The number of events processed by this call, -1 on allocation failure.
+long mesh_sim_run(mesh_sim* sim, double until);
+
+///@brief Writes per-link and per-flow counters to a CSV file.
+///@param sim A pointer to the simulation.
+///@param filename The path of the CSV file.
+///@return int 0 on success, -1 on failure.
+int mesh_sim_write_stats(mesh_sim* sim, const char* filename);
@@ -0,0 +1,375 @@
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "mesh_compute.h"
+#include "mesh_snapshot.h"
+
+#define SNAPSHOT_LITTLE_ENDIAN (__BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__)
+
+_Static_assert(sizeof(mesh_snapshot_header) % 8 == 0, "snapshot header must keep sections aligned");
+_Static_assert(sizeof(mesh_snapshot_node) == 28, "snapshot node record layout changed");
+_Static_assert(sizeof(mesh_snapshot_link) == 24, "snapshot link record layout changed");
+_Static_assert(sizeof(mesh_snapshot_path) == 24, "snapshot path record layout changed");
+
+static uint64_t snapshot_align(uint64_t offset) {
+    return (offset + 7) & ~(uint64_t)7;
+}
+
+// Fills the counts and section offsets of a header
+static void snapshot_layout(mesh_snapshot_header* h, const char* name, uint32_t nodes, uint32_t links, uint32_t paths, uint32_t path_nodes) {
+    memset(h, 0, sizeof(*h));
+    memcpy(h->magic, MESH_SNAPSHOT_MAGIC, sizeof(h->magic));
+    h->version = MESH_SNAPSHOT_VERSION;
+    h->header_size = sizeof(*h);
+    strncpy(h->name, name, sizeof(h->name) - 1);
+    h->node_count = nodes;
+    h->link_count = links;
+    h->path_count = paths;
+    h->path_node_count = path_nodes;
+    h->nodes_offset = snapshot_align(sizeof(*h));
+    h->links_offset = snapshot_align(h->nodes_offset + (uint64_t)nodes * sizeof(mesh_snapshot_node));
+    h->paths_offset = snapshot_align(h->links_offset + (uint64_t)links * sizeof(mesh_snapshot_link));
+    h->path_nodes_offset = snapshot_align(h->paths_offset + (uint64_t)paths * sizeof(mesh_snapshot_path));
+    h->file_size = h->path_nodes_offset + (uint64_t)path_nodes * sizeof(int32_t);
+}
+
+// Sections are written in order, padding with zeros up to the next one
+static void snapshot_pad(FILE* file, uint64_t offset) {
+    static const char zeros[8] = {0};
+    long position = ftell(file);
+    if (position >= 0 && (uint64_t)position < offset) {
+        fwrite(zeros, 1, offset - (uint64_t)position, file);
+    }
+}
+
+static FILE* snapshot_create(const char* filename, const mesh_snapshot_header* h) {
+    if (!SNAPSHOT_LITTLE_ENDIAN) {
+        return NULL; // Records are written as laid out in memory
+    }
+    FILE* file = fopen(filename, "wb");
+    if (!file) {
+        return NULL;
+    }
+    setvbuf(file, NULL, _IOFBF, 1 << 20);
+    fwrite(h, sizeof(*h), 1, file);
+    return file;
+}
+
+static int snapshot_finish(FILE* file, const mesh_snapshot_header* h) {
+    snapshot_pad(file, h->file_size);
+    int failed = ferror(file);
+    if (fclose(file) != 0 || failed) {
+        return -1;
+    }
+    return 0;
+}
+
+int mesh_snapshot_save(mesh* m, const char* filename) {
+    MESH_TIMED(MESH_TIME_SNAPSHOT);
+    uint32_t path_nodes = 0;
+    mesh_path_cursor cursor = {0};
+    for (mesh_path* path = mesh_path_next(m, &cursor); path; path = mesh_path_next(m, &cursor)) {
+        // Every route is stored in full, a path is only loaded back with all of its nodes
+        if ((path->lazy || path->length > 0) && !mesh_path_nodes(m, path)) {
+            return -1;
+        }
+        path_nodes += path->length;
+    }
+    mesh_snapshot_header h;
+    snapshot_layout(&h, m->name, m->node_count, m->link_count, mesh_total_paths(m), path_nodes);
+    FILE* file = snapshot_create(filename, &h);
+    if (!file) {
+        return -1;
+    }
+
+    snapshot_pad(file, h.nodes_offset);
+    for (int i = 0; i < m->node_count; i++) {
+        mesh_node* node = &m->nodes[i];
+        mesh_snapshot_node r = { node->id, node->input_link_count, node->output_link_count, node->x, node->y, node->node_status, node->node_type };
+        fwrite(&r, sizeof(r), 1, file);
+    }
+    snapshot_pad(file, h.links_offset);
+    for (int i = 0; i < m->link_count; i++) {
+        mesh_link* link = &m->links[i];
+        mesh_snapshot_link r = { link->id, link->source_id, link->destination_id, link->bandwidth, link->latency, link->length };
+        fwrite(&r, sizeof(r), 1, file);
+    }
+    snapshot_pad(file, h.paths_offset);
+    uint32_t first = 0;
+    cursor = (mesh_path_cursor){0};
+    for (mesh_path* path = mesh_path_next(m, &cursor); path; path = mesh_path_next(m, &cursor)) {
+        if (path->lazy) mesh_path_nodes(m, path);
+        mesh_snapshot_path r = { path->id, path->start_node_id, path->end_node_id, path->length, first, (uint32_t)path->length };
+        fwrite(&r, sizeof(r), 1, file);
+        first += (uint32_t)path->length;
+    }
+    snapshot_pad(file, h.path_nodes_offset);
+    cursor = (mesh_path_cursor){0};
+    for (mesh_path* path = mesh_path_next(m, &cursor); path; path = mesh_path_next(m, &cursor)) {
+        const uint32_t* nodes = mesh_path_nodes(m, path);
+        if (nodes && path->length > 0) fwrite(nodes, sizeof(uint32_t), path->length, file);
+    }
+    return snapshot_finish(file, &h);
+}
+
+int mesh_snapshot_open(const char* filename, mesh_snapshot* snap) {
+    memset(snap, 0, sizeof(*snap));
+    if (!SNAPSHOT_LITTLE_ENDIAN) {
+        return -1;
+    }
+    int fd = open(filename, O_RDONLY);
+    if (fd < 0) {
+        return -1;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || (size_t)st.st_size < sizeof(mesh_snapshot_header)) {
+        close(fd);
+        return -1;
+    }
+    void* map = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd); // The mapping keeps the file alive
+    if (map == MAP_FAILED) {
+        return -1;
+    }
+    snap->map = map;
+    snap->size = (size_t)st.st_size;
+
+    const mesh_snapshot_header* h = (const mesh_snapshot_header*)map;
+    mesh_snapshot_header expected;
+    snapshot_layout(&expected, "", h->node_count, h->link_count, h->path_count, h->path_node_count);
+    if (memcmp(h->magic, MESH_SNAPSHOT_MAGIC, sizeof(h->magic)) != 0
+        || h->version != MESH_SNAPSHOT_VERSION
+        || h->header_size != sizeof(*h)
+        || h->nodes_offset != expected.nodes_offset
+        || h->links_offset != expected.links_offset
+        || h->paths_offset != expected.paths_offset
+        || h->path_nodes_offset != expected.path_nodes_offset
+        || h->file_size != expected.file_size
+        || h->file_size > snap->size) {
+        mesh_snapshot_close(snap);
+        return -1;
+    }
+
+    const char* base = (const char*)map;
+    snap->header = h;
+    snap->nodes = (const mesh_snapshot_node*)(base + h->nodes_offset);
+    snap->links = (const mesh_snapshot_link*)(base + h->links_offset);
+    snap->paths = (const mesh_snapshot_path*)(base + h->paths_offset);
+    snap->path_nodes = (const int32_t*)(base + h->path_nodes_offset);
+    return 0;
+}
+
+void mesh_snapshot_close(mesh_snapshot* snap) {
+    if (snap->map) {
+        munmap(snap->map, snap->size);
+    }
+    memset(snap, 0, sizeof(*snap));
+}
+
+mesh* mesh_snapshot_load(const mesh_snapshot* snap, const mesh_config* config) {
+    MESH_TIMED(MESH_TIME_SNAPSHOT);
+    const mesh_snapshot_header* h = snap->header;
+    char name[sizeof(h->name) + 1];
+    memcpy(name, h->name, sizeof(h->name));
+    name[sizeof(h->name)] = '\0';
+    mesh_config loaded;
+    if (config) {
+        loaded = *config;
+    } else {
+        mesh_config_defaults(&loaded);
+    }
+    loaded.node_count = (int)h->node_count;
+    // The area is not stored, cover every saved position so the grid stays balanced
+    for (uint32_t i = 0; i < h->node_count; i++) {
+        if (snap->nodes[i].x + 1.0f > loaded.size_x) loaded.size_x = snap->nodes[i].x + 1.0f;
+        if (snap->nodes[i].y + 1.0f > loaded.size_y) loaded.size_y = snap->nodes[i].y + 1.0f;
+    }
+    mesh* m = init_mesh(name, &loaded);
+    if (!m) {
+        return NULL;
+    }
+
+    for (uint32_t i = 0; i < h->node_count; i++) {
+        m->nodes[i].x = snap->nodes[i].x;
+        m->nodes[i].y = snap->nodes[i].y;
+        m->nodes[i].node_type = (type)snap->nodes[i].node_type;
+    }
+    mesh_soa_build(m);
+    mesh_grid_build(m);
+    for (uint32_t i = 0; i < h->link_count; i++) {
+        const mesh_snapshot_link* r = &snap->links[i];
+        if (r->source < 0 || r->destination < 0 || (uint32_t)r->source >= h->node_count || (uint32_t)r->destination >= h->node_count
+            || init_mesh_link(m, r->id, &m->nodes[r->source], &m->nodes[r->destination]) < 0) {
+            free_mesh(m);
+            return NULL;
+        }
+        mesh_link* link = &m->links[m->link_count - 1];
+        link->bandwidth = r->bandwidth;
+        link->latency = r->latency;
+        link->length = r->length;
+    }
+    // Linking marks nodes connected, keep the status that was saved
+    for (uint32_t i = 0; i < h->node_count; i++) {
+        m->nodes[i].node_status = (status)snap->nodes[i].node_status;
+        m->soa.node_status[i] = (unsigned char)snap->nodes[i].node_status;
+    }
+    for (uint32_t i = 0; i < h->path_count; i++) {
+        const mesh_snapshot_path* r = &snap->paths[i];
+        const int32_t* nodes = snap->path_nodes + r->first_node;
+        bool valid = r->start_node_id >= 0 && (uint32_t)r->start_node_id < h->node_count
+            && r->end_node_id >= 0 && (uint32_t)r->end_node_id < h->node_count
+            && r->length >= 0 && (uint32_t)r->length == r->node_count
+            && (uint64_t)r->first_node + r->node_count <= h->path_node_count;
+        for (uint32_t j = 0; valid && j < r->node_count; j++) {
+            valid = nodes[j] >= 0 && (uint32_t)nodes[j] < h->node_count;
+        }
+        mesh_path* path = valid ? mesh_append_path(m, r->start_node_id, r->end_node_id, r->node_count) : NULL;
+        if (!path) {
+            free_mesh(m);
+            return NULL;
+        }
+        path->id = r->id;
+        path->length = r->length;
+        if (r->node_count > 0) memcpy(m->path_nodes + path->first, nodes, sizeof(uint32_t) * r->node_count);
+    }
+    return m;
+}
+
+// Growable array of records parsed from a CSV section
+typedef struct csv_records {
+    void* data;
+    int count;
+    int capacity;
+} csv_records;
+
+static void* csv_push(csv_records* r, size_t record_size) {
+    if (r->count == r->capacity) {
+        int capacity = r->capacity ? r->capacity * 2 : 256;
+        void* data = realloc(r->data, record_size * capacity);
+        if (!data) {
+            return NULL;
+        }
+        r->data = data;
+        r->capacity = capacity;
+    }
+    return (char*)r->data + record_size * r->count++;
+}
+
+int mesh_csv_to_snapshot(const char* csv_filename, const char* snapshot_filename) {
+    FILE* csv = fopen(csv_filename, "r");
+    if (!csv) {
+        return -1;
+    }
+    enum { SECTION_NONE, SECTION_NODES, SECTION_LINKS, SECTION_PATHS } section = SECTION_NONE;
+    csv_records nodes = {0}, links = {0}, paths = {0}, path_nodes = {0};
+    int node_count = 0;
+    int failed = 0;
+    char* line = NULL; // Path rows hold every node of the path
+    size_t line_size = 0;
+
+    while (!failed && getline(&line, &line_size, csv) > 0) {
+        if (strncmp(line, "NodeID,", 7) == 0) { section = SECTION_NODES; continue; }
+        if (strncmp(line, "LinkID,", 7) == 0) { section = SECTION_LINKS; continue; }
+        if (strncmp(line, "PathStartID,", 12) == 0) { section = SECTION_PATHS; continue; }
+        if (line[0] < '0' || line[0] > '9') { section = SECTION_NONE; continue; } // Other sections are skipped
+
+        if (section == SECTION_NODES) {
+            mesh_snapshot_node r = {0};
+            if (sscanf(line, "%d,%f,%f,%d,%d", &r.id, &r.x, &r.y, &r.node_status, &r.node_type) != 5) continue;
+            mesh_snapshot_node* slot = (mesh_snapshot_node*)csv_push(&nodes, sizeof(r));
+            if (!slot) failed = 1;
+            else *slot = r;
+            if (r.id + 1 > node_count) node_count = r.id + 1;
+        } else if (section == SECTION_LINKS) {
+            mesh_snapshot_link r = {0};
+            if (sscanf(line, "%d,%d,%d,%f,%f", &r.id, &r.source, &r.destination, &r.bandwidth, &r.latency) != 5) continue;
+            mesh_snapshot_link* slot = (mesh_snapshot_link*)csv_push(&links, sizeof(r));
+            if (!slot) failed = 1;
+            else *slot = r;
+        } else if (section == SECTION_PATHS) {
+            mesh_snapshot_path r = {0};
+            int offset = 0;
+            if (sscanf(line, "%d,%d,%d%n", &r.start_node_id, &r.end_node_id, &r.length, &offset) != 3) continue;
+            r.id = paths.count;
+            r.first_node = path_nodes.count;
+            if (line[offset] == ',') {
+                char* cursor = line + offset + 1;
+                char* end;
+                for (long id = strtol(cursor, &end, 10); end != cursor && !failed; id = strtol(cursor, &end, 10)) {
+                    int32_t* slot = (int32_t*)csv_push(&path_nodes, sizeof(int32_t));
+                    if (!slot) failed = 1;
+                    else *slot = (int32_t)id;
+                    cursor = end;
+                }
+            }
+            r.node_count = path_nodes.count - r.first_node;
+            // Dumps from before the Nodes column cannot give the route back, such paths are left out
+            if ((uint32_t)r.length != r.node_count) {
+                path_nodes.count = (int)r.first_node;
+                continue;
+            }
+            mesh_snapshot_path* slot = (mesh_snapshot_path*)csv_push(&paths, sizeof(r));
+            if (!slot) failed = 1;
+            else *slot = r;
+        }
+    }
+    free(line);
+    fclose(csv);
+
+    // Nodes are indexed by id, ids missing from the dump stay empty records
+    mesh_snapshot_node* by_id = failed ? NULL : (mesh_snapshot_node*)calloc(node_count > 0 ? node_count : 1, sizeof(mesh_snapshot_node));
+    if (by_id) {
+        for (int i = 0; i < node_count; i++) by_id[i].id = i;
+        for (int i = 0; i < nodes.count; i++) {
+            mesh_snapshot_node* r = &((mesh_snapshot_node*)nodes.data)[i];
+            if (r->id >= 0) by_id[r->id] = *r;
+        }
+        for (int i = 0; i < links.count; i++) {
+            mesh_snapshot_link* r = &((mesh_snapshot_link*)links.data)[i];
+            if (r->source < 0 || r->source >= node_count || r->destination < 0 || r->destination >= node_count) {
+                failed = 1;
+                break;
+            }
+            mesh_snapshot_node* s = &by_id[r->source];
+            mesh_snapshot_node* d = &by_id[r->destination];
+            r->length = sqrtf((s->x - d->x) * (s->x - d->x) + (s->y - d->y) * (s->y - d->y));
+            s->output_link_count++;
+            d->input_link_count++;
+        }
+        for (int i = 0; i < paths.count && !failed; i++) {
+            mesh_snapshot_path* r = &((mesh_snapshot_path*)paths.data)[i];
+            if (r->start_node_id < 0 || r->start_node_id >= node_count || r->end_node_id < 0 || r->end_node_id >= node_count) failed = 1;
+        }
+        for (int i = 0; i < path_nodes.count && !failed; i++) {
+            int32_t id = ((int32_t*)path_nodes.data)[i];
+            if (id < 0 || id >= node_count) failed = 1;
+        }
+    }
+
+    if (by_id && !failed) {
+        mesh_snapshot_header h;
+        snapshot_layout(&h, csv_filename, node_count, links.count, paths.count, path_nodes.count);
+        FILE* file = snapshot_create(snapshot_filename, &h);
+        if (file) {
+            snapshot_pad(file, h.nodes_offset);
+            if (node_count > 0) fwrite(by_id, sizeof(mesh_snapshot_node), node_count, file);
+            snapshot_pad(file, h.links_offset);
+            if (links.count > 0) fwrite(links.data, sizeof(mesh_snapshot_link), links.count, file);
+            snapshot_pad(file, h.paths_offset);
+            if (paths.count > 0) fwrite(paths.data, sizeof(mesh_snapshot_path), paths.count, file);
+            snapshot_pad(file, h.path_nodes_offset);
+            if (path_nodes.count > 0) fwrite(path_nodes.data, sizeof(int32_t), path_nodes.count, file);
+            failed = snapshot_finish(file, &h) != 0;
+        } else {
+            failed = 1;
+        }
+    }
+
+    free(by_id);
+    free(nodes.data);
+    free(links.data);
+    free(paths.data);
+    free(path_nodes.data);
+    return failed || !by_id ? -1 : 0;
+}
@@ -0,0 +1,107 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+typedef struct mesh mesh; // Forward declaration
+
+#define MESH_SNAPSHOT_MAGIC "MESHSNAP"
+#define MESH_SNAPSHOT_VERSION 1
+
+typedef struct mesh_snapshot_header mesh_snapshot_header;
+typedef struct mesh_snapshot_node mesh_snapshot_node;
+typedef struct mesh_snapshot_link mesh_snapshot_link;
+typedef struct mesh_snapshot_path mesh_snapshot_path;
+typedef struct mesh_snapshot mesh_snapshot;
+
+
+/// @brief First bytes of a snapshot file. Every field is little-endian and every
+/// section starts on an 8 byte boundary so it can be used in place once mapped.
+struct mesh_snapshot_header{
+    char magic[8];              /// MESH_SNAPSHOT_MAGIC, not null terminated
+    uint32_t version;           /// MESH_SNAPSHOT_VERSION
+    uint32_t header_size;       /// sizeof(mesh_snapshot_header)
+    char name[128];             /// Name of the mesh network
+    uint32_t node_count;        /// Number of node records
+    uint32_t link_count;        /// Number of link records
+    uint32_t path_count;        /// Number of path records
+    uint32_t path_node_count;   /// Number of entries in the path node section
+    uint64_t nodes_offset;      /// File offset of the node section
+    uint64_t links_offset;      /// File offset of the link section
+    uint64_t paths_offset;      /// File offset of the path section
+    uint64_t path_nodes_offset; /// File offset of the path node section
+    uint64_t file_size;         /// Total size of the file in bytes
+};
+
+/// @brief Node record, indexed by node id.
+struct mesh_snapshot_node{
+    int32_t id;                 /// Unique identifier for the mesh node
+    int32_t input_link_count;   /// Number of input links connected to this node
+    int32_t output_link_count;  /// Number of output links connected to this node
+    float x, y;                 /// Coordinates of the node in 2D space
+    int32_t node_status;        /// status of the node
+    int32_t node_type;          /// type of the node
+};
+
+/// @brief Link record, its ends are node indices.
+struct mesh_snapshot_link{
+    int32_t id;                 /// Unique identifier for the mesh link
+    int32_t source;             /// Index of the source node
+    int32_t destination;        /// Index of the destination node
+    float bandwidth;            /// Bandwidth of the link in Mbps
+    float latency;              /// Latency of the link in ms
+    float length;               /// Length of the link in meters
+};
+
+/// @brief Path record, its nodes are path_nodes[first_node, first_node + node_count).
+struct mesh_snapshot_path{
+    int32_t id;                 /// Unique identifier for the mesh path
+    int32_t start_node_id;      /// ID of the starting node
+    int32_t end_node_id;        /// ID of the ending node
+    int32_t length;             /// Length of the path
+    uint32_t first_node;        /// Index of the first node in the path node section
+    uint32_t node_count;        /// Number of stored nodes, equal to length
+};
+
+/// @brief Read-only view of a mapped snapshot file, the pointers point into the mapping.
+struct mesh_snapshot{
+    void* map;                  /// Start of the mapping
+    size_t size;                /// Size of the mapping in bytes
+    const mesh_snapshot_header* header;
+    const mesh_snapshot_node* nodes;
+    const mesh_snapshot_link* links;
+    const mesh_snapshot_path* paths;
+    const int32_t* path_nodes;
+};
+
+
+///@brief Writes the nodes, links and paths of a mesh to a binary snapshot file.
+///@param m A pointer to the mesh structure.
+///@param filename The path of the snapshot file.
+///@return int 0 on success, -1 on failure.
+int mesh_snapshot_save(mesh* m, const char* filename);
+
+///@brief Maps a snapshot file read-only and checks its header, nothing is parsed or copied.
+/// The mapping can be shared by several processes.
+///@param filename The path of the snapshot file.
+///@param snap The view to fill.
+///@return int 0 on success, -1 if the file cannot be mapped or is not a valid snapshot.
+int mesh_snapshot_open(const char* filename, mesh_snapshot* snap);
+
+///@brief Unmaps a snapshot opened with mesh_snapshot_open().
+///@param snap The view to close.
+void mesh_snapshot_close(mesh_snapshot* snap);
+
+///@brief Builds a mesh from a mapped snapshot.
+///@param snap A view returned by mesh_snapshot_open().
+///@param config The parameters of the mesh, NULL for the defaults. The node count comes from the snapshot and the area grows to cover every saved position.
+///@return mesh* A new mesh to release with free_mesh(), or NULL on failure.
+mesh* mesh_snapshot_load(const mesh_snapshot* snap, const mesh_config* config);
+
+///@brief Converts a CSV dump written by MESH_SAVEDUMP() into a binary snapshot.
+/// Missing sections are left empty, link lengths and node link counts are derived from the links.
+/// Paths dumped without their nodes are left out, a snapshot only holds complete routes.
+///@param csv_filename The path of the CSV dump.
+///@param snapshot_filename The path of the snapshot file to write.
+///@return int 0 on success, -1 on failure.
+int mesh_csv_to_snapshot(const char* csv_filename, const char* snapshot_filename);
@@ -0,0 +1,257 @@
+#include "mesh_compute.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define SOA_X86 1
+#endif
+
+#define SOA_DEFAULT_DISTANCE_SQ (MESH_MAX_LINK_DISTANCE * MESH_MAX_LINK_DISTANCE)
+#define SOA_FORM_BLOCK 256
+
+// Every kernel body takes the link rules as arguments and is inlined twice: once reading them from
+// the mirror, and once with the values of mesh_settings.h so the compiler folds them as constants
+#define SOA_INLINE static inline __attribute__((always_inline))
+
+typedef struct soa_kernel_set {
+    mesh_soa_mask_fn generic;   /// Reads the link rules from the mirror
+    mesh_soa_mask_fn fixed;     /// Link rules of mesh_settings.h
+} soa_kernel_set;
+
+static soa_kernel_set soa_kernels(void);
+
+int mesh_soa_build(mesh* m) {
+    mesh_soa* s = &m->soa;
+    if (!s->x) {
+        int n = m->node_count;
+        s->x = (float*)mesh_arena_alloc(&m->arena, sizeof(float) * n);
+        s->y = (float*)mesh_arena_alloc(&m->arena, sizeof(float) * n);
+        s->output_link_count = (int*)mesh_arena_alloc(&m->arena, sizeof(int) * n);
+        s->input_link_count = (int*)mesh_arena_alloc(&m->arena, sizeof(int) * n);
+        s->node_status = (unsigned char*)mesh_arena_alloc(&m->arena, n);
+        if (!s->x || !s->y || !s->output_link_count || !s->input_link_count || !s->node_status) {
+            s->x = NULL;
+            return -1;
+        }
+        s->node_count = n;
+    }
+    for (int i = 0; i < s->node_count; i++) {
+        mesh_node* node = &m->nodes[i];
+        s->x[i] = node->x;
+        s->y[i] = node->y;
+        s->output_link_count[i] = node->output_link_count;
+        s->input_link_count[i] = node->input_link_count;
+        s->node_status[i] = (unsigned char)node->node_status;
+    }
+    s->max_distance_sq = m->config.max_link_distance * m->config.max_link_distance;
+    s->max_input_links = m->config.max_input_links;
+    s->max_output_links = m->config.max_output_links;
+    soa_kernel_set kernels = soa_kernels();
+    s->mask = s->max_distance_sq == SOA_DEFAULT_DISTANCE_SQ && s->max_input_links == MESH_MAX_LINKS_PER_NODE
+            ? kernels.fixed : kernels.generic;
+    return 0;
+}
+
+SOA_INLINE bool soa_allowed(const mesh_soa* s, int source_id, float sx, float sy, int id, float max_sq, int cap) {
+    float dx = s->x[id] - sx;
+    float dy = s->y[id] - sy;
+    return id != source_id && dx * dx + dy * dy <= max_sq && s->input_link_count[id] < cap;
+}
+
+SOA_INLINE int soa_mask_scalar_tail(const mesh_soa* s, int source_id, const int* ids, int first_id, int begin, int count, uint64_t* mask,
+                                    float max_sq, int cap) {
+    float sx = s->x[source_id];
+    float sy = s->y[source_id];
+    int allowed = 0;
+    for (int j = begin; j < count; j++) {
+        if (soa_allowed(s, source_id, sx, sy, ids ? ids[j] : first_id + j, max_sq, cap)) {
+            mask[j >> 6] |= 1ULL << (j & 63);
+            allowed++;
+        }
+    }
+    return allowed;
+}
+
+static int soa_mask_scalar(const mesh_soa* s, int source_id, const int* ids, int first_id, int count, uint64_t* mask) {
+    return soa_mask_scalar_tail(s, source_id, ids, first_id, 0, count, mask, s->max_distance_sq, s->max_input_links);
+}
+
+static int soa_mask_scalar_fixed(const mesh_soa* s, int source_id, const int* ids, int first_id, int count, uint64_t* mask) {
+    return soa_mask_scalar_tail(s, source_id, ids, first_id, 0, count, mask, SOA_DEFAULT_DISTANCE_SQ, MESH_MAX_LINKS_PER_NODE);
+}
+
+#if defined(SOA_X86) && defined(__SSE2__)
+SOA_INLINE int soa_mask_sse2_body(const mesh_soa* s, int source_id, const int* ids, int first_id, int count, uint64_t* mask,
+                                  float max_distance_sq, int max_input_links) {
+    __m128 sx = _mm_set1_ps(s->x[source_id]);
+    __m128 sy = _mm_set1_ps(s->y[source_id]);
+    __m128 max_sq = _mm_set1_ps(max_distance_sq);
+    __m128i cap = _mm_set1_epi32(max_input_links);
+    __m128i source = _mm_set1_epi32(source_id);
+    __m128i lane = _mm_setr_epi32(0, 1, 2, 3);
+    int allowed = 0;
+    int j = 0;
+    for (; j + 4 <= count; j += 4) {
+        __m128i idx;
+        __m128 x, y;
+        __m128i in;
+        if (ids) {
+            // No gather before AVX2, the lanes are loaded one by one
+            const int* c = ids + j;
+            idx = _mm_loadu_si128((const __m128i*)c);
+            x = _mm_setr_ps(s->x[c[0]], s->x[c[1]], s->x[c[2]], s->x[c[3]]);
+            y = _mm_setr_ps(s->y[c[0]], s->y[c[1]], s->y[c[2]], s->y[c[3]]);
+            in = _mm_setr_epi32(s->input_link_count[c[0]], s->input_link_count[c[1]], s->input_link_count[c[2]], s->input_link_count[c[3]]);
+        } else {
+            idx = _mm_add_epi32(_mm_set1_epi32(first_id + j), lane);
+            x = _mm_loadu_ps(s->x + first_id + j);
+            y = _mm_loadu_ps(s->y + first_id + j);
+            in = _mm_loadu_si128((const __m128i*)(s->input_link_count + first_id + j));
+        }
+        __m128 dx = _mm_sub_ps(x, sx);
+        __m128 dy = _mm_sub_ps(y, sy);
+        __m128 near = _mm_cmple_ps(_mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy)), max_sq);
+        __m128i open = _mm_cmpgt_epi32(cap, in);
+        __m128i self = _mm_cmpeq_epi32(idx, source);
+        __m128i ok = _mm_andnot_si128(self, _mm_and_si128(_mm_castps_si128(near), open));
+        unsigned int bits = (unsigned int)_mm_movemask_ps(_mm_castsi128_ps(ok));
+        mask[j >> 6] |= (uint64_t)bits << (j & 63);
+        allowed += __builtin_popcount(bits);
+    }
+    return allowed + soa_mask_scalar_tail(s, source_id, ids, first_id, j, count, mask, max_distance_sq, max_input_links);
+}
+
+static int soa_mask_sse2(const mesh_soa* s, int source_id, const int* ids, int first_id, int count, uint64_t* mask) {
+    return soa_mask_sse2_body(s, source_id, ids, first_id, count, mask, s->max_distance_sq, s->max_input_links);
+}
+
+static int soa_mask_sse2_fixed(const mesh_soa* s, int source_id, const int* ids, int first_id, int count, uint64_t* mask) {
+    return soa_mask_sse2_body(s, source_id, ids, first_id, count, mask, SOA_DEFAULT_DISTANCE_SQ, MESH_MAX_LINKS_PER_NODE);
+}
+#endif
+
+#if defined(SOA_X86) && defined(__GNUC__)
+__attribute__((target("avx2")))
+SOA_INLINE int soa_mask_avx2_body(const mesh_soa* s, int source_id, const int* ids, int first_id, int count, uint64_t* mask,
+                                  float max_distance_sq, int max_input_links) {
+    __m256 sx = _mm256_set1_ps(s->x[source_id]);
+    __m256 sy = _mm256_set1_ps(s->y[source_id]);
+    __m256 max_sq = _mm256_set1_ps(max_distance_sq);
+    __m256i cap = _mm256_set1_epi32(max_input_links);
+    __m256i source = _mm256_set1_epi32(source_id);
+    __m256i lane = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+    int allowed = 0;
+    int j = 0;
+    for (; j + 8 <= count; j += 8) {
+        __m256i idx;
+        __m256 x, y;
+        __m256i in;
+        if (ids) {
+            idx = _mm256_loadu_si256((const __m256i*)(ids + j));
+            x = _mm256_i32gather_ps(s->x, idx, 4);
+            y = _mm256_i32gather_ps(s->y, idx, 4);
+            in = _mm256_i32gather_epi32(s->input_link_count, idx, 4);
+        } else {
+            idx = _mm256_add_epi32(_mm256_set1_epi32(first_id + j), lane);
+            x = _mm256_loadu_ps(s->x + first_id + j);
+            y = _mm256_loadu_ps(s->y + first_id + j);
+            in = _mm256_loadu_si256((const __m256i*)(s->input_link_count + first_id + j));
+        }
+        __m256 dx = _mm256_sub_ps(x, sx);
+        __m256 dy = _mm256_sub_ps(y, sy);
+        __m256 near = _mm256_cmp_ps(_mm256_add_ps(_mm256_mul_ps(dx, dx), _mm256_mul_ps(dy, dy)), max_sq, _CMP_LE_OQ);
+        __m256i open = _mm256_cmpgt_epi32(cap, in);
+        __m256i self = _mm256_cmpeq_epi32(idx, source);
+        __m256i ok = _mm256_andnot_si256(self, _mm256_and_si256(_mm256_castps_si256(near), open));
+        unsigned int bits = (unsigned int)_mm256_movemask_ps(_mm256_castsi256_ps(ok));
+        mask[j >> 6] |= (uint64_t)bits << (j & 63);
+        allowed += __builtin_popcount(bits);
+    }
+    return allowed + soa_mask_scalar_tail(s, source_id, ids, first_id, j, count, mask, max_distance_sq, max_input_links);
+}
+
+__attribute__((target("avx2")))
+static int soa_mask_avx2(const mesh_soa* s, int source_id, const int* ids, int first_id, int count, uint64_t* mask) {
+    return soa_mask_avx2_body(s, source_id, ids, first_id, count, mask, s->max_distance_sq, s->max_input_links);
+}
+
+__attribute__((target("avx2")))
+static int soa_mask_avx2_fixed(const mesh_soa* s, int source_id, const int* ids, int first_id, int count, uint64_t* mask) {
+    return soa_mask_avx2_body(s, source_id, ids, first_id, count, mask, SOA_DEFAULT_DISTANCE_SQ, MESH_MAX_LINKS_PER_NODE);
+}
+#endif
+
+// Picks the widest kernels the CPU runs, once. Racing threads store the same pointers.
+static soa_kernel_set soa_kernels(void) {
+    static mesh_soa_mask_fn generic, fixed;
+    soa_kernel_set set;
+    set.generic = __atomic_load_n(&generic, __ATOMIC_ACQUIRE);
+    if (set.generic) {
+        set.fixed = __atomic_load_n(&fixed, __ATOMIC_RELAXED);
+        return set;
+    }
+    set.generic = soa_mask_scalar;
+    set.fixed = soa_mask_scalar_fixed;
+#if defined(SOA_X86) && defined(__SSE2__)
+    set.generic = soa_mask_sse2;
+    set.fixed = soa_mask_sse2_fixed;
+#endif
+#if defined(SOA_X86) && defined(__GNUC__)
+    if (__builtin_cpu_supports("avx2")) {
+        set.generic = soa_mask_avx2;
+        set.fixed = soa_mask_avx2_fixed;
+    }
+#endif
+    __atomic_store_n(&fixed, set.fixed, __ATOMIC_RELAXED);
+    __atomic_store_n(&generic, set.generic, __ATOMIC_RELEASE);
+    return set;
+}
+
+static int soa_mask(mesh* m, int source_id, const int* ids, int first_id, int count, uint64_t* mask) {
+    const mesh_soa* s = &m->soa;
+    memset(mask, 0, sizeof(uint64_t) * ((count + 63) / 64));
+    if (count <= 0 || s->output_link_count[source_id] >= s->max_output_links) {
+        return 0;
+    }
+    return s->mask(s, source_id, ids, first_id, count, mask);
+}
+
+int mesh_link_mask(mesh* m, int source_id, const int* ids, int count, uint64_t* mask) {
+    return soa_mask(m, source_id, ids, 0, count, mask);
+}
+
+int mesh_link_mask_range(mesh* m, int source_id, int first_id, int count, uint64_t* mask) {
+    return soa_mask(m, source_id, NULL, first_id, count, mask);
+}
+
+int mesh_form_links(mesh* m, int source_id, const int* ids, int count) {
+    MESH_TIMED(MESH_TIME_FORM_LINKS);
+    mesh_soa* s = &m->soa;
+    int max_output = s->max_output_links;
+    int max_input = s->max_input_links;
+    uint64_t mask[SOA_FORM_BLOCK / 64];
+    int created = 0;
+    for (int b = 0; b < count; b += SOA_FORM_BLOCK) {
+        int n = count - b < SOA_FORM_BLOCK ? count - b : SOA_FORM_BLOCK;
+        if (mesh_link_mask(m, source_id, ids + b, n, mask) == 0) {
+            if (s->output_link_count[source_id] >= max_output) break;
+            continue;
+        }
+        for (int w = 0; w < (n + 63) / 64; w++) {
+            for (uint64_t bits = mask[w]; bits; bits &= bits - 1) {
+                int id = ids[b + w * 64 + __builtin_ctzll(bits)];
+                if (s->output_link_count[source_id] >= max_output) {
+                    return created;
+                }
+                // The mask saw the counts before this call, a repeated candidate may have filled up since
+                if (s->input_link_count[id] >= max_input) {
+                    continue;
+                }
+                if (init_mesh_link(m, m->next_link_id, &m->nodes[source_id], &m->nodes[id]) < 0) {
+                    return -1;
+                }
+                created++;
+            }
+        }
+    }
+    return created;
+}
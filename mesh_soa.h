@@ -0,0 +1,64 @@
+#pragma once
+
+#include <stdint.h>
+#include "mesh_settings.h"
+
+typedef struct mesh mesh; // Forward declaration
+
+typedef struct mesh_soa mesh_soa;
+
+/// Tests a source against the candidates ids[0..count) or, when ids is NULL, first_id..first_id + count - 1
+typedef int (*mesh_soa_mask_fn)(const mesh_soa* s, int source_id, const int* ids, int first_id, int count, uint64_t* mask);
+
+
+/// @brief Structure-of-arrays mirror of the node fields read by the link tests.
+/// Kept in sync by the mesh functions that move nodes or add links, so batches of
+/// candidates are tested with contiguous (or gathered) vector loads.
+struct mesh_soa{
+    int node_count;             /// Number of nodes mirrored
+    float* x;                   /// X coordinate of each node
+    float* y;                   /// Y coordinate of each node
+    int* output_link_count;     /// Number of output links of each node
+    int* input_link_count;      /// Number of input links of each node
+    unsigned char* node_status; /// Status of each node
+    float max_distance_sq;      /// Square of the max link distance of the mesh
+    int max_input_links;        /// Input links a node accepts
+    int max_output_links;       /// Output links a node opens
+    mesh_soa_mask_fn mask;      /// Link test kernel picked for the CPU and the link rules
+};
+
+
+///@brief Copies the node positions, link counts, statuses and link rules into the mirror, and picks its kernel.
+/// The arrays are taken from the mesh arena on the first build and reused afterwards.
+///@param m A pointer to the mesh structure.
+///@return int 0 on success, -1 on allocation failure.
+int mesh_soa_build(mesh* m);
+
+///@brief Tests a source against a block of candidates with the rules of mesh_link_allowed().
+/// Bit j of mask is set when candidate j may receive a link from the source, against the
+/// link counts at the time of the call. Uses AVX2 or SSE2 when the CPU has them, and kernels with the
+/// distance and caps of mesh_settings.h folded in as constants when the mesh uses those.
+///@param m A pointer to the mesh structure.
+///@param source_id The ID of the source node.
+///@param ids The IDs of the candidates.
+///@param count The number of candidates.
+///@param mask Output bitmask of (count + 63) / 64 words.
+///@return int The number of allowed candidates.
+int mesh_link_mask(mesh* m, int source_id, const int* ids, int count, uint64_t* mask);
+
+///@brief Same as mesh_link_mask() for the candidates first_id to first_id + count - 1.
+///@param m A pointer to the mesh structure.
+///@param source_id The ID of the source node.
+///@param first_id The ID of the first candidate.
+///@param count The number of candidates.
+///@param mask Output bitmask of (count + 63) / 64 words.
+///@return int The number of allowed candidates.
+int mesh_link_mask_range(mesh* m, int source_id, int first_id, int count, uint64_t* mask);
+
+///@brief Links a source to the allowed candidates, in order, until the source is full.
+///@param m A pointer to the mesh structure.
+///@param source_id The ID of the source node.
+///@param ids The IDs of the candidates.
+///@param count The number of candidates.
+///@return int The number of links created, -1 on allocation failure.
+int mesh_form_links(mesh* m, int source_id, const int* ids, int count);
@@ -0,0 +1,412 @@
+#include "mesh_compute.h"
+
+static int spt_prepare(mesh* m) {
+    mesh_spt_set* set = &m->spt;
+    int n = m->node_count;
+    if (set->node_count == n) {
+        return 0;
+    }
+    set->affected = (unsigned int*)mesh_arena_calloc(&m->arena, sizeof(unsigned int) * n);
+    set->changed = (unsigned int*)mesh_arena_calloc(&m->arena, sizeof(unsigned int) * n);
+    set->list = (int*)mesh_arena_alloc(&m->arena, sizeof(int) * n);
+    set->heap = (int*)mesh_arena_alloc(&m->arena, sizeof(int) * n);
+    set->heap_pos = (int*)mesh_arena_alloc(&m->arena, sizeof(int) * n);
+    for (int metric = METRIC_LATENCY; metric <= METRIC_HOPS; metric++) {
+        set->tree_of[metric] = (int*)mesh_arena_alloc(&m->arena, sizeof(int) * n);
+        if (!set->tree_of[metric]) {
+            return -1;
+        }
+        memset(set->tree_of[metric], -1, sizeof(int) * n);
+    }
+    if (!set->affected || !set->changed || !set->list || !set->heap || !set->heap_pos) {
+        return -1;
+    }
+    memset(set->heap_pos, -1, sizeof(int) * n);
+    set->heap_size = 0;
+    set->stamp = 0;
+    set->node_count = n;
+    return 0;
+}
+
+static void spt_next_stamp(mesh_spt_set* set) {
+    if (++set->stamp == 0) {
+        // Generation counter wrapped, forget every stale stamp once
+        memset(set->affected, 0, sizeof(unsigned int) * set->node_count);
+        memset(set->changed, 0, sizeof(unsigned int) * set->node_count);
+        set->stamp = 1;
+    }
+    set->list_size = 0;
+}
+
+// Records that the route of a node changed in this generation
+static void spt_change(mesh_spt_set* set, int v) {
+    if (set->changed[v] != set->stamp) {
+        set->changed[v] = set->stamp;
+        set->list[set->list_size++] = v;
+    }
+}
+
+// Links touching an INACTIVE node cannot carry traffic
+static float spt_weight(mesh* m, const mesh_spt* t, int source_id, int destination_id, float latency) {
+    if (m->soa.node_status[source_id] == INACTIVE || m->soa.node_status[destination_id] == INACTIVE) {
+        return INFINITY;
+    }
+    return t->metric == METRIC_HOPS ? 1.0f : latency;
+}
+
+static void spt_heap_up(mesh_spt_set* set, const float* dist, int i) {
+    int v = set->heap[i];
+    while (i > 0) {
+        int parent = (i - 1) / 2;
+        int p = set->heap[parent];
+        if (dist[p] <= dist[v]) break;
+        set->heap[i] = p;
+        set->heap_pos[p] = i;
+        i = parent;
+    }
+    set->heap[i] = v;
+    set->heap_pos[v] = i;
+}
+
+static void spt_heap_down(mesh_spt_set* set, const float* dist, int i) {
+    int v = set->heap[i];
+    for (;;) {
+        int child = 2 * i + 1;
+        if (child >= set->heap_size) break;
+        if (child + 1 < set->heap_size && dist[set->heap[child + 1]] < dist[set->heap[child]]) child++;
+        int c = set->heap[child];
+        if (dist[c] >= dist[v]) break;
+        set->heap[i] = c;
+        set->heap_pos[c] = i;
+        i = child;
+    }
+    set->heap[i] = v;
+    set->heap_pos[v] = i;
+}
+
+// Inserts a node or moves it up after its distance decreased
+static void spt_heap_update(mesh_spt_set* set, const float* dist, int v) {
+    if (set->heap_pos[v] < 0) {
+        set->heap[set->heap_size] = v;
+        set->heap_pos[v] = set->heap_size++;
+    }
+    spt_heap_up(set, dist, set->heap_pos[v]);
+}
+
+static int spt_heap_pop(mesh_spt_set* set, const float* dist) {
+    int v = set->heap[0];
+    set->heap_pos[v] = -1;
+    if (--set->heap_size > 0) {
+        set->heap[0] = set->heap[set->heap_size];
+        spt_heap_down(set, dist, 0);
+    }
+    return v;
+}
+
+// Dijkstra from the nodes in the heap. Nodes outside a reset subtree are only reached when a link
+// that got better in the same change leads there through it, links that only got worse cannot
+static int spt_propagate(mesh* m, mesh_csr* csr, mesh_spt* t) {
+    mesh_spt_set* set = &m->spt;
+    int touched = 0;
+    while (set->heap_size > 0) {
+        int x = spt_heap_pop(set, t->dist);
+        for (int e = csr->out_offset[x]; e < csr->out_offset[x] + csr->out_degree[x]; e++) {
+            int y = csr->out_target[e];
+            float candidate = t->dist[x] + spt_weight(m, t, x, y, csr->out_latency[e]);
+            if (candidate < t->dist[y]) {
+                t->dist[y] = candidate;
+                t->pred_link[y] = csr->out_link[e];
+                spt_change(set, y);
+                spt_heap_update(set, t->dist, y);
+                touched++;
+            }
+        }
+    }
+    return touched;
+}
+
+// A tree only changes when one of the links that got worse is a tree link
+static bool spt_uses_links(const mesh_spt* t, const int* links, const int* targets, int count) {
+    for (int i = 0; i < count; i++) {
+        if (t->pred_link[targets[i]] == links[i]) return true;
+    }
+    return false;
+}
+
+// A tree only changes when one of the links that got better shortens the route to its destination
+static bool spt_improved_by_links(mesh* m, const mesh_spt* t, const int* links, int count) {
+    for (int i = 0; i < count; i++) {
+        mesh_link* link = &m->links[links[i]];
+        int s = link->source_id;
+        int d = link->destination_id;
+        if (t->dist[s] + spt_weight(m, t, s, d, link->latency) < t->dist[d]) return true;
+    }
+    return false;
+}
+
+static int spt_repair_worse(mesh* m, mesh_csr* csr, mesh_spt* t, const int* links, const int* targets, int count) {
+    mesh_spt_set* set = &m->spt;
+    int size = 0;
+    for (int i = 0; i < count; i++) {
+        int v = targets[i];
+        if (t->pred_link[v] == links[i] && set->affected[v] != set->stamp) {
+            set->affected[v] = set->stamp;
+            set->list[size++] = v;
+        }
+    }
+    // Everything hanging below a weakened tree link may have to find another way
+    for (int i = 0; i < size; i++) {
+        int x = set->list[i];
+        for (int e = csr->out_offset[x]; e < csr->out_offset[x] + csr->out_degree[x]; e++) {
+            int y = csr->out_target[e];
+            if (set->affected[y] != set->stamp && t->pred_link[y] == csr->out_link[e]) {
+                set->affected[y] = set->stamp;
+                set->list[size++] = y;
+            }
+        }
+    }
+    set->list_size = 0;
+    for (int i = 0; i < size; i++) {
+        int x = set->list[i];
+        t->dist[x] = INFINITY;
+        t->pred_link[x] = -1;
+        spt_change(set, x);
+    }
+    // Reattach the subtree from the nodes around it, whose distances did not change
+    for (int i = 0; i < size; i++) {
+        int x = set->list[i];
+        for (int e = csr->in_offset[x]; e < csr->in_offset[x] + csr->in_degree[x]; e++) {
+            int p = csr->in_source[e];
+            if (set->affected[p] == set->stamp) continue;
+            float candidate = t->dist[p] + spt_weight(m, t, p, x, csr->in_latency[e]);
+            if (candidate < t->dist[x]) {
+                t->dist[x] = candidate;
+                t->pred_link[x] = csr->in_link[e];
+            }
+        }
+        if (t->dist[x] < INFINITY) spt_heap_update(set, t->dist, x);
+    }
+    spt_propagate(m, csr, t);
+    return size;
+}
+
+static int spt_repair_better(mesh* m, mesh_csr* csr, mesh_spt* t, const int* links, int count) {
+    mesh_spt_set* set = &m->spt;
+    int touched = 0;
+    for (int i = 0; i < count; i++) {
+        mesh_link* link = &m->links[links[i]];
+        int s = link->source_id;
+        int d = link->destination_id;
+        float candidate = t->dist[s] + spt_weight(m, t, s, d, link->latency);
+        if (candidate < t->dist[d]) {
+            t->dist[d] = candidate;
+            t->pred_link[d] = links[i];
+            spt_change(set, d);
+            spt_heap_update(set, t->dist, d);
+            touched++;
+        }
+    }
+    return touched + spt_propagate(m, csr, t);
+}
+
+// Rewrites the stored paths of a tree that cross a node whose route changed in this generation
+static int spt_refresh_paths(mesh* m, mesh_csr* csr, mesh_spt* t) {
+    mesh_spt_set* set = &m->spt;
+    if (!t->path_head) {
+        return 0;
+    }
+    // A route crosses a changed node exactly when its end hangs below one in the repaired tree,
+    // the descendants usually changed too but a tie can keep their distance
+    for (int i = 0; i < set->list_size; i++) {
+        int x = set->list[i];
+        for (int e = csr->out_offset[x]; e < csr->out_offset[x] + csr->out_degree[x]; e++) {
+            if (t->pred_link[csr->out_target[e]] == csr->out_link[e]) spt_change(set, csr->out_target[e]);
+        }
+    }
+    for (int i = 0; i < set->list_size; i++) {
+        for (int p = t->path_head[set->list[i]]; p >= 0; p = set->path_next[p]) {
+            if (mesh_spt_fill_path(m, &m->paths[p]) != 0) {
+                return -1;
+            }
+        }
+    }
+    return 0;
+}
+
+int mesh_spt_find(mesh* m, int source_id, path_metric metric) {
+    mesh_spt_set* set = &m->spt;
+    if (set->tree_of[metric] && set->tree_of[metric][source_id] >= 0) {
+        return set->tree_of[metric][source_id];
+    }
+    mesh_csr* csr = mesh_get_csr(m);
+    if (!csr || spt_prepare(m) != 0) {
+        return -1;
+    }
+    if (set->count == set->capacity) {
+        int capacity = set->capacity ? set->capacity * 2 : 8;
+        mesh_spt* trees = (mesh_spt*)mesh_arena_realloc(&m->arena, set->trees, sizeof(mesh_spt) * set->capacity, sizeof(mesh_spt) * capacity);
+        if (!trees) {
+            return -1;
+        }
+        set->trees = trees;
+        set->capacity = capacity;
+    }
+    int n = m->node_count;
+    mesh_spt* t = &set->trees[set->count];
+    t->source_id = source_id;
+    t->metric = metric;
+    t->path_head = NULL;
+    t->lazy_ends = NULL;
+    t->dist = (float*)mesh_arena_alloc(&m->arena, sizeof(float) * n);
+    t->pred_link = (int*)mesh_arena_alloc(&m->arena, sizeof(int) * n);
+    if (!t->dist || !t->pred_link) {
+        return -1;
+    }
+    for (int v = 0; v < n; v++) {
+        t->dist[v] = INFINITY;
+        t->pred_link[v] = -1;
+    }
+    t->dist[source_id] = 0.0f;
+    spt_next_stamp(set);
+    spt_heap_update(set, t->dist, source_id);
+    spt_propagate(m, csr, t);
+    set->tree_of[metric][source_id] = set->count;
+    return set->count++;
+}
+
+int mesh_spt_links_worse(mesh* m, const int* links, const int* targets, int count) {
+    mesh_spt_set* set = &m->spt;
+    if (set->count == 0 || count == 0) {
+        return 0;
+    }
+    MESH_TIMED(MESH_TIME_SPT_REPAIR);
+    mesh_csr* csr = mesh_get_csr(m);
+    if (!csr) {
+        return -1;
+    }
+    for (int i = 0; i < set->count; i++) {
+        mesh_spt* t = &set->trees[i];
+        if (!spt_uses_links(t, links, targets, count)) continue;
+        spt_next_stamp(set);
+        if (spt_repair_worse(m, csr, t, links, targets, count) > 0 && spt_refresh_paths(m, csr, t) != 0) {
+            return -1;
+        }
+    }
+    return 0;
+}
+
+int mesh_spt_links_better(mesh* m, const int* links, int count) {
+    mesh_spt_set* set = &m->spt;
+    if (set->count == 0 || count == 0) {
+        return 0;
+    }
+    MESH_TIMED(MESH_TIME_SPT_REPAIR);
+    mesh_csr* csr = mesh_get_csr(m);
+    if (!csr) {
+        return -1;
+    }
+    for (int i = 0; i < set->count; i++) {
+        mesh_spt* t = &set->trees[i];
+        if (!spt_improved_by_links(m, t, links, count)) continue;
+        spt_next_stamp(set);
+        if (spt_repair_better(m, csr, t, links, count) > 0 && spt_refresh_paths(m, csr, t) != 0) {
+            return -1;
+        }
+    }
+    return 0;
+}
+
+void mesh_spt_relink(mesh* m, int from, int to) {
+    mesh_spt_set* set = &m->spt;
+    int d = m->links[to].destination_id;
+    for (int i = 0; i < set->count; i++) {
+        if (set->trees[i].pred_link[d] == from) set->trees[i].pred_link[d] = to;
+    }
+}
+
+int mesh_spt_walk(mesh* m, int tree, int end_id, uint32_t* ids) {
+    mesh_spt* t = &m->spt.trees[tree];
+    if (t->dist[end_id] == INFINITY) {
+        return 0;
+    }
+    int count = 1;
+    for (int v = end_id; t->pred_link[v] >= 0; v = m->links[t->pred_link[v]].source_id) count++;
+    if (ids) {
+        int v = end_id;
+        for (int i = count - 1; i >= 0; i--) {
+            ids[i] = (uint32_t)v;
+            if (t->pred_link[v] >= 0) v = m->links[t->pred_link[v]].source_id;
+        }
+    }
+    return count;
+}
+
+int mesh_spt_track_path(mesh* m, mesh_path* path) {
+    mesh_spt_set* set = &m->spt;
+    mesh_spt* t = &set->trees[path->tree];
+    if (!t->path_head) {
+        t->path_head = (int*)mesh_arena_alloc(&m->arena, sizeof(int) * m->node_count);
+        if (!t->path_head) {
+            return -1;
+        }
+        memset(t->path_head, -1, sizeof(int) * m->node_count);
+    }
+    int index = (int)(path - m->paths);
+    if (index >= set->path_next_capacity) {
+        int capacity = m->path_capacity;
+        int* next = (int*)mesh_arena_realloc(&m->arena, set->path_next, sizeof(int) * set->path_next_capacity, sizeof(int) * capacity);
+        if (!next) {
+            return -1;
+        }
+        set->path_next = next;
+        set->path_next_capacity = capacity;
+    }
+    set->path_next[index] = t->path_head[path->end_node_id];
+    t->path_head[path->end_node_id] = index;
+    return 0;
+}
+
+int mesh_spt_add_lazy(mesh* m, int tree, int end_id) {
+    mesh_spt* t = &m->spt.trees[tree];
+    if (!t->lazy_ends) {
+        t->lazy_ends = (uint64_t*)mesh_arena_calloc(&m->arena, sizeof(uint64_t) * ((m->node_count + 63) / 64));
+        if (!t->lazy_ends) {
+            return -1;
+        }
+    }
+    uint64_t bit = (uint64_t)1 << (end_id % 64);
+    if (!(t->lazy_ends[end_id / 64] & bit)) {
+        t->lazy_ends[end_id / 64] |= bit;
+        m->spt.lazy_count++;
+    }
+    return 0;
+}
+
+int mesh_spt_next_lazy(const mesh* m, int tree, int after) {
+    const uint64_t* ends = m->spt.trees[tree].lazy_ends;
+    int start = after + 1;
+    if (!ends || start >= m->node_count) {
+        return -1;
+    }
+    int words = (m->node_count + 63) / 64;
+    int word = start / 64;
+    uint64_t bits = ends[word] & (~(uint64_t)0 << (start % 64));
+    while (!bits) {
+        if (++word == words) {
+            return -1;
+        }
+        bits = ends[word];
+    }
+    return word * 64 + __builtin_ctzll(bits);
+}
+
+int mesh_spt_fill_path(mesh* m, mesh_path* path) {
+    int count = mesh_spt_walk(m, path->tree, path->end_node_id, NULL);
+    path->length = count;
+    if (mesh_path_reserve(m, path, count) != 0) {
+        path->length = 0;
+        return -1;
+    }
+    mesh_spt_walk(m, path->tree, path->end_node_id, m->path_nodes + path->first);
+    return 0;
+}
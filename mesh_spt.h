@@ -0,0 +1,112 @@
+#pragma once
+
+#include <stdint.h>
+#include "mesh_sssp.h"
+
+typedef struct mesh mesh; // Forward declaration
+
+typedef struct mesh_spt mesh_spt;
+
+typedef struct mesh_spt_set mesh_spt_set;
+
+
+/// @brief Shortest path tree from one source, kept exact as links and nodes change.
+struct mesh_spt{
+    int source_id;              /// Root of the tree
+    path_metric metric;         /// Weight of the links
+    float* dist;                /// Distance from the root, INFINITY if unreachable
+    int* pred_link;             /// Index in mesh->links of the tree link reaching each node, -1 for the root and unreachable nodes
+    int* path_head;             /// Index in mesh->paths of the first stored path of the tree ending at each node, chained by mesh_spt_set.path_next. NULL until the tree stores a path
+    uint64_t* lazy_ends;        /// Bit set of the end nodes of the lazy paths from the root, NULL until the tree has one
+};
+
+/// @brief Trees maintained by the mesh, one per source and metric of its stored paths.
+/// Changes are repaired in the spirit of Ramalingam and Reps (1996): links that got worse
+/// reset the subtree below them, which is then reattached from its unaffected border, and
+/// links that got better start a Dijkstra limited to the nodes they improve. Either way the
+/// work follows the number of nodes whose distance changes, not the size of the mesh.
+/// Trees that none of the links can change are skipped, and only the stored paths ending
+/// at a node whose route changed are rewritten.
+struct mesh_spt_set{
+    mesh_spt* trees;            /// Maintained trees
+    int count;                  /// Number of trees
+    int capacity;               /// Number of trees the array can hold
+    int node_count;             /// Number of nodes the scratch buffers were sized for
+    int* tree_of[METRIC_HOPS + 1]; /// Index of the tree of each source node by metric, -1 before it is built
+    int* path_next;             /// Index in mesh->paths of the next stored path of the same tree and end node, -1 at the end
+    int path_next_capacity;     /// Number of paths path_next can hold
+    int lazy_count;             /// Number of lazy paths, over the lazy_ends of every tree
+    unsigned int stamp;         /// Generation of the current repair
+    unsigned int* affected;     /// Generation in which each node lost its tree link
+    unsigned int* changed;      /// Generation in which the route of each node changed
+    int* list;                  /// Nodes of the affected subtree, then every node whose route changed
+    int list_size;              /// Number of nodes in list
+    int* heap;                  /// Binary min-heap of node ids keyed by the dist of the tree under repair
+    int* heap_pos;              /// Position of each node in the heap, -1 outside
+    int heap_size;              /// Number of nodes in the heap
+};
+
+
+///@brief Returns the tree of a source, building it on first use.
+///@param m A pointer to the mesh structure.
+///@param source_id The ID of the root node.
+///@param metric The link weight, latency or one per hop.
+///@return int The index of the tree in mesh->spt.trees, -1 on allocation failure.
+int mesh_spt_find(mesh* m, int source_id, path_metric metric);
+
+///@brief Repairs the trees after links got longer or unusable (removed, or touching a node that became INACTIVE).
+/// The adjacency must already hold the new weights and no longer hold removed links.
+///@param m A pointer to the mesh structure.
+///@param links The indices in mesh->links of the links.
+///@param targets The destination node of each link.
+///@param count The number of links.
+///@return int 0 on success, -1 on allocation failure.
+int mesh_spt_links_worse(mesh* m, const int* links, const int* targets, int count);
+
+///@brief Repairs the trees after links got shorter or usable (added, or touching a node that is no longer INACTIVE).
+///@param m A pointer to the mesh structure.
+///@param links The indices in mesh->links of the links.
+///@param count The number of links.
+///@return int 0 on success, -1 on allocation failure.
+int mesh_spt_links_better(mesh* m, const int* links, int count);
+
+///@brief Renames a link in the trees after it moved in mesh->links.
+///@param m A pointer to the mesh structure.
+///@param from The old index of the link.
+///@param to The new index of the link, mesh->links[to] already holds it.
+void mesh_spt_relink(mesh* m, int from, int to);
+
+///@brief Writes the node IDs of the route from the root of a tree to a node.
+///@param m A pointer to the mesh structure.
+///@param tree The index of the tree in mesh->spt.trees.
+///@param end_id The ID of the last node of the route.
+///@param ids Output buffer receiving the node IDs from the root to end_id, may be NULL to only count them.
+///@return int The number of nodes on the route, 0 if end_id is unreachable.
+int mesh_spt_walk(mesh* m, int tree, int end_id, uint32_t* ids);
+
+///@brief Registers a stored path with its tree so that repairs rewrite it.
+///@param m A pointer to the mesh structure.
+///@param path A pointer to a path of mesh->paths whose tree is set.
+///@return int 0 on success, -1 on allocation failure.
+int mesh_spt_track_path(mesh* m, mesh_path* path);
+
+///@brief Adds a lazy path to a tree. It costs one bit, repairs leave it alone and its nodes are walked when read.
+/// Adding the same end node twice keeps one path.
+///@param m A pointer to the mesh structure.
+///@param tree The index of the tree of the start node in mesh->spt.trees.
+///@param end_id The ID of the end node.
+///@return int 0 on success, -1 on allocation failure.
+int mesh_spt_add_lazy(mesh* m, int tree, int end_id);
+
+///@brief Finds the next end node of the lazy paths of a tree.
+///@param m A pointer to the mesh structure.
+///@param tree The index of the tree in mesh->spt.trees.
+///@param after The end node to start after, -1 for the first.
+///@return int The ID of the end node, -1 when there is none left.
+int mesh_spt_next_lazy(const mesh* m, int tree, int after);
+
+///@brief Rewrites a stored path from the current tree of its start node.
+///@param m A pointer to the mesh structure.
+///@param path A pointer to a path maintained by a tree.
+///@return int 0 on success, -1 on allocation failure.
+int mesh_spt_fill_path(mesh* m, mesh_path* path);
@@ -0,0 +1,161 @@
+#include "mesh_compute.h"
+
+#define SSSP_HEAP_ARITY 4
+
+static int sssp_prepare(mesh* m, mesh_sssp* sp) {
+    int n = m->node_count;
+    if (sp->node_count != n) {
+        sp->seen = (unsigned int*)mesh_arena_calloc(&m->arena, sizeof(unsigned int) * n);
+        sp->dist = (float*)mesh_arena_alloc(&m->arena, sizeof(float) * n);
+        sp->hops = (int*)mesh_arena_alloc(&m->arena, sizeof(int) * n);
+        sp->pred_link = (int*)mesh_arena_alloc(&m->arena, sizeof(int) * n);
+        sp->heap = (int*)mesh_arena_alloc(&m->arena, sizeof(int) * n);
+        sp->heap_pos = (int*)mesh_arena_alloc(&m->arena, sizeof(int) * n);
+        if (!sp->seen || !sp->dist || !sp->hops || !sp->pred_link || !sp->heap || !sp->heap_pos) {
+            sp->node_count = 0;
+            return -1;
+        }
+        sp->node_count = n;
+        sp->stamp = 0;
+    }
+    if (++sp->stamp == 0) {
+        // Generation counter wrapped, forget every stale stamp once
+        memset(sp->seen, 0, sizeof(unsigned int) * n);
+        sp->stamp = 1;
+    }
+    sp->heap_size = 0;
+    return 0;
+}
+
+static void sssp_heap_up(mesh_sssp* sp, int i) {
+    int v = sp->heap[i];
+    float d = sp->dist[v];
+    while (i > 0) {
+        int parent = (i - 1) / SSSP_HEAP_ARITY;
+        int p = sp->heap[parent];
+        if (sp->dist[p] <= d) break;
+        sp->heap[i] = p;
+        sp->heap_pos[p] = i;
+        i = parent;
+    }
+    sp->heap[i] = v;
+    sp->heap_pos[v] = i;
+}
+
+static void sssp_heap_down(mesh_sssp* sp, int i) {
+    int v = sp->heap[i];
+    float d = sp->dist[v];
+    for (;;) {
+        int first = i * SSSP_HEAP_ARITY + 1;
+        if (first >= sp->heap_size) break;
+        int last = first + SSSP_HEAP_ARITY < sp->heap_size ? first + SSSP_HEAP_ARITY : sp->heap_size;
+        int best = first;
+        for (int c = first + 1; c < last; c++) {
+            if (sp->dist[sp->heap[c]] < sp->dist[sp->heap[best]]) best = c;
+        }
+        int b = sp->heap[best];
+        if (sp->dist[b] >= d) break;
+        sp->heap[i] = b;
+        sp->heap_pos[b] = i;
+        i = best;
+    }
+    sp->heap[i] = v;
+    sp->heap_pos[v] = i;
+}
+
+static int sssp_pop(mesh_sssp* sp) {
+    int v = sp->heap[0];
+    sp->heap_pos[v] = -1;
+    if (--sp->heap_size > 0) {
+        sp->heap[0] = sp->heap[sp->heap_size];
+        sssp_heap_down(sp, 0);
+    }
+    return v;
+}
+
+mesh_sssp* mesh_shortest_paths(mesh* m, int source_id, int target_id, path_metric metric) {
+    MESH_TIMED(MESH_TIME_SHORTEST_PATHS);
+    mesh_csr* csr = mesh_get_csr(m);
+    mesh_sssp* sp = &m->sssp;
+    if (!csr || sssp_prepare(m, sp) != 0) {
+        return NULL;
+    }
+
+    sp->seen[source_id] = sp->stamp;
+    sp->dist[source_id] = 0.0f;
+    sp->hops[source_id] = 0;
+    sp->pred_link[source_id] = -1;
+    sp->heap[0] = source_id;
+    sp->heap_pos[source_id] = 0;
+    sp->heap_size = 1;
+
+    while (sp->heap_size > 0) {
+        int v = sssp_pop(sp);
+        if (v == target_id) break;
+        // Inactive nodes neither forward nor receive traffic
+        if (m->soa.node_status[v] == INACTIVE) continue;
+        float dv = sp->dist[v];
+        for (int e = csr->out_offset[v]; e < csr->out_offset[v] + csr->out_degree[v]; e++) {
+            int w = csr->out_target[e];
+            if (m->soa.node_status[w] == INACTIVE) continue;
+            float dw = dv + (metric == METRIC_HOPS ? 1.0f : csr->out_latency[e]);
+            if (sp->seen[w] != sp->stamp) {
+                sp->seen[w] = sp->stamp;
+                sp->dist[w] = dw;
+                sp->hops[w] = sp->hops[v] + 1;
+                sp->pred_link[w] = csr->out_link[e];
+                sp->heap[sp->heap_size] = w;
+                sssp_heap_up(sp, sp->heap_size++);
+            } else if (sp->heap_pos[w] >= 0 && dw < sp->dist[w]) {
+                sp->dist[w] = dw;
+                sp->hops[w] = sp->hops[v] + 1;
+                sp->pred_link[w] = csr->out_link[e];
+                sssp_heap_up(sp, sp->heap_pos[w]);
+            }
+        }
+    }
+    return sp;
+}
+
+int mesh_sssp_reached(mesh_sssp* sp, int id) {
+    return sp->seen[id] == sp->stamp;
+}
+
+int mesh_sssp_route(mesh* m, mesh_sssp* sp, int target_id, int* ids, int max_ids) {
+    if (!mesh_sssp_reached(sp, target_id)) {
+        return -1;
+    }
+    int count = sp->hops[target_id] + 1;
+    if (count > max_ids) {
+        return count;
+    }
+    int v = target_id;
+    for (int i = count - 1; i >= 0; i--) {
+        ids[i] = v;
+        if (sp->pred_link[v] >= 0) v = m->links[sp->pred_link[v]].source_id;
+    }
+    return count;
+}
+
+mesh_path* mesh_add_path(mesh* m, int start_id, int end_id, path_metric metric) {
+    int tree = mesh_spt_find(m, start_id, metric);
+    if (tree < 0 || m->spt.trees[tree].dist[end_id] == INFINITY) {
+        return NULL;
+    }
+    // A lazy path is a bit of the tree, the record handed back is not kept and gets its length when read
+    if (m->config.lazy_paths) {
+        if (mesh_spt_add_lazy(m, tree, end_id) != 0) {
+            return NULL;
+        }
+        mesh_path* path = init_mesh_path(&m->lazy_path, -1, start_id, end_id);
+        path->tree = tree;
+        path->lazy = true;
+        return path;
+    }
+    mesh_path* path = mesh_append_path(m, start_id, end_id, 0);
+    if (!path) {
+        return NULL;
+    }
+    path->tree = tree;
+    return mesh_spt_fill_path(m, path) == 0 && mesh_spt_track_path(m, path) == 0 ? path : NULL;
+}
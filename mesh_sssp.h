@@ -0,0 +1,65 @@
+#pragma once
+
+typedef struct mesh mesh; // Forward declaration
+
+typedef struct mesh_path mesh_path;
+
+typedef struct mesh_sssp mesh_sssp;
+
+typedef enum path_metric {
+    METRIC_LATENCY,
+    METRIC_HOPS
+}path_metric;
+
+
+/// @brief Scratch buffers of the single-source shortest path engine, reused across queries.
+/// Entries are only meaningful for nodes whose seen stamp matches the current query,
+/// so starting a query does not clear anything.
+struct mesh_sssp{
+    int node_count;             /// Number of nodes the buffers were sized for
+    unsigned int stamp;         /// Generation of the current query
+    unsigned int* seen;         /// Generation in which each node was reached
+    float* dist;                /// Distance from the source in the chosen metric
+    int* hops;                  /// Number of links from the source
+    int* pred_link;             /// Index in mesh->links of the link reaching each node, -1 for the source
+    int* heap;                  /// 4-ary min-heap of node ids keyed by dist
+    int* heap_pos;              /// Position of each node in the heap, -1 once settled
+    int heap_size;              /// Number of nodes in the heap
+};
+
+
+///@brief Runs a shortest path search from a source node, routing around INACTIVE nodes.
+///@param m A pointer to the mesh structure.
+///@param source_id The ID of the source node.
+///@param target_id The ID of a node at which the search can stop, or -1 to build the whole tree.
+///@param metric The link weight, latency or one per hop.
+///@return mesh_sssp* The search state holding distances and predecessors, or NULL on failure.
+mesh_sssp* mesh_shortest_paths(mesh* m, int source_id, int target_id, path_metric metric);
+
+///@brief Check if a node was reached by the last search.
+///@param sp The search state returned by mesh_shortest_paths().
+///@param id The ID of the node.
+///@return int 1 if the node was reached, 0 otherwise.
+int mesh_sssp_reached(mesh_sssp* sp, int id);
+
+///@brief Writes the route from the source of the last search to a node.
+///@param m A pointer to the mesh structure.
+///@param sp The search state returned by mesh_shortest_paths().
+///@param target_id The ID of the last node of the route.
+///@param ids Output buffer receiving the node IDs from the source to the target.
+///@param max_ids The capacity of the ids buffer.
+///@return int The number of nodes on the route, or -1 if the target was not reached.
+int mesh_sssp_route(mesh* m, mesh_sssp* sp, int target_id, int* ids, int max_ids);
+
+///@brief Computes the shortest path between two nodes and appends it to the mesh paths.
+/// The path is kept shortest as the mesh changes, through the tree of its start node (see mesh_spt.h).
+/// With the lazy_paths configuration only that tree is kept, shared by every path from the node:
+/// the path is one bit of the tree, left out of mesh->paths and of the repairs, enumerated by
+/// mesh_path_next() and walked from the tree by mesh_path_nodes().
+///@param m A pointer to the mesh structure.
+///@param start_id The ID of the starting node.
+///@param end_id The ID of the ending node.
+///@param metric The link weight, latency or one per hop.
+///@return mesh_path* The stored path, or NULL if the end node is unreachable. The record of a lazy path is
+/// overwritten by the next lazy path added, its length is set by mesh_path_nodes().
+mesh_path* mesh_add_path(mesh* m, int start_id, int end_id, path_metric metric);
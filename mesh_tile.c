@@ -0,0 +1,1014 @@
+#include <fcntl.h>
+#include <sched.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include "mesh_calendar.h"
+#include "mesh_compute.h"
+#include "mesh_tile.h"
+
+#define TILE_BINS 64 // Load histogram bins per strip
+
+typedef enum tile_record_type {
+    TILE_PACKET,                /// A packet at a node, from a link into the strip or moved with its node
+    TILE_NODE,                  /// A node and its flow, moved to the strip by rebalancing
+    TILE_HALO                   /// A node of a neighbor within the max link distance of the strip
+}tile_record_type;
+
+typedef enum tile_event {
+    TILE_INJECT,                /// A node emits its next packet, data is the node
+    TILE_LINK_DONE,             /// A link finished serializing its packet, data is the link
+    TILE_ARRIVE                 /// A packet is at a node, data is the packet
+}tile_event;
+
+// Message between neighbor workers, nodes are named by global ID
+typedef struct tile_record {
+    int type;
+    int node;                   /// Global ID of the node
+    float x, y;                 /// Position of the node
+    double time;                /// Arrival (TILE_PACKET) or next emission (TILE_NODE), in ms
+    double created;             /// Emission of the packet, in ms
+    int count;                  /// Links crossed by the packet, or packets left to emit by the node
+    int destination;            /// Global ID of the destination of the packet or of the flow of the node
+} tile_record;
+
+// Single-producer single-consumer ring, followed by its records in the segment
+typedef struct tile_ring {
+    uint64_t head;              /// Next record to read, written by the consumer
+    char pad0[56];
+    uint64_t tail;              /// Next record to write, written by the producer
+    char pad1[56];
+} tile_ring;
+
+// Start of the shared segment, the rings follow at ring_offset
+typedef struct tile_shared {
+    int tile_count;
+    int abort;                  /// Set by a failing worker or by the parent, every wait gives up
+    int barrier_count;
+    int barrier_generation;
+    int ring_capacity;          /// Records per ring
+    size_t ring_offset;
+    size_t ring_stride;
+    double next[MESH_TILE_MAX][2]; /// Earliest pending time of each tile after a window, by window parity
+    double load[MESH_TILE_MAX][TILE_BINS]; /// Load histogram of each tile over its strip
+    mesh_tile_stats stats[MESH_TILE_MAX];
+} tile_shared;
+
+// A node held by a worker, owned or from the halo
+typedef struct tile_node {
+    int id;                     /// Global ID
+    float x, y;
+    int destination;            /// Global ID of the destination of its flow, -1 without flow
+    int packets_left;
+    double next_inject;         /// Time of the next emission, in ms
+} tile_node;
+
+typedef struct tile_packet {
+    int destination;            /// Global ID of the destination node
+    float dest_x, dest_y;       /// Position of the destination
+    int node;                   /// Local index of the node the packet is at (TILE_ARRIVE)
+    int hops;
+    double created;
+    double enqueued;
+    int next;                   /// Next packet in the link queue or in the free list, -1 at the end
+} tile_packet;
+
+typedef struct tile_link {
+    int queue_head;
+    int queue_tail;
+    int queue_length;
+    int sending;                /// Packet being serialized, -1 when the link is idle
+} tile_link;
+
+// Routers of the whole mesh, copied in every worker, bucketed to find the nearest one
+typedef struct tile_routers {
+    int count;
+    float* x;
+    float* y;
+    float cell_size;
+    int cols, rows;
+    int* start;                 /// First router of each cell, cols * rows + 1 entries
+    int* id;                    /// Router of each entry
+} tile_routers;
+
+// State of one worker process
+typedef struct tile_worker {
+    tile_shared* shared;
+    const mesh_config* config;
+    int index;
+    int count;
+    float boundary[MESH_TILE_MAX + 1]; /// Strip of tile t is [boundary[t], boundary[t + 1])
+    tile_routers routers;
+    float gateway_x, gateway_y; /// Position of the last node, the destination without routers
+
+    tile_node* owned;           /// Owned nodes, by increasing ID once built
+    int owned_count;
+    int owned_capacity;
+    tile_node* halo;
+    int halo_count;
+    int halo_capacity;
+    tile_record* inbox;         /// Records read from the rings and not consumed yet
+    int inbox_count;
+    int inbox_capacity;
+    tile_record* pending;       /// Packets waiting for the mesh to be built
+    int pending_count;
+    int pending_capacity;
+
+    mesh* m;                    /// Owned nodes then halo nodes, NULL without owned nodes
+    mesh_csr* csr;
+    float* x;                   /// Position of each local node, global coordinates
+    float* y;
+    long* load;                 /// Events of each owned node since the last rebalance check
+    tile_link* links;
+    tile_packet* packets;
+    int packet_capacity;
+    int free_packet;
+    mesh_calendar queue;
+    double window_end;
+    double sent_min;            /// Earliest arrival handed to a neighbor during the window
+
+    mesh_tile_stats stats;
+    struct timespec mark;
+} tile_worker;
+
+
+static double tile_ms_since(struct timespec* mark) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    double ms = (now.tv_sec - mark->tv_sec) * 1e3 + (now.tv_nsec - mark->tv_nsec) * 1e-6;
+    *mark = now;
+    return ms;
+}
+
+static int tile_grow(void** array, int* capacity, int needed, size_t size) {
+    if (needed <= *capacity) {
+        return 0;
+    }
+    int grown = *capacity ? *capacity : 256;
+    while (grown < needed) grown *= 2;
+    void* p = realloc(*array, size * grown);
+    if (!p) {
+        return -1;
+    }
+    *array = p;
+    *capacity = grown;
+    return 0;
+}
+
+static tile_ring* tile_ring_at(tile_shared* s, int ring) {
+    return (tile_ring*)((char*)s + s->ring_offset + s->ring_stride * ring);
+}
+
+static tile_record* tile_ring_records(tile_ring* r) {
+    return (tile_record*)(r + 1);
+}
+
+// Rings are numbered by producer, 2 t to the left neighbor of tile t and 2 t + 1 to its right neighbor
+static int tile_drain(tile_worker* w) {
+    tile_shared* s = w->shared;
+    for (int side = 0; side < 2; side++) {
+        int from = side == 0 ? w->index - 1 : w->index + 1;
+        if (from < 0 || from >= w->count) continue;
+        tile_ring* r = tile_ring_at(s, 2 * from + (side == 0 ? 1 : 0));
+        uint64_t head = r->head;
+        uint64_t tail = __atomic_load_n(&r->tail, __ATOMIC_ACQUIRE);
+        if (head == tail) continue;
+        if (tile_grow((void**)&w->inbox, &w->inbox_capacity, w->inbox_count + (int)(tail - head), sizeof(tile_record)) != 0) {
+            return -1;
+        }
+        for (; head < tail; head++) {
+            w->inbox[w->inbox_count++] = tile_ring_records(r)[head % s->ring_capacity];
+        }
+        __atomic_store_n(&r->head, head, __ATOMIC_RELEASE);
+    }
+    return 0;
+}
+
+// Waits for room when the ring is full, reading the own rings meanwhile so two producers never wait on each other
+static int tile_send(tile_worker* w, int to, const tile_record* record) {
+    tile_shared* s = w->shared;
+    if (to == w->index) {
+        if (tile_grow((void**)&w->inbox, &w->inbox_capacity, w->inbox_count + 1, sizeof(tile_record)) != 0) {
+            return -1;
+        }
+        w->inbox[w->inbox_count++] = *record;
+        return 0;
+    }
+    tile_ring* r = tile_ring_at(s, 2 * w->index + (to > w->index ? 1 : 0));
+    uint64_t tail = r->tail;
+    while (tail - __atomic_load_n(&r->head, __ATOMIC_ACQUIRE) >= (uint64_t)s->ring_capacity) {
+        if (__atomic_load_n(&s->abort, __ATOMIC_RELAXED) || tile_drain(w) != 0) {
+            return -1;
+        }
+        sched_yield();
+    }
+    tile_ring_records(r)[tail % s->ring_capacity] = *record;
+    __atomic_store_n(&r->tail, tail + 1, __ATOMIC_RELEASE);
+    return 0;
+}
+
+// Sense-reversing barrier over the segment, waiting workers keep reading their rings
+static int tile_barrier(tile_worker* w) {
+    tile_shared* s = w->shared;
+    w->stats.busy_ms += tile_ms_since(&w->mark);
+    int generation = __atomic_load_n(&s->barrier_generation, __ATOMIC_ACQUIRE);
+    if (__atomic_add_fetch(&s->barrier_count, 1, __ATOMIC_ACQ_REL) == w->count) {
+        __atomic_store_n(&s->barrier_count, 0, __ATOMIC_RELAXED);
+        __atomic_add_fetch(&s->barrier_generation, 1, __ATOMIC_RELEASE);
+    } else {
+        while (__atomic_load_n(&s->barrier_generation, __ATOMIC_ACQUIRE) == generation) {
+            if (__atomic_load_n(&s->abort, __ATOMIC_RELAXED) || tile_drain(w) != 0) {
+                return -1;
+            }
+            sched_yield();
+        }
+    }
+    int status = tile_drain(w);
+    w->stats.wait_ms += tile_ms_since(&w->mark);
+    return status;
+}
+
+static int tile_owner(const tile_worker* w, float x) {
+    int t = w->index;
+    while (t > 0 && x < w->boundary[t]) t--;
+    while (t < w->count - 1 && x >= w->boundary[t + 1]) t++;
+    return t;
+}
+
+static int tile_routers_build(tile_routers* r, const mesh_config* config) {
+    r->count = config->router_count < config->node_count ? config->router_count : config->node_count;
+    if (r->count <= 0) {
+        r->count = 0;
+        return 0;
+    }
+    float size_x = config->size_x >= 1.0f ? config->size_x : 1.0f;
+    float size_y = config->size_y >= 1.0f ? config->size_y : 1.0f;
+    r->cell_size = sqrtf(size_x * size_y / r->count);
+    r->cols = (int)ceilf(size_x / r->cell_size);
+    r->rows = (int)ceilf(size_y / r->cell_size);
+    int cells = r->cols * r->rows;
+    r->x = (float*)malloc(sizeof(float) * r->count);
+    r->y = (float*)malloc(sizeof(float) * r->count);
+    r->id = (int*)malloc(sizeof(int) * r->count);
+    r->start = (int*)calloc((size_t)cells + 1, sizeof(int));
+    if (!r->x || !r->y || !r->id || !r->start) {
+        return -1;
+    }
+    int* cell = r->id; // Cell of each router until the ids are sorted in
+    for (int i = 0; i < r->count; i++) {
+        mesh_place_position(config, i, &r->x[i], &r->y[i]);
+        int cx = (int)(r->x[i] / r->cell_size), cy = (int)(r->y[i] / r->cell_size);
+        cell[i] = (cy < r->rows ? cy : r->rows - 1) * r->cols + (cx < r->cols ? cx : r->cols - 1);
+        r->start[cell[i] + 1]++;
+    }
+    for (int c = 0; c < cells; c++) r->start[c + 1] += r->start[c];
+    int* fill = (int*)malloc(sizeof(int) * cells);
+    if (!fill) {
+        return -1;
+    }
+    memcpy(fill, r->start, sizeof(int) * cells);
+    int* order = (int*)malloc(sizeof(int) * r->count);
+    if (!order) {
+        free(fill);
+        return -1;
+    }
+    for (int i = 0; i < r->count; i++) order[fill[cell[i]]++] = i;
+    memcpy(r->id, order, sizeof(int) * r->count);
+    free(order);
+    free(fill);
+    return 0;
+}
+
+static void tile_routers_free(tile_routers* r) {
+    free(r->x);
+    free(r->y);
+    free(r->id);
+    free(r->start);
+}
+
+// Rings of cells around the point until the best router is closer than the next ring
+static int tile_nearest_router(const tile_routers* r, float x, float y) {
+    int cx = (int)(x / r->cell_size), cy = (int)(y / r->cell_size);
+    if (cx >= r->cols) cx = r->cols - 1;
+    if (cy >= r->rows) cy = r->rows - 1;
+    int best = -1;
+    float best_d2 = INFINITY;
+    int reach = r->cols > r->rows ? r->cols : r->rows;
+    for (int ring = 0; ring <= reach; ring++) {
+        float inner = (ring - 1) * r->cell_size;
+        if (best >= 0 && inner > 0.0f && inner * inner > best_d2) break;
+        for (int gy = cy - ring; gy <= cy + ring; gy++) {
+            if (gy < 0 || gy >= r->rows) continue;
+            bool edge_row = gy == cy - ring || gy == cy + ring;
+            for (int gx = cx - ring; gx <= cx + ring; gx += edge_row ? 1 : 2 * ring) {
+                if (gx >= 0 && gx < r->cols) {
+                    for (int k = r->start[gy * r->cols + gx]; k < r->start[gy * r->cols + gx + 1]; k++) {
+                        int i = r->id[k];
+                        float dx = r->x[i] - x, dy = r->y[i] - y;
+                        if (dx * dx + dy * dy < best_d2 || (dx * dx + dy * dy == best_d2 && i < best)) {
+                            best_d2 = dx * dx + dy * dy;
+                            best = i;
+                        }
+                    }
+                }
+                if (ring == 0) break;
+            }
+        }
+    }
+    return best;
+}
+
+static void tile_destination_position(const tile_worker* w, int destination, float* x, float* y) {
+    if (destination < w->routers.count) {
+        *x = w->routers.x[destination];
+        *y = w->routers.y[destination];
+    } else {
+        *x = w->gateway_x;
+        *y = w->gateway_y;
+    }
+}
+
+// Owned nodes in the first strips, found by placing every node of the mesh without storing it
+static int tile_generate(tile_worker* w) {
+    const mesh_config* c = w->config;
+    for (int i = 0; i < c->node_count; i++) {
+        float x, y;
+        mesh_place_position(c, i, &x, &y);
+        if (x < w->boundary[w->index] || (x >= w->boundary[w->index + 1] && w->index < w->count - 1)) continue;
+        if (tile_grow((void**)&w->owned, &w->owned_capacity, w->owned_count + 1, sizeof(tile_node)) != 0) {
+            return -1;
+        }
+        tile_node* node = &w->owned[w->owned_count++];
+        node->id = i;
+        node->x = x;
+        node->y = y;
+        node->destination = w->routers.count > 0 ? tile_nearest_router(&w->routers, x, y) : c->node_count - 1;
+        node->packets_left = node->destination != i ? c->sim_flow_packets : 0;
+        // First emissions spread over one interval, in step they would pile up in one calendar day
+        node->next_inject = c->sim_flow_interval * i / c->node_count;
+    }
+    return 0;
+}
+
+static int tile_node_compare(const void* a, const void* b) {
+    return ((const tile_node*)a)->id - ((const tile_node*)b)->id;
+}
+
+static int tile_local_index(const tile_worker* w, int id) {
+    int lo = 0, hi = w->owned_count - 1;
+    while (lo <= hi) {
+        int mid = (lo + hi) / 2;
+        if (w->owned[mid].id == id) return mid;
+        if (w->owned[mid].id < id) lo = mid + 1;
+        else hi = mid - 1;
+    }
+    return -1;
+}
+
+static int tile_alloc_packet(tile_worker* w) {
+    if (w->free_packet < 0) {
+        int capacity = w->packet_capacity ? w->packet_capacity * 2 : 1024;
+        tile_packet* packets = (tile_packet*)realloc(w->packets, sizeof(tile_packet) * capacity);
+        if (!packets) {
+            return -1;
+        }
+        for (int i = w->packet_capacity; i < capacity; i++) {
+            packets[i].next = i + 1 < capacity ? i + 1 : -1;
+        }
+        w->packets = packets;
+        w->free_packet = w->packet_capacity;
+        w->packet_capacity = capacity;
+    }
+    int p = w->free_packet;
+    w->free_packet = w->packets[p].next;
+    w->packets[p].next = -1;
+    return p;
+}
+
+static void tile_free_packet(tile_worker* w, int p) {
+    w->packets[p].next = w->free_packet;
+    w->free_packet = p;
+}
+
+static void tile_drop(tile_worker* w, int p) {
+    w->stats.dropped++;
+    tile_free_packet(w, p);
+}
+
+static int tile_transmit(tile_worker* w, int link, int p) {
+    float bandwidth = w->m->links[link].bandwidth;
+    double serialization = bandwidth > 0.0f ? w->config->sim_packet_size * 8.0 / (bandwidth * 1000.0) : 0.0; // Mbps to bits per ms
+    w->links[link].sending = p;
+    return mesh_calendar_push(&w->queue, w->queue.now + serialization, TILE_LINK_DONE, link);
+}
+
+// Delivers a packet at its destination or hands it to the link towards the neighbor closest to it
+static int tile_forward(tile_worker* w, int p, int u) {
+    tile_packet* packet = &w->packets[p];
+    if (w->owned[u].id == packet->destination) {
+        w->stats.delivered++;
+        w->stats.latency += w->queue.now - packet->created;
+        tile_free_packet(w, p);
+        return 0;
+    }
+    float dx = w->x[u] - packet->dest_x, dy = w->y[u] - packet->dest_y;
+    float best_d2 = dx * dx + dy * dy;
+    int link = -1;
+    for (int e = w->csr->out_offset[u]; e < w->csr->out_offset[u] + w->csr->out_degree[u]; e++) {
+        int v = w->csr->out_target[e];
+        dx = w->x[v] - packet->dest_x;
+        dy = w->y[v] - packet->dest_y;
+        if (dx * dx + dy * dy < best_d2) {
+            best_d2 = dx * dx + dy * dy;
+            link = w->csr->out_link[e];
+        }
+    }
+    if (link < 0) {
+        w->stats.dead_ends++;
+        tile_drop(w, p);
+        return 0;
+    }
+    tile_link* l = &w->links[link];
+    if (l->sending < 0) {
+        return tile_transmit(w, link, p);
+    }
+    if (l->queue_length >= w->config->sim_queue_limit) {
+        tile_drop(w, p);
+        return 0;
+    }
+    packet->enqueued = w->queue.now;
+    packet->next = -1;
+    if (l->queue_head < 0) l->queue_head = p;
+    else w->packets[l->queue_tail].next = p;
+    l->queue_tail = p;
+    l->queue_length++;
+    return 0;
+}
+
+static int tile_inject(tile_worker* w, int u) {
+    tile_node* node = &w->owned[u];
+    int p = tile_alloc_packet(w);
+    if (p < 0) {
+        return -1;
+    }
+    tile_packet* packet = &w->packets[p];
+    packet->destination = node->destination;
+    tile_destination_position(w, node->destination, &packet->dest_x, &packet->dest_y);
+    packet->hops = 0;
+    packet->created = w->queue.now;
+    w->stats.sent++;
+    if (--node->packets_left > 0) {
+        node->next_inject = w->queue.now + w->config->sim_flow_interval;
+        if (mesh_calendar_push(&w->queue, node->next_inject, TILE_INJECT, u) != 0) {
+            return -1;
+        }
+    }
+    return tile_forward(w, p, u);
+}
+
+static tile_record tile_packet_record(const tile_worker* w, const tile_packet* packet, int local, double time) {
+    tile_record r = { TILE_PACKET, 0, w->x[local], w->y[local], time, packet->created, packet->hops, packet->destination };
+    r.node = local < w->owned_count ? w->owned[local].id : w->halo[local - w->owned_count].id;
+    return r;
+}
+
+// The packet reaches the far end of the link after its latency, in the strip or in a neighbor one
+static int tile_link_done(tile_worker* w, int link) {
+    tile_link* l = &w->links[link];
+    int p = l->sending;
+    l->sending = -1;
+    tile_packet* packet = &w->packets[p];
+    packet->hops++;
+    int v = w->m->links[link].destination_id;
+    double arrival = w->queue.now + w->m->links[link].latency;
+    if (v < w->owned_count) {
+        packet->node = v;
+        if (mesh_calendar_push(&w->queue, arrival, TILE_ARRIVE, p) != 0) {
+            return -1;
+        }
+    } else {
+        // Lookahead: a packet leaving the strip arrives at the end of the window at the earliest
+        if (arrival < w->window_end) arrival = w->window_end;
+        tile_record r = tile_packet_record(w, packet, v, arrival);
+        if (tile_send(w, tile_owner(w, r.x), &r) != 0) {
+            return -1;
+        }
+        if (arrival < w->sent_min) w->sent_min = arrival;
+        w->stats.handed_over++;
+        tile_free_packet(w, p);
+    }
+    if (l->queue_head < 0) {
+        return 0;
+    }
+    int next = l->queue_head;
+    l->queue_head = w->packets[next].next;
+    l->queue_length--;
+    return tile_transmit(w, link, next);
+}
+
+// Packets handed over by the neighbors, and those kept through a rebuild
+static int tile_push_packets(tile_worker* w, const tile_record* records, int count) {
+    for (int i = 0; i < count; i++) {
+        const tile_record* r = &records[i];
+        int u = tile_local_index(w, r->node);
+        if (u < 0 || !w->m) {
+            w->stats.dropped++; // Not owned any more, cannot happen while boundaries move one strip at a time
+            continue;
+        }
+        int p = tile_alloc_packet(w);
+        if (p < 0) {
+            return -1;
+        }
+        tile_packet* packet = &w->packets[p];
+        packet->destination = r->destination;
+        tile_destination_position(w, r->destination, &packet->dest_x, &packet->dest_y);
+        packet->node = u;
+        packet->hops = r->count;
+        packet->created = r->created;
+        if (mesh_calendar_push(&w->queue, r->time, TILE_ARRIVE, p) != 0) {
+            return -1;
+        }
+    }
+    return 0;
+}
+
+// Moves the inbox records of one type to the end of an array, NULL to push packets into the queue
+static int tile_take(tile_worker* w, int type, tile_record** to, int* count, int* capacity) {
+    int kept = 0;
+    int status = 0;
+    for (int i = 0; i < w->inbox_count; i++) {
+        tile_record* r = &w->inbox[i];
+        if (r->type != type) {
+            w->inbox[kept++] = *r;
+        } else if (!to) {
+            if (status == 0) status = tile_push_packets(w, r, 1);
+        } else if (status == 0 && tile_grow((void**)to, capacity, *count + 1, sizeof(tile_record)) == 0) {
+            (*to)[(*count)++] = *r;
+        } else {
+            status = -1;
+        }
+    }
+    w->inbox_count = kept;
+    return status;
+}
+
+static int tile_take_nodes(tile_worker* w, int type) {
+    tile_record* records = NULL;
+    int count = 0, capacity = 0;
+    if (tile_take(w, type, &records, &count, &capacity) != 0) {
+        free(records);
+        return -1;
+    }
+    tile_node** nodes = type == TILE_NODE ? &w->owned : &w->halo;
+    int* node_count = type == TILE_NODE ? &w->owned_count : &w->halo_count;
+    int* node_capacity = type == TILE_NODE ? &w->owned_capacity : &w->halo_capacity;
+    if (tile_grow((void**)nodes, node_capacity, *node_count + count, sizeof(tile_node)) != 0) {
+        free(records);
+        return -1;
+    }
+    for (int i = 0; i < count; i++) {
+        tile_node* node = &(*nodes)[(*node_count)++];
+        node->id = records[i].node;
+        node->x = records[i].x;
+        node->y = records[i].y;
+        node->destination = records[i].destination;
+        node->packets_left = records[i].count;
+        node->next_inject = records[i].time;
+    }
+    free(records);
+    return 0;
+}
+
+static void tile_release(tile_worker* w) {
+    if (w->m) free_mesh(w->m);
+    w->m = NULL;
+    w->csr = NULL;
+    free(w->x);
+    free(w->y);
+    free(w->load);
+    free(w->links);
+    free(w->packets);
+    mesh_calendar_free(&w->queue);
+    w->x = w->y = NULL;
+    w->load = NULL;
+    w->links = NULL;
+    w->packets = NULL;
+    w->packet_capacity = 0;
+    w->free_packet = -1;
+}
+
+// Sends the halo to the neighbors, then links the owned and halo nodes in a mesh of their own and restarts
+// the flows and the packets from their records
+static int tile_build(tile_worker* w) {
+    const mesh_config* c = w->config;
+    float range = c->max_link_distance;
+    float x0 = w->boundary[w->index], x1 = w->boundary[w->index + 1];
+    for (int i = 0; i < w->owned_count; i++) {
+        tile_node* node = &w->owned[i];
+        tile_record r = { TILE_HALO, node->id, node->x, node->y, 0.0, 0.0, 0, -1 };
+        if (w->index > 0 && node->x - x0 <= range && tile_send(w, w->index - 1, &r) != 0) return -1;
+        if (w->index < w->count - 1 && x1 - node->x <= range && tile_send(w, w->index + 1, &r) != 0) return -1;
+    }
+    w->halo_count = 0;
+    if (tile_barrier(w) != 0 || tile_take_nodes(w, TILE_HALO) != 0) {
+        return -1;
+    }
+    if (tile_take(w, TILE_PACKET, &w->pending, &w->pending_count, &w->pending_capacity) != 0) {
+        return -1;
+    }
+    if (w->owned_count > 0) qsort(w->owned, w->owned_count, sizeof(tile_node), tile_node_compare);
+    if (w->halo_count > 0) qsort(w->halo, w->halo_count, sizeof(tile_node), tile_node_compare);
+    w->stats.nodes = w->owned_count;
+    w->stats.halo = w->halo_count;
+    w->stats.links = 0;
+    if (mesh_calendar_init(&w->queue, c->tile_tick) != 0) {
+        return -1;
+    }
+    if (w->owned_count == 0) {
+        w->stats.dropped += w->pending_count;
+        w->pending_count = 0;
+        return 0;
+    }
+
+    // Local coordinates start at the left edge of the halo, the area then only covers the strip and its halo
+    int local = w->owned_count + w->halo_count;
+    float origin = x0 - range > 0.0f ? x0 - range : 0.0f;
+    mesh_config local_config = *c;
+    local_config.node_count = local;
+    local_config.size_x = fminf(c->size_x, x1 + range) - origin;
+    local_config.threads = 1;
+    w->x = (float*)malloc(sizeof(float) * local);
+    w->y = (float*)malloc(sizeof(float) * local);
+    w->load = (long*)calloc(w->owned_count, sizeof(long));
+    float* lx = (float*)malloc(sizeof(float) * local);
+    int* ids = (int*)malloc(sizeof(int) * local);
+    if (!w->x || !w->y || !w->load || !lx || !ids) {
+        free(lx);
+        free(ids);
+        return -1;
+    }
+    for (int i = 0; i < local; i++) {
+        const tile_node* node = i < w->owned_count ? &w->owned[i] : &w->halo[i - w->owned_count];
+        w->x[i] = node->x;
+        w->y[i] = node->y;
+        lx[i] = node->x - origin;
+        ids[i] = node->id;
+    }
+    char name[64];
+    snprintf(name, sizeof(name), "Tile%d", w->index);
+    w->m = init_mesh(name, &local_config);
+    int status = w->m && mesh_place_nodes_at(w->m, lx, w->y, ids) == 0 && mesh_build_topology(w->m, c->topology, c->topology_neighbors) >= 0 ? 0 : -1;
+    free(lx);
+    free(ids);
+    w->csr = status == 0 ? mesh_get_csr(w->m) : NULL;
+    if (!w->csr) {
+        return -1;
+    }
+    w->stats.links = 0;
+    for (int i = 0; i < w->owned_count; i++) w->stats.links += w->csr->out_degree[i];
+
+    w->links = (tile_link*)malloc(sizeof(tile_link) * (w->m->link_count > 0 ? w->m->link_count : 1));
+    if (!w->links) {
+        return -1;
+    }
+    for (int i = 0; i < w->m->link_count; i++) {
+        w->links[i].queue_head = -1;
+        w->links[i].queue_tail = -1;
+        w->links[i].queue_length = 0;
+        w->links[i].sending = -1;
+    }
+    for (int i = 0; i < w->owned_count; i++) {
+        if (w->owned[i].packets_left > 0 && mesh_calendar_push(&w->queue, w->owned[i].next_inject, TILE_INJECT, i) != 0) {
+            return -1;
+        }
+    }
+    status = tile_push_packets(w, w->pending, w->pending_count);
+    w->pending_count = 0;
+    return status;
+}
+
+// Runs the events of the window [start, end), returns the earliest time left in the strip or sent to a neighbor
+static int tile_window(tile_worker* w, double end, double* next) {
+    w->window_end = end;
+    w->sent_min = INFINITY;
+    if (tile_take(w, TILE_PACKET, NULL, NULL, NULL) != 0) {
+        return -1;
+    }
+    double time;
+    while (mesh_calendar_peek(&w->queue, &time) && time < end) {
+        mesh_event e;
+        mesh_calendar_pop(&w->queue, &e);
+        int status = 0;
+        switch (e.type) {
+            case TILE_INJECT:
+                w->load[e.data]++;
+                status = tile_inject(w, e.data);
+                break;
+            case TILE_LINK_DONE:
+                w->load[w->m->links[e.data].source_id]++;
+                status = tile_link_done(w, e.data);
+                break;
+            case TILE_ARRIVE:
+                w->load[w->packets[e.data].node]++;
+                status = tile_forward(w, e.data, w->packets[e.data].node);
+                break;
+        }
+        if (status != 0) {
+            return -1;
+        }
+        w->stats.events++;
+    }
+    *next = w->sent_min;
+    if (mesh_calendar_peek(&w->queue, &time) && time < *next) *next = time;
+    return 0;
+}
+
+// Every worker computes the same boundaries from the same histograms. Each boundary goes to its quantile of the
+// load, kept between the old neighboring boundaries and at least the link distance from the new ones.
+static bool tile_balance(const tile_worker* w, float* boundary) {
+    const tile_shared* s = w->shared;
+    double total = 0.0, busiest = 0.0;
+    for (int t = 0; t < w->count; t++) {
+        double sum = 0.0;
+        for (int b = 0; b < TILE_BINS; b++) sum += s->load[t][b];
+        total += sum;
+        if (sum > busiest) busiest = sum;
+    }
+    double mean = total / w->count;
+    if (total <= 0.0 || busiest <= (1.0 + MESH_TILE_IMBALANCE) * mean) {
+        return false;
+    }
+    float range = w->config->max_link_distance;
+    float size_x = w->boundary[w->count];
+    boundary[0] = 0.0f;
+    boundary[w->count] = size_x;
+    int t = 0, b = 0;
+    double before = 0.0; // Load left of bin b of tile t
+    bool moved = false;
+    for (int j = 1; j < w->count; j++) {
+        double target = mean * j;
+        while (t < w->count && before + s->load[t][b] < target) {
+            before += s->load[t][b];
+            if (++b == TILE_BINS) {
+                b = 0;
+                t++;
+            }
+        }
+        float q = size_x;
+        if (t < w->count) {
+            float width = (w->boundary[t + 1] - w->boundary[t]) / TILE_BINS;
+            double in_bin = s->load[t][b] > 0.0 ? (target - before) / s->load[t][b] : 0.0;
+            q = w->boundary[t] + width * (b + (float)in_bin);
+        }
+        float lo = fmaxf(w->boundary[j - 1], boundary[j - 1] + range);
+        float hi = fminf(w->boundary[j + 1], size_x - (w->count - j) * range);
+        boundary[j] = fminf(fmaxf(q, lo), hi);
+        if (boundary[j] != w->boundary[j]) moved = true;
+    }
+    return moved;
+}
+
+// Publishes the load of the strip, and when the tiles are unbalanced hands the nodes outside the new strip
+// and every pending packet to their new owners before building again
+static int tile_rebalance(tile_worker* w) {
+    tile_shared* s = w->shared;
+    float x0 = w->boundary[w->index], width = (w->boundary[w->index + 1] - x0) / TILE_BINS;
+    double* load = s->load[w->index];
+    for (int b = 0; b < TILE_BINS; b++) load[b] = 0.0;
+    for (int i = 0; i < w->owned_count; i++) {
+        int b = width > 0.0f ? (int)((w->owned[i].x - x0) / width) : 0;
+        if (b < 0) b = 0;
+        if (b >= TILE_BINS) b = TILE_BINS - 1;
+        load[b] += 1.0 + (w->load ? (double)w->load[i] : 0.0);
+        if (w->load) w->load[i] = 0;
+    }
+    if (tile_barrier(w) != 0) {
+        return -1;
+    }
+    float boundary[MESH_TILE_MAX + 1];
+    if (!tile_balance(w, boundary)) {
+        return 0;
+    }
+
+    // Packets waiting in the queues start again from the node they wait at, those on the wire from the node they
+    // reach, first at the current owner of that node: a halo node may lie two strips away once the boundaries move
+    tile_record record;
+    if (w->m) {
+        for (int l = 0; l < w->m->link_count; l++) {
+            for (int p = w->links[l].queue_head; p >= 0; p = w->packets[p].next) {
+                record = tile_packet_record(w, &w->packets[p], w->m->links[l].source_id, w->window_end);
+                if (tile_send(w, w->index, &record) != 0) return -1;
+            }
+        }
+    }
+    mesh_event e;
+    while (mesh_calendar_pop(&w->queue, &e)) {
+        if (e.type == TILE_LINK_DONE) {
+            tile_packet* packet = &w->packets[w->links[e.data].sending];
+            packet->hops++;
+            record = tile_packet_record(w, packet, w->m->links[e.data].destination_id, e.time + w->m->links[e.data].latency);
+        } else if (e.type == TILE_ARRIVE) {
+            record = tile_packet_record(w, &w->packets[e.data], w->packets[e.data].node, e.time);
+        } else {
+            continue; // Emissions move with their node
+        }
+        if (tile_send(w, tile_owner(w, record.x), &record) != 0) return -1;
+    }
+    tile_release(w);
+    if (tile_barrier(w) != 0) {
+        return -1;
+    }
+
+    // Then nodes and packets go from the old strips to the new ones, which are at most one strip away
+    memcpy(w->boundary, boundary, sizeof(float) * (w->count + 1));
+    int kept = 0;
+    for (int i = 0; i < w->owned_count; i++) {
+        tile_node* node = &w->owned[i];
+        int owner = tile_owner(w, node->x);
+        if (owner == w->index) {
+            w->owned[kept++] = *node;
+            continue;
+        }
+        record = (tile_record){ TILE_NODE, node->id, node->x, node->y, node->next_inject, 0.0, node->packets_left, node->destination };
+        if (tile_send(w, owner, &record) != 0) return -1;
+        w->stats.migrated++;
+    }
+    w->owned_count = kept;
+    int count = w->inbox_count;
+    kept = 0;
+    for (int i = 0; i < count; i++) {
+        record = w->inbox[i];
+        int owner = tile_owner(w, record.x);
+        if (record.type == TILE_PACKET && owner != w->index) {
+            if (tile_send(w, owner, &record) != 0) return -1;
+        } else {
+            w->inbox[kept++] = record;
+        }
+    }
+    // Records drained while sending were appended after the ones just sorted
+    memmove(w->inbox + kept, w->inbox + count, sizeof(tile_record) * (w->inbox_count - count));
+    w->inbox_count = kept + w->inbox_count - count;
+    if (tile_barrier(w) != 0 || tile_take_nodes(w, TILE_NODE) != 0) {
+        return -1;
+    }
+    w->stats.rebalances++;
+    return tile_build(w);
+}
+
+static int tile_main(tile_shared* shared, const mesh_config* config, int index) {
+    tile_worker w;
+    memset(&w, 0, sizeof(w));
+    w.shared = shared;
+    w.config = config;
+    w.index = index;
+    w.count = shared->tile_count;
+    w.free_packet = -1;
+    clock_gettime(CLOCK_MONOTONIC, &w.mark);
+    float size_x = config->size_x >= 1.0f ? config->size_x : 1.0f;
+    for (int t = 0; t <= w.count; t++) w.boundary[t] = size_x * t / w.count;
+    w.boundary[w.count] = size_x;
+    mesh_place_position(config, config->node_count - 1, &w.gateway_x, &w.gateway_y);
+
+    int status = tile_routers_build(&w.routers, config) == 0 && tile_generate(&w) == 0 && tile_build(&w) == 0 ? 0 : -1;
+    long tick = 0, checked = -1;
+    int parity = 0;
+    while (status == 0) {
+        if (config->tile_rebalance > 0 && (checked < 0 || tick / config->tile_rebalance != checked / config->tile_rebalance)) {
+            checked = tick;
+            if (tile_rebalance(&w) != 0) {
+                status = -1;
+                break;
+            }
+        }
+        double next = INFINITY;
+        if (tile_window(&w, (tick + 1) * config->tile_tick, &next) != 0) {
+            status = -1;
+            break;
+        }
+        w.stats.ticks++;
+        shared->next[index][parity] = next;
+        if (tile_barrier(&w) != 0) {
+            status = -1;
+            break;
+        }
+        // Same decision in every worker: stop when nothing is pending anywhere, else skip the empty windows
+        double earliest = INFINITY;
+        for (int t = 0; t < w.count; t++) {
+            if (shared->next[t][parity] < earliest) earliest = shared->next[t][parity];
+        }
+        parity ^= 1;
+        if (earliest == INFINITY) break;
+        long skip = (long)floor(earliest / config->tile_tick);
+        tick = skip > tick + 1 ? skip : tick + 1;
+    }
+
+    w.stats.x0 = w.boundary[index];
+    w.stats.x1 = w.boundary[index + 1];
+    w.stats.busy_ms += tile_ms_since(&w.mark);
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    w.stats.peak_rss_kb = usage.ru_maxrss;
+    w.stats.status = status;
+    shared->stats[index] = w.stats;
+    if (status != 0) {
+        __atomic_store_n(&shared->abort, 1, __ATOMIC_RELAXED);
+    }
+    tile_release(&w);
+    tile_routers_free(&w.routers);
+    free(w.owned);
+    free(w.halo);
+    free(w.inbox);
+    free(w.pending);
+    return status;
+}
+
+static int tile_write_stats(const tile_shared* shared, const char* filename) {
+    FILE* file = fopen(filename, "w");
+    if (!file) {
+        return -1;
+    }
+    fprintf(file, "Tile,X0,X1,Nodes,Halo,Links,Events,Sent,Delivered,Dropped,DeadEnds,AvgLatency,HandedOver,Migrated,Rebalances,Ticks,BusyMs,WaitMs,PeakRssKB\n");
+    for (int t = 0; t < shared->tile_count; t++) {
+        const mesh_tile_stats* s = &shared->stats[t];
+        fprintf(file, "%d,%.3f,%.3f,%d,%d,%d,%ld,%ld,%ld,%ld,%ld,%.4f,%ld,%ld,%d,%ld,%.1f,%.1f,%ld\n", t, s->x0, s->x1, s->nodes, s->halo,
+                s->links, s->events, s->sent, s->delivered, s->dropped, s->dead_ends, s->delivered > 0 ? s->latency / s->delivered : 0.0,
+                s->handed_over, s->migrated, s->rebalances, s->ticks, s->busy_ms, s->wait_ms, s->peak_rss_kb);
+    }
+    fclose(file);
+    return 0;
+}
+
+int mesh_tile_run(const mesh_config* config, const char* filename) {
+    int count = config->tile_count;
+    float size_x = config->size_x >= 1.0f ? config->size_x : 1.0f;
+    if (count < 1 || count > MESH_TILE_MAX) {
+        fprintf(stderr, "mesh_tile_run: between 1 and %d tiles\n", MESH_TILE_MAX);
+        return -1;
+    }
+    if (count > 1 && size_x < count * config->max_link_distance) {
+        fprintf(stderr, "mesh_tile_run: %d strips of %g m are narrower than the link distance of %g m\n", count, size_x / count, config->max_link_distance);
+        return -1;
+    }
+    if (config->topology != MESH_TOPOLOGY_UNIT_DISK && config->topology != MESH_TOPOLOGY_GABRIEL && config->topology != MESH_TOPOLOGY_RNG) {
+        fprintf(stderr, "mesh_tile_run: the topology must be unit_disk, gabriel or rng\n");
+        return -1;
+    }
+
+    // The segment is unlinked as soon as it is mapped, the workers inherit the mapping and nothing is left behind
+    char name[64];
+    snprintf(name, sizeof(name), "/mesh_tiles_%ld", (long)getpid());
+    size_t ring_offset = (sizeof(tile_shared) + 63) & ~(size_t)63;
+    size_t ring_stride = sizeof(tile_ring) + sizeof(tile_record) * MESH_TILE_RING_RECORDS;
+    size_t size = ring_offset + ring_stride * 2 * count;
+    int fd = shm_open(name, O_CREAT | O_EXCL | O_RDWR, 0600);
+    if (fd < 0) {
+        perror("mesh_tile_run: shm_open");
+        return -1;
+    }
+    tile_shared* shared = ftruncate(fd, (off_t)size) == 0 ? (tile_shared*)mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0) : MAP_FAILED;
+    shm_unlink(name);
+    close(fd);
+    if (shared == MAP_FAILED) {
+        perror("mesh_tile_run: shared memory");
+        return -1;
+    }
+    memset(shared, 0, sizeof(tile_shared)); // The rest of a new segment reads as zeros
+    shared->tile_count = count;
+    shared->ring_capacity = MESH_TILE_RING_RECORDS;
+    shared->ring_offset = ring_offset;
+    shared->ring_stride = ring_stride;
+    for (int t = 0; t < count; t++) shared->stats[t].status = -1;
+
+    fflush(NULL); // Buffered output would be written again by every worker
+    int started = 0;
+    for (; started < count; started++) {
+        pid_t pid = fork();
+        if (pid == 0) {
+            _exit(tile_main(shared, config, started) == 0 ? 0 : 1);
+        }
+        if (pid < 0) {
+            perror("mesh_tile_run: fork");
+            __atomic_store_n(&shared->abort, 1, __ATOMIC_RELAXED);
+            break;
+        }
+    }
+    int status = started == count ? 0 : -1;
+    for (int i = 0; i < started; i++) {
+        int code;
+        if (wait(&code) < 0) break;
+        if (!WIFEXITED(code) || WEXITSTATUS(code) != 0) {
+            __atomic_store_n(&shared->abort, 1, __ATOMIC_RELAXED); // The others would wait for it forever
+            status = -1;
+        }
+    }
+    if (status == 0 && tile_write_stats(shared, filename) != 0) {
+        status = -1;
+    }
+    if (status != 0) {
+        fprintf(stderr, "mesh_tile_run: a worker failed\n");
+    }
+    munmap(shared, size);
+    return status;
+}
@@ -0,0 +1,50 @@
+#pragma once
+
+#include "mesh_config.h"
+
+#define MESH_TILE_MAX 64 // Worker processes of a tiled simulation
+
+typedef struct mesh_tile_stats mesh_tile_stats;
+
+
+/// @brief Counters of one tile, written by its worker into the shared segment when the run ends.
+struct mesh_tile_stats{
+    float x0, x1;               /// Strip owned at the end, in meters
+    int nodes;                  /// Nodes owned at the end
+    int halo;                   /// Nodes of the neighbors within the max link distance of the strip
+    int links;                  /// Links leaving the owned nodes
+    long events;                /// Events processed
+    long sent;                  /// Packets emitted by the owned nodes
+    long delivered;             /// Packets that reached their destination in the tile
+    long dropped;               /// Packets dropped in the tile, by full queues or dead ends
+    long dead_ends;             /// Packets dropped at a node with no neighbor closer to the destination
+    double latency;             /// Sum of the end to end delays of the delivered packets, in ms
+    long handed_over;           /// Packets passed to a neighbor tile through a ring
+    long migrated;              /// Nodes given to a neighbor when the boundaries moved
+    int rebalances;             /// Number of boundary moves
+    long ticks;                 /// Number of synchronized windows
+    double busy_ms;             /// Wall time spent simulating and building, in ms
+    double wait_ms;             /// Wall time spent waiting for the other tiles, in ms
+    long peak_rss_kb;           /// Peak resident memory of the worker
+    int status;                 /// 0 once the worker finished, -1 on failure
+};
+
+
+///@brief Simulates the traffic of a mesh split into vertical strips, one worker process per strip, so that the mesh
+/// can outgrow the memory and cores of one process. Each worker finds its nodes from mesh_place_position(), holds
+/// them in a mesh of its own with copies of the neighbor nodes within the max link distance (the halo), and links
+/// them with the topology of the configuration, which must be unit_disk, gabriel or rng: those only depend on
+/// nodes within range, so every worker builds the same links the whole mesh would have.
+/// Every node streams to its nearest router (node IDs below router_count), or to the last node without routers,
+/// with the packet count, interval and size of the configuration, the first packets spread over one interval. Packets are forwarded greedily to the neighbor
+/// closest to their destination, through link queues timed as in mesh_sim.h, and dropped at dead ends.
+/// Workers advance in lockstep windows of tile_tick ms. Packets crossing a strip boundary travel through
+/// single-producer rings in a POSIX shared-memory segment and arrive no earlier than the end of the window, which
+/// is the lookahead that lets every strip run its window alone. Every tile_rebalance ticks, the boundaries move
+/// towards equal loads (nodes plus their recent events) when the busiest strip exceeds the mean by
+/// MESH_TILE_IMBALANCE, at most one strip at a time so nodes and their pending packets only move to neighbors.
+///@param config The parameters of the mesh and the simulation, at most MESH_TILE_MAX tiles of at least
+/// max_link_distance each.
+///@param filename The path of the CSV file receiving the counters of every tile.
+///@return int 0 on success, -1 on a bad configuration or if a worker failed, reported on stderr.
+int mesh_tile_run(const mesh_config* config, const char* filename);
@@ -0,0 +1,683 @@
+#include <limits.h>
+#include "mesh_compute.h"
+
+#define TOPOLOGY_EDGE_STACK 1024 // Pending flips, only exceeded on extremely degenerate input
+#define TOPOLOGY_KNN_BATCH 64 // Fewest nearest nodes offered per scan of a kNN search radius
+
+// Undirected pairs waiting to be linked, malloc'ed
+typedef struct topology_edges {
+    int* pairs;
+    int count;
+    int capacity;
+} topology_edges;
+
+// Triangulation state. Triangle t holds the halfedges 3t, 3t + 1 and 3t + 2 in counterclockwise order,
+// halfedge e starts at vertex[e] and its twin in the neighbor triangle is twin[e], -1 on the hull.
+typedef struct topology_delaunay {
+    const float* x;
+    const float* y;
+    int* vertex;
+    int* twin;
+    int halfedge_count;
+    int* hull_prev;             /// Hull neighbors of each node, counterclockwise order
+    int* hull_next;
+    int* hull_tri;              /// Halfedge along the hull from each hull node to its next
+    int* hash;                  /// Hull nodes by pseudo-angle around the center, to start the visibility walk
+    int hash_size;
+    int hull_start;
+    double cx, cy;              /// Center of the sweep
+    int* duplicate;             /// Node at the same position as each skipped node, -1 otherwise
+    int stack[TOPOLOGY_EDGE_STACK];
+} topology_delaunay;
+
+typedef struct topology_key {
+    double dist;
+    int id;
+} topology_key;
+
+// Nodes bucketed by cells of about one node spacing, positions copied in cell order. The mesh grid is
+// sized for the link range, far too coarse for the lunes of the short Delaunay pairs.
+typedef struct topology_buckets {
+    float cell_size;
+    int cols, rows;
+    int* start;                 /// First entry of each cell, cols * rows + 1 entries
+    int* id;                    /// Node of each entry
+    float* x;                   /// Position of each entry
+    float* y;
+} topology_buckets;
+
+static int topology_push(topology_edges* edges, int u, int v) {
+    if (edges->count == edges->capacity) {
+        int capacity = edges->capacity ? edges->capacity * 2 : 1024;
+        int* pairs = (int*)realloc(edges->pairs, sizeof(int) * 2 * (size_t)capacity);
+        if (!pairs) {
+            return -1;
+        }
+        edges->pairs = pairs;
+        edges->capacity = capacity;
+    }
+    edges->pairs[2 * edges->count] = u;
+    edges->pairs[2 * edges->count + 1] = v;
+    edges->count++;
+    return 0;
+}
+
+// Grows the link array once for a known number of links, instead of doubling through the arena
+static int topology_reserve(mesh* m, int count) {
+    if (m->link_count + count <= m->link_capacity) {
+        return 0;
+    }
+    int capacity = m->link_count + count;
+    mesh_link* links = (mesh_link*)mesh_arena_realloc(&m->arena, m->links, sizeof(mesh_link) * m->link_capacity, sizeof(mesh_link) * capacity);
+    if (!links) {
+        return -1;
+    }
+    m->links = links;
+    m->link_capacity = capacity;
+    return 0;
+}
+
+static float topology_dist2(const mesh* m, int a, int b) {
+    float dx = m->soa.x[a] - m->soa.x[b];
+    float dy = m->soa.y[a] - m->soa.y[b];
+    return dx * dx + dy * dy;
+}
+
+static int topology_cell(float v, float cell_size, int cells) {
+    int c = (int)(v / cell_size);
+    if (c < 0) return 0;
+    if (c >= cells) return cells - 1;
+    return c;
+}
+
+static double delaunay_cross(const topology_delaunay* d, int a, int b, int p) {
+    double ax = d->x[a], ay = d->y[a];
+    return ((double)d->x[b] - ax) * ((double)d->y[p] - ay) - ((double)d->y[b] - ay) * ((double)d->x[p] - ax);
+}
+
+// Edge a -> b of the counterclockwise hull faces p
+static bool delaunay_visible(const topology_delaunay* d, int p, int a, int b) {
+    return delaunay_cross(d, a, b, p) < 0.0;
+}
+
+// Positive when p lies inside the circumcircle of the counterclockwise triangle a, b, c
+static double delaunay_in_circle(const topology_delaunay* d, int a, int b, int c, int p) {
+    double px = d->x[p], py = d->y[p];
+    double dx = d->x[a] - px, dy = d->y[a] - py;
+    double ex = d->x[b] - px, ey = d->y[b] - py;
+    double fx = d->x[c] - px, fy = d->y[c] - py;
+    double ap = dx * dx + dy * dy;
+    double bp = ex * ex + ey * ey;
+    double cp = fx * fx + fy * fy;
+    return dx * (ey * cp - bp * fy) - dy * (ex * cp - bp * fx) + ap * (ex * fy - ey * fx);
+}
+
+// Squared circumradius of a, b, c, infinite when they are aligned. Writes the center when asked.
+static double delaunay_circumradius(const topology_delaunay* d, int a, int b, int c, double* cx, double* cy) {
+    double ax = d->x[a], ay = d->y[a];
+    double dx = d->x[b] - ax, dy = d->y[b] - ay;
+    double ex = d->x[c] - ax, ey = d->y[c] - ay;
+    double bl = dx * dx + dy * dy;
+    double cl = ex * ex + ey * ey;
+    double det = dx * ey - dy * ex;
+    if (det == 0.0) {
+        return INFINITY;
+    }
+    double x = (ey * bl - dy * cl) * 0.5 / det;
+    double y = (dx * cl - ex * bl) * 0.5 / det;
+    if (cx) *cx = ax + x;
+    if (cy) *cy = ay + y;
+    return x * x + y * y;
+}
+
+// Monotonic in the angle around the center, counterclockwise from the west, in [0, 1]
+static int delaunay_hash_key(const topology_delaunay* d, int i) {
+    double dx = d->x[i] - d->cx;
+    double dy = d->y[i] - d->cy;
+    double sum = fabs(dx) + fabs(dy);
+    double p = sum > 0.0 ? dx / sum : 0.0;
+    double angle = (dy > 0.0 ? 3.0 - p : 1.0 + p) / 4.0;
+    return (int)floor(angle * d->hash_size) % d->hash_size;
+}
+
+static void delaunay_link(topology_delaunay* d, int a, int b) {
+    d->twin[a] = b;
+    if (b >= 0) d->twin[b] = a;
+}
+
+static int delaunay_add_triangle(topology_delaunay* d, int i0, int i1, int i2, int a, int b, int c) {
+    int t = d->halfedge_count;
+    d->vertex[t] = i0;
+    d->vertex[t + 1] = i1;
+    d->vertex[t + 2] = i2;
+    delaunay_link(d, t, a);
+    delaunay_link(d, t + 1, b);
+    delaunay_link(d, t + 2, c);
+    d->halfedge_count += 3;
+    return t;
+}
+
+// Flips the edges around a new triangle until every pair of triangles is locally Delaunay.
+// Returns the halfedge that ends up in the place of the one before a, the hull edge of the new node.
+static int delaunay_legalize(topology_delaunay* d, int a) {
+    int depth = 0;
+    int ar = 0;
+    for (;;) {
+        int b = d->twin[a];
+        int a0 = a - a % 3;
+        ar = a0 + (a + 2) % 3;
+        if (b < 0) {
+            if (depth == 0) break;
+            a = d->stack[--depth];
+            continue;
+        }
+        int b0 = b - b % 3;
+        int al = a0 + (a + 1) % 3;
+        int bl = b0 + (b + 2) % 3;
+        int p0 = d->vertex[ar];
+        int pr = d->vertex[a];
+        int pl = d->vertex[al];
+        int p1 = d->vertex[bl];
+        if (delaunay_in_circle(d, p0, pr, pl, p1) > 0.0) {
+            d->vertex[a] = p1;
+            d->vertex[b] = p0;
+            int hbl = d->twin[bl];
+            if (hbl < 0) {
+                // The flipped edge was on the hull on the other side, move the hull reference
+                int e = d->hull_start;
+                do {
+                    if (d->hull_tri[e] == bl) {
+                        d->hull_tri[e] = a;
+                        break;
+                    }
+                    e = d->hull_prev[e];
+                } while (e != d->hull_start);
+            }
+            delaunay_link(d, a, hbl);
+            delaunay_link(d, b, d->twin[ar]);
+            delaunay_link(d, ar, bl);
+            if (depth < TOPOLOGY_EDGE_STACK) {
+                d->stack[depth++] = b0 + (b + 1) % 3;
+            }
+        } else {
+            if (depth == 0) break;
+            a = d->stack[--depth];
+        }
+    }
+    return ar;
+}
+
+static int delaunay_key_compare(const void* a, const void* b) {
+    const topology_key* x = (const topology_key*)a;
+    const topology_key* y = (const topology_key*)b;
+    if (x->dist != y->dist) return x->dist < y->dist ? -1 : 1;
+    return x->id - y->id;
+}
+
+static void delaunay_free(topology_delaunay* d) {
+    free(d->vertex);
+    free(d->twin);
+    free(d->hull_prev);
+    free(d->hull_next);
+    free(d->hull_tri);
+    free(d->hash);
+    free(d->duplicate);
+}
+
+// Sweeps the nodes by distance to the circumcenter of a small seed triangle, adding each to the visible
+// edges of the hull. Aligned nodes leave no triangle, their Delaunay edges are then pushed by the caller.
+static int delaunay_build(topology_delaunay* d, int n, topology_key* keys) {
+    int triangles = n > 2 ? 2 * n - 5 : 0;
+    d->vertex = (int*)malloc(sizeof(int) * 3 * (size_t)(triangles > 0 ? triangles : 1));
+    d->twin = (int*)malloc(sizeof(int) * 3 * (size_t)(triangles > 0 ? triangles : 1));
+    d->hull_prev = (int*)malloc(sizeof(int) * n);
+    d->hull_next = (int*)malloc(sizeof(int) * n);
+    d->hull_tri = (int*)malloc(sizeof(int) * n);
+    d->hash_size = (int)ceil(sqrt((double)n)) + 1;
+    d->hash = (int*)malloc(sizeof(int) * d->hash_size);
+    d->duplicate = (int*)malloc(sizeof(int) * n);
+    if (!d->vertex || !d->twin || !d->hull_prev || !d->hull_next || !d->hull_tri || !d->hash || !d->duplicate) {
+        return -1;
+    }
+    memset(d->duplicate, -1, sizeof(int) * n);
+    d->halfedge_count = 0;
+
+    // Seed: the node nearest the middle, its nearest node, and the node closing the smallest circle
+    float min_x = INFINITY, min_y = INFINITY, max_x = -INFINITY, max_y = -INFINITY;
+    for (int i = 0; i < n; i++) {
+        if (d->x[i] < min_x) min_x = d->x[i];
+        if (d->y[i] < min_y) min_y = d->y[i];
+        if (d->x[i] > max_x) max_x = d->x[i];
+        if (d->y[i] > max_y) max_y = d->y[i];
+    }
+    double mx = 0.5 * ((double)min_x + max_x), my = 0.5 * ((double)min_y + max_y);
+    int i0 = 0, i1 = -1, i2 = -1;
+    double best = INFINITY;
+    for (int i = 0; i < n; i++) {
+        double dx = d->x[i] - mx, dy = d->y[i] - my;
+        if (dx * dx + dy * dy < best) { best = dx * dx + dy * dy; i0 = i; }
+    }
+    best = INFINITY;
+    for (int i = 0; i < n; i++) {
+        double dx = d->x[i] - d->x[i0], dy = d->y[i] - d->y[i0];
+        double dist = dx * dx + dy * dy;
+        if (i != i0 && dist > 0.0 && dist < best) { best = dist; i1 = i; }
+    }
+    best = INFINITY;
+    for (int i = 0; i < n && i1 >= 0; i++) {
+        if (i == i0 || i == i1) continue;
+        double r = delaunay_circumradius(d, i0, i1, i, NULL, NULL);
+        if (r < best) { best = r; i2 = i; }
+    }
+    if (best == INFINITY) {
+        return 0;
+    }
+    if (delaunay_cross(d, i0, i1, i2) < 0.0) {
+        int swap = i1;
+        i1 = i2;
+        i2 = swap;
+    }
+    delaunay_circumradius(d, i0, i1, i2, &d->cx, &d->cy);
+
+    for (int i = 0; i < n; i++) {
+        double dx = d->x[i] - d->cx, dy = d->y[i] - d->cy;
+        keys[i].dist = dx * dx + dy * dy;
+        keys[i].id = i;
+    }
+    qsort(keys, n, sizeof(topology_key), delaunay_key_compare);
+
+    d->hull_start = i0;
+    d->hull_next[i0] = d->hull_prev[i2] = i1;
+    d->hull_next[i1] = d->hull_prev[i0] = i2;
+    d->hull_next[i2] = d->hull_prev[i1] = i0;
+    d->hull_tri[i0] = 0;
+    d->hull_tri[i1] = 1;
+    d->hull_tri[i2] = 2;
+    memset(d->hash, -1, sizeof(int) * d->hash_size);
+    d->hash[delaunay_hash_key(d, i0)] = i0;
+    d->hash[delaunay_hash_key(d, i1)] = i1;
+    d->hash[delaunay_hash_key(d, i2)] = i2;
+    delaunay_add_triangle(d, i0, i1, i2, -1, -1, -1);
+
+    int previous = -1;
+    for (int k = 0; k < n; k++) {
+        int i = keys[k].id;
+        // Same position as the node before, which has the same distance to the center
+        if (previous >= 0 && d->x[i] == d->x[previous] && d->y[i] == d->y[previous]) {
+            d->duplicate[i] = previous;
+            continue;
+        }
+        previous = i;
+        if (i == i0 || i == i1 || i == i2) continue;
+
+        int start = 0;
+        int key = delaunay_hash_key(d, i);
+        for (int j = 0; j < d->hash_size; j++) {
+            start = d->hash[(key + j) % d->hash_size];
+            if (start >= 0 && start != d->hull_next[start]) break;
+        }
+        start = d->hull_prev[start];
+        int e = start;
+        int q = d->hull_next[e];
+        while (!delaunay_visible(d, i, e, q)) {
+            e = q;
+            if (e == start) {
+                e = -1;
+                break;
+            }
+            q = d->hull_next[e];
+        }
+        if (e < 0) continue; // On the hull within rounding, left out
+
+        int t = delaunay_add_triangle(d, e, i, d->hull_next[e], -1, -1, d->hull_tri[e]);
+        d->hull_tri[i] = delaunay_legalize(d, t + 2);
+        d->hull_tri[e] = t;
+
+        // The hull edges after e that also face i are covered by fans of new triangles
+        int next = d->hull_next[e];
+        for (q = d->hull_next[next]; delaunay_visible(d, i, next, q); q = d->hull_next[next]) {
+            t = delaunay_add_triangle(d, next, i, q, d->hull_tri[i], -1, d->hull_tri[next]);
+            d->hull_tri[i] = delaunay_legalize(d, t + 2);
+            d->hull_next[next] = next; // Off the hull
+            next = q;
+        }
+        // and so are those before it when the walk started right on a visible edge
+        if (e == start) {
+            for (q = d->hull_prev[e]; delaunay_visible(d, i, q, e); q = d->hull_prev[e]) {
+                t = delaunay_add_triangle(d, q, i, e, -1, d->hull_tri[e], d->hull_tri[q]);
+                delaunay_legalize(d, t + 2);
+                d->hull_tri[q] = t;
+                d->hull_next[e] = e;
+                e = q;
+            }
+        }
+        d->hull_start = d->hull_prev[i] = e;
+        d->hull_next[e] = d->hull_prev[next] = i;
+        d->hull_next[i] = next;
+        d->hash[delaunay_hash_key(d, i)] = i;
+        d->hash[delaunay_hash_key(d, e)] = e;
+    }
+    return 0;
+}
+
+// Every node on one line: the Delaunay pairs are the neighbors along it
+static int delaunay_aligned_edges(const topology_delaunay* d, int n, topology_key* keys, topology_edges* edges) {
+    int first = 0;
+    for (int i = 1; i < n; i++) {
+        if (d->x[i] != d->x[first] || d->y[i] != d->y[first]) {
+            first = i;
+            break;
+        }
+    }
+    double ux = (double)d->x[first] - d->x[0], uy = (double)d->y[first] - d->y[0];
+    for (int i = 0; i < n; i++) {
+        keys[i].dist = ((double)d->x[i] - d->x[0]) * ux + ((double)d->y[i] - d->y[0]) * uy;
+        keys[i].id = i;
+    }
+    qsort(keys, n, sizeof(topology_key), delaunay_key_compare);
+    for (int k = 1; k < n; k++) {
+        if (topology_push(edges, keys[k - 1].id, keys[k].id) != 0) {
+            return -1;
+        }
+    }
+    return 0;
+}
+
+// A Delaunay pair whose opposite nodes both see it under an acute angle
+static bool delaunay_gabriel(const topology_delaunay* d, int e) {
+    int u = d->vertex[e];
+    int v = d->vertex[e % 3 == 2 ? e - 2 : e + 1];
+    for (int side = 0; side < 2; side++) {
+        int h = side == 0 ? e : d->twin[e];
+        if (h < 0) continue;
+        int w = d->vertex[h % 3 == 0 ? h + 2 : h - 1];
+        double dot = ((double)d->x[u] - d->x[w]) * ((double)d->x[v] - d->x[w]) + ((double)d->y[u] - d->y[w]) * ((double)d->y[v] - d->y[w]);
+        if (dot <= 0.0) return false;
+    }
+    return true;
+}
+
+static void topology_buckets_free(topology_buckets* b) {
+    free(b->start);
+    free(b->id);
+    free(b->x);
+    free(b->y);
+}
+
+static int topology_buckets_build(mesh* m, topology_buckets* b) {
+    int n = m->node_count;
+    b->cell_size = sqrtf(m->size_x * m->size_y / (float)(n > 0 ? n : 1));
+    if (b->cell_size <= 0.0f) b->cell_size = 1.0f;
+    b->cols = (int)ceilf(m->size_x / b->cell_size);
+    b->rows = (int)ceilf(m->size_y / b->cell_size);
+    if (b->cols < 1) b->cols = 1;
+    if (b->rows < 1) b->rows = 1;
+    int cells = b->cols * b->rows;
+    b->start = (int*)calloc((size_t)cells + 1, sizeof(int));
+    b->id = (int*)malloc(sizeof(int) * (n > 0 ? n : 1));
+    b->x = (float*)malloc(sizeof(float) * (n > 0 ? n : 1));
+    b->y = (float*)malloc(sizeof(float) * (n > 0 ? n : 1));
+    if (!b->start || !b->id || !b->x || !b->y) {
+        return -1;
+    }
+    // Counting sort by cell
+    for (int i = 0; i < n; i++) {
+        b->start[topology_cell(m->soa.y[i], b->cell_size, b->rows) * b->cols + topology_cell(m->soa.x[i], b->cell_size, b->cols) + 1]++;
+    }
+    for (int c = 0; c < cells; c++) b->start[c + 1] += b->start[c];
+    for (int i = 0; i < n; i++) {
+        int c = topology_cell(m->soa.y[i], b->cell_size, b->rows) * b->cols + topology_cell(m->soa.x[i], b->cell_size, b->cols);
+        int k = b->start[c]++;
+        b->id[k] = i;
+        b->x[k] = m->soa.x[i];
+        b->y[k] = m->soa.y[i];
+    }
+    for (int c = cells; c > 0; c--) b->start[c] = b->start[c - 1];
+    b->start[0] = 0;
+    return 0;
+}
+
+// No node strictly closer to both u and v than they are to each other, checked over the cells of the lune
+static bool topology_lune_empty(mesh* m, const topology_buckets* b, int u, int v) {
+    float ux = m->soa.x[u], uy = m->soa.y[u];
+    float vx = m->soa.x[v], vy = m->soa.y[v];
+    float length2 = topology_dist2(m, u, v);
+    float reach = sqrtf(length2);
+    int cx0 = topology_cell(fmaxf(ux, vx) - reach, b->cell_size, b->cols), cx1 = topology_cell(fminf(ux, vx) + reach, b->cell_size, b->cols);
+    int cy0 = topology_cell(fmaxf(uy, vy) - reach, b->cell_size, b->rows), cy1 = topology_cell(fminf(uy, vy) + reach, b->cell_size, b->rows);
+    for (int cy = cy0; cy <= cy1; cy++) {
+        for (int k = b->start[cy * b->cols + cx0]; k < b->start[cy * b->cols + cx1 + 1]; k++) {
+            float dux = ux - b->x[k], duy = uy - b->y[k];
+            float dvx = vx - b->x[k], dvy = vy - b->y[k];
+            if (dux * dux + duy * duy < length2 && dvx * dvx + dvy * dvy < length2 && b->id[k] != u && b->id[k] != v) return false;
+        }
+    }
+    return true;
+}
+
+static int topology_delaunay_pairs(mesh* m, mesh_topology topology, topology_edges* edges) {
+    int n = m->node_count;
+    topology_delaunay d;
+    memset(&d, 0, sizeof(d));
+    d.x = m->soa.x;
+    d.y = m->soa.y;
+    topology_key* keys = (topology_key*)malloc(sizeof(topology_key) * (n > 0 ? n : 1));
+    topology_edges all = {0};
+    int status = keys && delaunay_build(&d, n, keys) == 0 ? 0 : -1;
+    if (status == 0 && d.halfedge_count == 0) {
+        status = n > 1 ? delaunay_aligned_edges(&d, n, keys, &all) : 0;
+    } else if (status == 0) {
+        // Gabriel pairs, also the candidates of the relative neighborhood graph which is a subgraph of them
+        for (int e = 0; e < d.halfedge_count && status == 0; e++) {
+            if (d.twin[e] > e || !delaunay_gabriel(&d, e)) continue;
+            status = topology_push(&all, d.vertex[e], d.vertex[e % 3 == 2 ? e - 2 : e + 1]);
+        }
+        for (int i = 0; i < n && status == 0; i++) {
+            if (d.duplicate[i] >= 0) status = topology_push(&all, d.duplicate[i], i);
+        }
+    }
+    delaunay_free(&d);
+    free(keys);
+
+    // Radio range, then the lune of the relative neighborhood graph
+    topology_buckets buckets = {0};
+    if (status == 0 && topology == MESH_TOPOLOGY_RNG) {
+        status = topology_buckets_build(m, &buckets);
+    }
+    float range2 = m->config.max_link_distance * m->config.max_link_distance;
+    for (int i = 0; i < all.count && status == 0; i++) {
+        int u = all.pairs[2 * i];
+        int v = all.pairs[2 * i + 1];
+        if (topology_dist2(m, u, v) > range2) continue;
+        if (topology == MESH_TOPOLOGY_RNG && !topology_lune_empty(m, &buckets, u, v)) continue;
+        status = topology_push(edges, u, v);
+    }
+    topology_buckets_free(&buckets);
+    free(all.pairs);
+    return status;
+}
+
+static int topology_unit_disk_node(mesh* m, int u, topology_edges* edges) {
+    const mesh_grid* g = &m->grid;
+    float range = m->config.max_link_distance;
+    float range2 = range * range;
+    float x = m->soa.x[u], y = m->soa.y[u];
+    int cx0 = topology_cell(x - range, g->cell_size, g->cols), cx1 = topology_cell(x + range, g->cell_size, g->cols);
+    int cy0 = topology_cell(y - range, g->cell_size, g->rows), cy1 = topology_cell(y + range, g->cell_size, g->rows);
+    for (int cy = cy0; cy <= cy1; cy++) {
+        for (int cx = cx0; cx <= cx1; cx++) {
+            for (int v = g->cell_head[cy * g->cols + cx]; v >= 0; v = g->next[v]) {
+                if (v <= u || topology_dist2(m, u, v) > range2) continue;
+                if (topology_push(edges, u, v) != 0) {
+                    return -1;
+                }
+            }
+        }
+    }
+    return 0;
+}
+
+// Nodes are visited cell by cell, so that neighbors scan the same cells while they are still cached
+static int topology_unit_disk_pairs(mesh* m, topology_edges* edges) {
+    const mesh_grid* g = &m->grid;
+    for (int cell = 0; cell < g->cols * g->rows; cell++) {
+        for (int u = g->cell_head[cell]; u >= 0; u = g->next[u]) {
+            if (topology_unit_disk_node(m, u, edges) != 0) {
+                return -1;
+            }
+        }
+    }
+    return 0;
+}
+
+// Keeps the smallest keys in a max-heap of a given capacity, the farthest kept key at the root
+static void topology_heap_offer(topology_key* heap, int* count, int capacity, topology_key key) {
+    int i;
+    if (*count < capacity) {
+        // Sift up from a new leaf
+        for (i = (*count)++; i > 0 && delaunay_key_compare(&heap[(i - 1) / 2], &key) < 0; i = (i - 1) / 2) {
+            heap[i] = heap[(i - 1) / 2];
+        }
+        heap[i] = key;
+        return;
+    }
+    if (delaunay_key_compare(&key, &heap[0]) >= 0) {
+        return;
+    }
+    // Sift down from the root, which the new key replaces
+    for (i = 0;;) {
+        int child = 2 * i + 1;
+        if (child >= *count) break;
+        if (child + 1 < *count && delaunay_key_compare(&heap[child + 1], &heap[child]) > 0) child++;
+        if (delaunay_key_compare(&heap[child], &key) <= 0) break;
+        heap[i] = heap[child];
+        i = child;
+    }
+    heap[i] = key;
+}
+
+// Nearest candidates first, the search radius doubles from two bucket sizes until the node is full. Candidates are
+// offered in (distance, ID) order, a batch per scan: when a radius holds more than the batch, the nearest are
+// offered and the same radius is scanned again past the last one offered.
+static int topology_knn_node(mesh* m, const topology_buckets* b, int u, int neighbors, topology_key* keys) {
+    float range = m->config.max_link_distance;
+    float x = m->soa.x[u], y = m->soa.y[u];
+    int linked = 0;
+    topology_key tried = { -1.0, 0 }; // Every key up to this one was offered
+    float radius = fminf(2.0f * b->cell_size, range);
+    while (linked < neighbors && m->soa.output_link_count[u] < m->soa.max_output_links) {
+        float radius2 = radius * radius;
+        int cx0 = topology_cell(x - radius, b->cell_size, b->cols), cx1 = topology_cell(x + radius, b->cell_size, b->cols);
+        int cy0 = topology_cell(y - radius, b->cell_size, b->rows), cy1 = topology_cell(y + radius, b->cell_size, b->rows);
+        int count = 0;
+        int capacity = neighbors - linked > TOPOLOGY_KNN_BATCH ? neighbors - linked : TOPOLOGY_KNN_BATCH;
+        bool full = false;
+        for (int cy = cy0; cy <= cy1; cy++) {
+            int end = b->start[cy * b->cols + cx1 + 1];
+            for (int k = b->start[cy * b->cols + cx0]; k < end; k++) {
+                float dx = x - b->x[k], dy = y - b->y[k];
+                topology_key key = { dx * dx + dy * dy, b->id[k] };
+                if (key.dist > radius2 || key.id == u || delaunay_key_compare(&key, &tried) <= 0) continue;
+                if (count == capacity) full = true;
+                topology_heap_offer(keys, &count, capacity, key);
+            }
+        }
+        qsort(keys, count, sizeof(topology_key), delaunay_key_compare);
+        for (int i = 0; i < count && linked < neighbors; i++) {
+            if (!mesh_link_allowed(m, &m->nodes[u], &m->nodes[keys[i].id])) continue;
+            if (init_mesh_link(m, m->next_link_id, &m->nodes[u], &m->nodes[keys[i].id]) < 0) {
+                return -1;
+            }
+            linked++;
+        }
+        if (full) {
+            tried = keys[count - 1];
+            continue;
+        }
+        if (radius >= range) break;
+        tried.dist = radius2;
+        tried.id = INT_MAX;
+        radius = fminf(2.0f * radius, range);
+    }
+    return 0;
+}
+
+static int topology_knn(mesh* m, int neighbors) {
+    topology_buckets buckets = {0};
+    topology_key* keys = (topology_key*)malloc(sizeof(topology_key) * (neighbors > TOPOLOGY_KNN_BATCH ? neighbors : TOPOLOGY_KNN_BATCH));
+    int status = keys && topology_reserve(m, m->node_count * neighbors) == 0 ? topology_buckets_build(m, &buckets) : -1;
+    // In bucket order, like the unit-disk pairs
+    for (int k = 0; k < m->node_count && status == 0; k++) {
+        status = topology_knn_node(m, &buckets, buckets.id[k], neighbors, keys);
+    }
+    topology_buckets_free(&buckets);
+    free(keys);
+    return status == 0 ? m->link_count : -1;
+}
+
+// Candidates of each node as the grid lists them, see mesh_link_candidates() and mesh_form_links()
+static int topology_capped_disk(mesh* m) {
+    int capacity = 256;
+    int* ids = (int*)malloc(sizeof(int) * capacity);
+    int status = ids ? 0 : -1;
+    for (int i = 0; i < m->node_count && status == 0; i++) {
+        int count = mesh_link_candidates(m, i, ids, capacity);
+        if (count > capacity) {
+            int* grown = (int*)realloc(ids, sizeof(int) * (size_t)count);
+            if (!grown) {
+                status = -1;
+                break;
+            }
+            ids = grown;
+            capacity = count;
+            count = mesh_link_candidates(m, i, ids, capacity);
+        }
+        if (mesh_form_links(m, i, ids, count) < 0) {
+            status = -1;
+        }
+    }
+    free(ids);
+    return status == 0 ? m->link_count : -1;
+}
+
+static int topology_chain(mesh* m) {
+    for (int i = 0; i < m->node_count - 2; i++) {
+        if (mesh_link_allowed(m, &m->nodes[i], &m->nodes[i + 1])) {
+            if (init_mesh_link(m, m->next_link_id, &m->nodes[i], &m->nodes[i + 1]) < 0) return -1;
+        }
+        if (mesh_link_allowed(m, &m->nodes[i], &m->nodes[i + 2])) {
+            if (init_mesh_link(m, m->next_link_id, &m->nodes[i], &m->nodes[i + 2]) < 0) return -1;
+        }
+    }
+    return m->link_count;
+}
+
+int mesh_build_topology(mesh* m, mesh_topology topology, int neighbors) {
+    MESH_TIMED(MESH_TIME_TOPOLOGY);
+    if (m->link_count > 0) {
+        return -1;
+    }
+    if (topology == MESH_TOPOLOGY_CHAIN) {
+        return topology_chain(m);
+    }
+    if (topology == MESH_TOPOLOGY_KNN) {
+        return topology_knn(m, neighbors > 0 ? neighbors : m->config.max_output_links);
+    }
+    if (topology == MESH_TOPOLOGY_CAPPED_DISK) {
+        return topology_capped_disk(m);
+    }
+    topology_edges edges = {0};
+    int status = topology == MESH_TOPOLOGY_UNIT_DISK ? topology_unit_disk_pairs(m, &edges) : topology_delaunay_pairs(m, topology, &edges);
+    if (status == 0 && edges.count > 0) {
+        status = topology_reserve(m, 2 * edges.count);
+    }
+    for (int i = 0; i < edges.count && status == 0; i++) {
+        mesh_node* u = &m->nodes[edges.pairs[2 * i]];
+        mesh_node* v = &m->nodes[edges.pairs[2 * i + 1]];
+        if (init_mesh_link(m, m->next_link_id, u, v) < 0 || init_mesh_link(m, m->next_link_id, v, u) < 0) {
+            status = -1;
+        }
+    }
+    free(edges.pairs);
+    return status == 0 ? m->link_count : -1;
+}
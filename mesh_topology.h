@@ -0,0 +1,25 @@
+#pragma once
+
+typedef struct mesh mesh; // Forward declaration
+
+typedef enum mesh_topology {
+    MESH_TOPOLOGY_CHAIN,        /// Node i to i + 1 and i + 2 when mesh_link_allowed(), the historical test topology
+    MESH_TOPOLOGY_UNIT_DISK,    /// Every pair of nodes within the max link distance
+    MESH_TOPOLOGY_GABRIEL,      /// Pairs whose diametral disk holds no other node
+    MESH_TOPOLOGY_RNG,          /// Pairs with no other node closer to both of them (relative neighborhood graph)
+    MESH_TOPOLOGY_KNN,          /// Each node to its nearest neighbors that mesh_link_allowed() accepts
+    MESH_TOPOLOGY_CAPPED_DISK   /// Each node in turn to the nodes within range that mesh_link_allowed() accepts, in grid order
+}mesh_topology;
+
+
+///@brief Links the nodes of a mesh from their positions.
+/// Unit-disk, Gabriel and RNG pairs get a link in each direction, only the max link distance applies to them.
+/// Gabriel and RNG pairs are filtered out of a Delaunay triangulation (sweep-hull with edge flips, after
+/// Sinclair 2010 and Delaunator), in O(n log n), and RNG pairs are checked against the nodes of their lune
+/// through buckets of about one node each. KNN links go out of each node in turn, in grid cell order, nearest first, within the link caps.
+/// Capped-disk links go out of each node in turn to its mesh_link_candidates() through mesh_form_links().
+///@param m A pointer to the mesh structure, which must not have links yet (see reset_mesh()).
+///@param topology The kind of graph to build.
+///@param neighbors Links each node opens with MESH_TOPOLOGY_KNN, 0 for the max output links of the mesh.
+///@return int The number of links created, -1 if the mesh has links or on allocation failure.
+int mesh_build_topology(mesh* m, mesh_topology topology, int neighbors);